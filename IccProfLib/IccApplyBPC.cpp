@@ -231,9 +231,24 @@ bool CIccApplyBPC::CalcFactors(const CIccProfile* pProfile, const CIccXform* pXf
 	}
 
 	icFloatNumber XYZbp[3]; // storage for black point XYZ
+	CIccBlackPointCache *pCache = CIccBlackPointCache::GetGlobal();
+	std::string key;
+	bool bValid;
 
-	// calculate the black point
-	if (!calcBlackPoint(pProfile, pXform, XYZbp)) {
+	// calculate the black point unless it has been calculated before
+	if (!CIccBlackPointCache::GetKey(key, pProfile, pXform)) {
+		if (!calcBlackPoint(pProfile, pXform, XYZbp)) {
+			return false;
+		}
+	}
+	else if (!pCache->Find(key, XYZbp, bValid)) {
+		bValid = calcBlackPoint(pProfile, pXform, XYZbp);
+		pCache->Add(key, XYZbp, bValid);
+		if (!bValid) {
+			return false;
+		}
+	}
+	else if (!bValid) {
 		return false;
 	}
 
@@ -619,3 +634,118 @@ CIccCmm* CIccApplyBPC::getBlackXfm(icRenderingIntent nIntent, const CIccProfile
 
 	return pCmm;
 }
+
+
+//////////////////////////////////////////////////////////////////////
+// CIccBlackPointCache
+//////////////////////////////////////////////////////////////////////
+
+CIccBlackPointCache::CIccBlackPointCache(icUInt32Number nMaxEntries/*=ICC_BLACKPOINT_CACHE_SIZE*/)
+{
+	m_nMaxEntries = nMaxEntries ? nMaxEntries : 1;
+}
+
+/**
+**************************************************************************
+* Name: CIccBlackPointCache::GetKey
+* 
+* Purpose:
+*  Builds the cache key for the black point of a profile as used by a
+*  transform.  The black point transforms never use a PCC so it is not
+*  part of the key.
+* 
+* Return: 
+*  false if the profile has no profile ID or its ID does not match its
+*  contents, in which case the black point is not cached.
+**************************************************************************
+*/
+bool CIccBlackPointCache::GetKey(std::string &key, const CIccProfile *pProfile, const CIccXform *pXform)
+{
+	const icProfileID &id = pProfile->m_Header.profileID;
+
+	if (!pProfile->IsProfileIDValid())
+		return false;
+
+	// the profile ID does not cover these header fields
+	icUInt32Number info[4];
+	info[0] = pProfile->m_Header.flags;
+	info[1] = pProfile->m_Header.renderingIntent;
+	info[2] = pXform->GetIntent();
+	info[3] = pXform->IsInput() ? 1 : 0;
+
+	key.assign((const char*)id.ID8, sizeof(id.ID8));
+	key.append((const char*)info, sizeof(info));
+
+	return true;
+}
+
+/**
+**************************************************************************
+* Name: CIccBlackPointCache::Find
+* 
+* Purpose:
+*  Looks up a black point, bValid is set to whether its calculation
+*  succeeded.
+**************************************************************************
+*/
+bool CIccBlackPointCache::Find(const std::string &key, icFloatNumber *XYZb, bool &bValid)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	auto i = m_Index.find(key);
+	if (i==m_Index.end())
+		return false;
+
+	IccBlackPointList::iterator e = i->second;
+	memcpy(XYZb, e->XYZb, sizeof(e->XYZb));
+	bValid = e->bValid;
+
+	m_Entries.splice(m_Entries.begin(), m_Entries, e);
+
+	return true;
+}
+
+void CIccBlackPointCache::Add(const std::string &key, const icFloatNumber *XYZb, bool bValid)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	// another thread may have calculated it meanwhile
+	if (m_Index.find(key)!=m_Index.end())
+		return;
+
+	IccBlackPointEntry entry;
+	entry.key = key;
+	memcpy(entry.XYZb, XYZb, sizeof(entry.XYZb));
+	entry.bValid = bValid;
+
+	m_Entries.push_front(entry);
+	m_Index[key] = m_Entries.begin();
+
+	while (m_Entries.size() > m_nMaxEntries) {
+		m_Index.erase(m_Entries.back().key);
+		m_Entries.pop_back();
+	}
+}
+
+void CIccBlackPointCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	m_Index.clear();
+	m_Entries.clear();
+}
+
+size_t CIccBlackPointCache::GetCount()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	return m_Entries.size();
+}
+
+// returns the process wide cache used by CIccApplyBPC
+CIccBlackPointCache *CIccBlackPointCache::GetGlobal()
+{
+	static CIccBlackPointCache cache;
+
+	return &cache;
+}
@@ -68,6 +68,10 @@ Copyright:  (c) see Software License
 #define _ICCAPPLYBPC_H
 
 #include "IccCmm.h"
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <mutex>
 
 #ifdef USEICCDEVNAMESPACE
 namespace iccDEV {
@@ -123,6 +127,47 @@ private:
 	CIccCmm* getBlackXfm(icRenderingIntent nIntent, const CIccProfile *pProfile) const;
 };
 
+/**
+ **************************************************************************
+ * Type: Class
+ * 
+ * Purpose: Least recently used cache of calculated black points shared by
+ *  all CIccApplyBPC objects.  Entries are keyed by profile ID, rendering
+ *  intent and whether the profile is used as a source or destination.
+ *  Profiles without a profile ID are not cached.  Access is thread safe.
+ **************************************************************************
+*/
+#define ICC_BLACKPOINT_CACHE_SIZE 64
+class ICCPROFLIB_API CIccBlackPointCache
+{
+public:
+	CIccBlackPointCache(icUInt32Number nMaxEntries=ICC_BLACKPOINT_CACHE_SIZE);
+
+	bool Find(const std::string &key, icFloatNumber *XYZb, bool &bValid);
+	void Add(const std::string &key, const icFloatNumber *XYZb, bool bValid);
+
+	void Clear();
+	size_t GetCount();
+
+	static bool GetKey(std::string &key, const CIccProfile *pProfile, const CIccXform *pXform);
+	static CIccBlackPointCache *GetGlobal();
+
+protected:
+	struct IccBlackPointEntry {
+		std::string key;
+		icFloatNumber XYZb[3];
+		bool bValid;
+	};
+	typedef std::list<IccBlackPointEntry> IccBlackPointList;
+
+	//Entries in most recently used order
+	IccBlackPointList m_Entries;
+	std::unordered_map<std::string, IccBlackPointList::iterator> m_Index;
+
+	icUInt32Number m_nMaxEntries;
+	std::mutex m_Mutex;
+};
+
 #ifdef USEICCDEVNAMESPACE
 }; //namespace iccDEV
 #endif
@@ -230,12 +230,20 @@ CIccArrayNamedColor::CIccArrayNamedColor(CIccTagArray *pTagArray)
   m_csDevice = icSigUnknownData;
   m_pZeroTint = NULL;
   m_csSpectralPcs = icSigNoSpectralData;
+
+  m_pPcsIndex = NULL;
+  m_pDeviceIndex = NULL;
+  m_pSpectralIndex = NULL;
 }
 
 
 CIccArrayNamedColor::~CIccArrayNamedColor()
 {
   delete m_list;
+
+  delete m_pPcsIndex;
+  delete m_pDeviceIndex;
+  delete m_pSpectralIndex;
 }
 
 
@@ -284,6 +292,57 @@ void CIccArrayNamedColor::SetColorSpaces(icColorSpaceSignature csPcs, icColorSpa
   m_nSpectralSamples = icGetSpaceSamples((icColorSpaceSignature)m_csSpectralPcs);
 }
 
+//Gets the full tint values of a named color member
+static bool icGetNamedColorValues(icFloatNumber *pDst, const CIccStructNamedColor *pColor,
+                                  icNamedColorlMemberSignature sig, icUInt32Number nSamples)
+{
+  CIccTagNumArray *v = pColor->GetNumArray(sig);
+
+  if (!v || !nSamples)
+    return false;
+
+  icUInt32Number sampleCount = v->GetNumValues()/nSamples;
+  if (!sampleCount)
+    return false;
+
+  return v->GetValues(pDst, (sampleCount-1)*nSamples, nSamples);
+}
+
+bool CIccArrayNamedColor::BuildIndex(CIccNearestIndex *&pIndex, icNamedColorStructVector &colors,
+                                     icNamedColorlMemberSignature sig, icUInt32Number nSamples,
+                                     icUInt32Number nKeyDim/*=0*/)
+{
+  delete pIndex;
+  pIndex = NULL;
+  colors.clear();
+
+  if (!nSamples)
+    return true;
+
+  int i, n=m_pTag->GetSize();
+  icFloatNumber *pPoints = new icFloatNumber[(size_t)n*nSamples];
+  if (!pPoints)
+    return false;
+
+  for (i=1; i<n; i++) {
+    CIccStructNamedColor *pNamedColor = (CIccStructNamedColor*)icGetTagStructHandlerOfType(m_pTag->GetIndex(i), icSigNamedColorStruct);
+    icFloatNumber *pPoint = pPoints + colors.size()*nSamples;
+
+    if (pNamedColor && icGetNamedColorValues(pPoint, pNamedColor, sig, nSamples)) {
+      if (sig==icSigNmclPcsDataMbr && m_csPcs!=icSigLabData)
+        icXYZtoLab(pPoint, pPoint);
+      colors.push_back(pNamedColor);
+    }
+  }
+
+  pIndex = new CIccNearestIndex;
+  bool rv = pIndex->Build(pPoints, (icUInt32Number)colors.size(), nSamples, nKeyDim);
+
+  delete [] pPoints;
+
+  return rv;
+}
+
 bool CIccArrayNamedColor::Begin()
 {
   m_pZeroTint = (CIccStructNamedColor*)icGetTagStructHandlerOfType(m_pTag->GetIndex(0), icSigTintZeroStruct);
@@ -300,6 +359,12 @@ bool CIccArrayNamedColor::Begin()
     }
   }
 
+  if (!BuildIndex(m_pDeviceIndex, m_deviceColors, icSigNmclDeviceDataMbr, m_nDeviceSamples) ||
+      !BuildIndex(m_pPcsIndex, m_pcsColors, icSigNmclPcsDataMbr, m_nPcsSamples==3 ? 3 : 0) ||
+      !BuildIndex(m_pSpectralIndex, m_spectralColors, icSigNmclSpectralDataMbr, m_nSpectralSamples,
+                  ICC_NAMEDCOLOR_SPECTRAL_KEYDIM))
+    return false;
+
   return true;
 }
 
@@ -317,44 +382,23 @@ CIccStructNamedColor* CIccArrayNamedColor::FindColor(const icChar *szColor) cons
 
 CIccStructNamedColor* CIccArrayNamedColor::FindDeviceColor(const icFloatNumber *pDevColor) const
 {
-  icFloatNumber *temp = new icFloatNumber[m_nDeviceSamples];
+  if (!m_pDeviceIndex)
+    return NULL;
 
-  if (!temp)
+  icInt32Number nearest = m_pDeviceIndex->FindNearest(pDevColor);
+  if (nearest<0)
     return NULL;
 
-  icUInt32Number j;
-  icUInt32Number tagSize = m_pTag->GetSize();
-  for (icUInt32Number i=1; i<tagSize; i++) {
-    CIccStructNamedColor *pNamedColor = (CIccStructNamedColor*)icGetTagStructHandlerOfType(m_pTag->GetIndex(i), icSigNamedColorStruct);
-    if (pNamedColor) {
-      CIccTag *pTag = pNamedColor->GetElem(icSigNmclDeviceDataMbr);
-      if (pTag && pTag->IsNumArrayType()) {
-        CIccTagNumArray *v = (CIccTagNumArray*)pTag;
-        icUInt32Number sampleCount = v->GetNumValues()/m_nDeviceSamples;
-        if (sampleCount) {
-          v->GetValues(temp, (sampleCount-1)*m_nDeviceSamples, m_nDeviceSamples);
-
-          for (j=0; j<m_nDeviceSamples; j++) {
-            if (temp[j]!=pDevColor[j])
-              break;
-          }
-          if (sampleCount==m_nDeviceSamples) {
-            delete [] temp;
-            return pNamedColor;
-          }
-        }
-      }
-    }
-  }
-  delete[] temp;
-  return NULL;
+  return m_deviceColors[nearest];
 }
 
 CIccStructNamedColor* CIccArrayNamedColor::FindPcsColor(const icFloatNumber *pPCS, icFloatNumber dMinDE/*=1000.0*/) const
 {
-  icFloatNumber dCalcDE, dLeastDE=dMinDE;
-  icFloatNumber pLabIn[3], pLab[3];
-  CIccStructNamedColor* leastDEindex = NULL;
+  icFloatNumber dCalcDE;
+  icFloatNumber pLabIn[3];
+
+  if (!m_pPcsIndex)
+    return NULL;
 
   if (m_csPcs != icSigLabData) {
     icXYZtoLab(pLabIn,pPCS);
@@ -363,66 +407,29 @@ CIccStructNamedColor* CIccArrayNamedColor::FindPcsColor(const icFloatNumber *pPC
     memcpy(pLabIn, pPCS, 3*sizeof(icFloatNumber));
   }
 
-  icUInt32Number tagSize = m_pTag->GetSize();
-  for (icUInt32Number i=1; i<tagSize; i++) {
-    CIccStructNamedColor *pNamedColor = (CIccStructNamedColor*)icGetTagStructHandlerOfType(m_pTag->GetIndex(i), icSigNamedColorStruct);
-    if (pNamedColor) {
-      CIccTag *pTag = pNamedColor->GetElem(icSigNmclDeviceDataMbr);
-      if (pTag && pTag->IsNumArrayType()) {
-        CIccTagNumArray *v = (CIccTagNumArray*)pTag;
-        icUInt32Number sampleCount = v->GetNumValues()/m_nDeviceSamples;
-        if (sampleCount) {
-          v->GetValues(pLab, (sampleCount-1)*m_nDeviceSamples, 3);
-
-          dCalcDE = icDeltaE(pLabIn, pLab);
-
-          if (dCalcDE<dMinDE && dCalcDE<dLeastDE) {
-            dLeastDE = dCalcDE;
-            leastDEindex = pNamedColor;
-          }
-        }
-      }
-    }
-  }
+  icInt32Number nearest = m_pPcsIndex->FindNearest(pLabIn, &dCalcDE);
+  if (nearest<0 || dCalcDE>=dMinDE)
+    return NULL;
 
-  return leastDEindex;
+  return m_pcsColors[nearest];
 }
 
 CIccStructNamedColor* CIccArrayNamedColor::FindSpectralColor(const icFloatNumber *pSpec, icFloatNumber dMinRMS/*=1000.0*/) const
 {
-  icFloatNumber dCalcRMS, dLeastRMS=dMinRMS;
-  CIccStructNamedColor* leastRMSindex = NULL;
+  icFloatNumber dCalcDist;
 
-  icFloatNumber *temp = new icFloatNumber[m_nSpectralSamples];
-
-  if (!temp)
+  if (!m_pSpectralIndex)
     return NULL;
 
-  icUInt32Number tagSize = m_pTag->GetSize();
-  for (icUInt32Number i=1; i<tagSize; i++) {
-    CIccStructNamedColor *pNamedColor = (CIccStructNamedColor*)icGetTagStructHandlerOfType(m_pTag->GetIndex(i), icSigNamedColorStruct);
-    if (pNamedColor) {
-      CIccTag *pTag = pNamedColor->GetElem(icSigNmclDeviceDataMbr);
-      if (pTag && pTag->IsNumArrayType()) {
-        CIccTagNumArray *v = (CIccTagNumArray*)pTag;
-        icUInt32Number sampleCount = v->GetNumValues()/m_nDeviceSamples;
-        if (sampleCount) {
-          v->GetValues(temp, (sampleCount-1)*m_nSpectralSamples, m_nSpectralSamples);
-
-          dCalcRMS = icRmsDif(pSpec, temp, m_nSpectralSamples);
-
-          if (dCalcRMS<dMinRMS && dCalcRMS<dLeastRMS) {
-            dLeastRMS = dCalcRMS;
-            leastRMSindex = pNamedColor;
-          }
-        }
-      }
-    }
-  }
+  icInt32Number nearest = m_pSpectralIndex->FindNearest(pSpec, &dCalcDist);
+  if (nearest<0)
+    return NULL;
 
-  delete[] temp;
+  //RMS difference is the Euclidean distance scaled by 1/sqrt(samples)
+  if (dCalcDist/(icFloatNumber)sqrt((icFloatNumber)m_nSpectralSamples) >= dMinRMS)
+    return NULL;
 
-  return leastRMSindex;
+  return m_spectralColors[nearest];
 }
 
 bool CIccArrayNamedColor::GetDeviceTint(icFloatNumber *dstColor,
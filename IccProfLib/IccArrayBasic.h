@@ -70,8 +70,10 @@
 #include <list>
 #include <string>
 #include <map>
+#include <vector>
 #include "IccDefs.h"
 #include "IccTagComposite.h"
+#include "IccUtil.h"
 #ifdef USEICCDEVNAMESPACE
 namespace iccDEV {
 #endif
@@ -128,6 +130,10 @@ public:
 class CIccStructNamedColor;
 
 typedef std::map<std::string, CIccStructNamedColor*> icNamedColorStructList;
+typedef std::vector<CIccStructNamedColor*> icNamedColorStructVector;
+
+/** Number of principal components used to index spectral named colors */
+#define ICC_NAMEDCOLOR_SPECTRAL_KEYDIM 6
 
 /**
 ****************************************************************************
@@ -154,6 +160,7 @@ public:
 
   icValidateStatus Validate(std::string sigPath, std::string &sReport, const CIccProfile* pProfile=NULL) const;
 
+  //Begin() must be called before using the Find functions
   bool Begin();
 
   CIccStructNamedColor* FindColor(const icChar *szColor) const;
@@ -194,8 +201,20 @@ protected:
 
   CIccStructNamedColor *m_pZeroTint;
 
+  bool BuildIndex(CIccNearestIndex *&pIndex, icNamedColorStructVector &colors,
+                  icNamedColorlMemberSignature sig, icUInt32Number nSamples,
+                  icUInt32Number nKeyDim=0);
+
   icNamedColorStructList *m_list;
 
+  //Nearest neighbour indexes and the colors that their points belong to
+  CIccNearestIndex *m_pPcsIndex;
+  CIccNearestIndex *m_pDeviceIndex;
+  CIccNearestIndex *m_pSpectralIndex;
+  icNamedColorStructVector m_pcsColors;
+  icNamedColorStructVector m_deviceColors;
+  icNamedColorStructVector m_spectralColors;
+
   icUInt32Number m_nDeviceSamples;
   icUInt32Number m_nPcsSamples;
   icUInt32Number m_nSpectralSamples;
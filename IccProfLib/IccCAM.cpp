@@ -75,6 +75,68 @@
 #include <cstring>
 #include <string>
 
+/*---------------------------------------------------------------------------------*/
+/* Approximations used by the batch kernels.  icCamLog2 and icCamExp2 are accurate  */
+/* to a few float ulps for the positive normal arguments that CIECAM02 produces.    */
+
+static inline icFloat32Number
+icCamLog2 (icFloat32Number x)
+{
+	icUInt32Number	bits;
+	icFloat32Number	m, u, u2;
+	int		e;
+
+	memcpy (&bits, &x, sizeof(bits));
+	e = (int)((bits >> 23) & 0xff) - 127;
+	bits = (bits & 0x007fffff) | 0x3f800000;
+	memcpy (&m, &bits, sizeof(m));
+
+	if (m > 1.41421356f)
+	{
+		m *= 0.5f;
+		e++;
+	}
+
+	/* log2(m) = 2/ln(2) * atanh(u) */
+	u = (m - 1.0f) / (m + 1.0f);
+	u2 = u * u;
+
+	return (icFloat32Number)e + u * (2.88539008f + u2 * (0.961796694f + u2 * (0.577078016f + u2 * (0.412198583f + u2 * 0.320598898f))));
+}
+
+/*---------------------------------------------------------------------------------*/
+
+static inline icFloat32Number
+icCamExp2 (icFloat32Number y)
+{
+	icUInt32Number	bits;
+	icFloat32Number	n, f, scale;
+
+	if (y < -126.0f)
+		return 0.0f;
+	if (y > 127.0f)
+		y = 127.0f;
+
+	n = floorf (y + 0.5f);
+	f = (y - n) * 0.693147181f;
+
+	bits = (icUInt32Number)((int)n + 127) << 23;
+	memcpy (&scale, &bits, sizeof(scale));
+
+	return scale * (1.0f + f * (1.0f + f * (0.5f + f * (0.166666667f + f * (0.0416666667f + f * (0.00833333333f + f * 0.00138888889f))))));
+}
+
+/*---------------------------------------------------------------------------------*/
+
+static inline icFloat32Number
+icCamPow (icFloat32Number x, icFloat32Number y)
+{
+	if (!(x >= 1.17549435e-38f))
+		return 0.0f;
+
+	return icCamExp2 (y * icCamLog2 (x));
+}
+
 /*---------------------------------------------------------------------------------*/
 
 void
@@ -93,9 +155,9 @@ void
 CIccCamConverter::ReferenceConditions (icFloatNumber	*rgb,
 											 icFloatNumber	*rgbC)
 {
-	rgbC[0] = (icFloatNumber)((m_D * m_WhitePoint[1] / m_rgbWhite[0] + 1.0 - m_D) * rgb[0]);
-	rgbC[1] = (icFloatNumber)((m_D * m_WhitePoint[1] / m_rgbWhite[1] + 1.0 - m_D) * rgb[1]);
-	rgbC[2] = (icFloatNumber)((m_D * m_WhitePoint[1] / m_rgbWhite[2] + 1.0 - m_D) * rgb[2]);
+	rgbC[0] = (icFloatNumber)(m_refFactor[0] * rgb[0]);
+	rgbC[1] = (icFloatNumber)(m_refFactor[1] * rgb[1]);
+	rgbC[2] = (icFloatNumber)(m_refFactor[2] * rgb[2]);
 }
 
 /*---------------------------------------------------------------------------------*/
@@ -104,9 +166,9 @@ void
 CIccCamConverter::ReferenceConditionsInv (icFloatNumber *rgbC,
 												 icFloatNumber *rgb)
 {
-	rgb[0] = (icFloatNumber)(rgbC[0] / (m_D * m_WhitePoint[1] / m_rgbWhite[0] + 1.0 - m_D));
-	rgb[1] = (icFloatNumber)(rgbC[1] / (m_D * m_WhitePoint[1] / m_rgbWhite[1] + 1.0 - m_D));
-	rgb[2] = (icFloatNumber)(rgbC[2] / (m_D * m_WhitePoint[1] / m_rgbWhite[2] + 1.0 - m_D));
+	rgb[0] = (icFloatNumber)(rgbC[0] / m_refFactor[0]);
+	rgb[1] = (icFloatNumber)(rgbC[1] / m_refFactor[1]);
+	rgb[2] = (icFloatNumber)(rgbC[2] / m_refFactor[2]);
 }
 
 /*---------------------------------------------------------------------------------------*/
@@ -115,7 +177,8 @@ icFloatNumber
 CIccCamConverter::F_Function (icFloatNumber	x)
 {
 	icFloatNumber	y;
-	y = (icFloatNumber) (400.0 * pow ((double)x, 0.42) / (27.13 + pow ((double)x, 0.42)));
+	double	p = pow ((double)x, 0.42);
+	y = (icFloatNumber) (400.0 * p / (27.13 + p));
 	return y;
 }
 
@@ -126,7 +189,8 @@ CIccCamConverter::H_Function (icFloatNumber	x)
 {
 	icFloatNumber	y;
 
-	y = (icFloatNumber) (400.0 * pow ((double)x, (double)m_exp) / (27.13 + pow ((double)x, (double)m_exp)));
+	double	p = pow ((double)x, (double)m_exp);
+	y = (icFloatNumber) (400.0 * p / (27.13 + p));
 
 	return y;
 }
@@ -158,7 +222,7 @@ CIccCamConverter::Hyperbolic (icFloatNumber	x)
 		}
 		else
 		{
-			y = - ((1 + m_alfa) * H_Function (-x) / H_Function (m_Fl) - m_alfa) * F_Function (m_Fl);
+			y = - ((1 + m_alfa) * H_Function (-x) / m_HFl - m_alfa) * m_FFl;
 		}
 	}
 	else
@@ -169,7 +233,7 @@ CIccCamConverter::Hyperbolic (icFloatNumber	x)
 		}
 		else
 		{
-			y = ((1 + m_alfa) * H_Function (x) / H_Function (m_Fl) - m_alfa) * F_Function (m_Fl);
+			y = ((1 + m_alfa) * H_Function (x) / m_HFl - m_alfa) * m_FFl;
 		}
 	}
 
@@ -191,7 +255,7 @@ CIccCamConverter::HyperbolicInv (icFloatNumber y)
 		}
 		else
 		{
-			h_y = (- y / F_Function (m_Fl) + m_alfa) / (1 + m_alfa) * H_Function (m_Fl);
+			h_y = (- y / m_FFl + m_alfa) / (1 + m_alfa) * m_HFl;
 			x = - H_FunctionInv (h_y);
 		}
 	}
@@ -203,7 +267,7 @@ CIccCamConverter::HyperbolicInv (icFloatNumber y)
 		}
 		else
 		{
-			h_y = (y / F_Function (m_Fl) + m_alfa) / (1 + m_alfa) * H_Function (m_Fl);
+			h_y = (y / m_FFl + m_alfa) / (1 + m_alfa) * m_HFl;
 			x = H_FunctionInv (h_y);
 		}
 	}
@@ -269,6 +333,10 @@ CIccCamConverter::CalcCoefficients ()
 
 	Multiply_vect_by_mx (m_WhitePoint, m_rgbWhite, m_mFor);
 
+	m_refFactor[0] = m_D * m_WhitePoint[1] / m_rgbWhite[0] + 1.0 - m_D;
+	m_refFactor[1] = m_D * m_WhitePoint[1] / m_rgbWhite[1] + 1.0 - m_D;
+	m_refFactor[2] = m_D * m_WhitePoint[1] / m_rgbWhite[2] + 1.0 - m_D;
+
 	ReferenceConditions (m_rgbWhite, rgbC);
 
 	// because CIECAT02 == HPE
@@ -280,12 +348,21 @@ CIccCamConverter::CalcCoefficients ()
 //	m_x0 = (icFloatNumber) (m_Fl * 0.25 / 255.0);
 // m_x0 = (icFloatNumber) (m_Fl * 1.00 / 255.0)
 	m_x0 = (icFloatNumber) (m_Fl * 4.00 / 255.0);
-	m_cc = ((1 + m_alfa) * H_Function (m_x0) / H_Function (m_Fl) - m_alfa) * F_Function (m_Fl) / m_x0;
+	m_HFl = H_Function (m_Fl);
+	m_FFl = F_Function (m_Fl);
+	m_cc = ((1 + m_alfa) * H_Function (m_x0) / m_HFl - m_alfa) * m_FFl / m_x0;
 
 	rgbP[0] = Hyperbolic (m_Fl * rgbP[0] / 100) + 0.1f;
 	rgbP[1] = Hyperbolic (m_Fl * rgbP[1] / 100) + 0.1f;
 	rgbP[2] = Hyperbolic (m_Fl * rgbP[2] / 100) + 0.1f;
 	m_AWhite = (icFloatNumber)((2.0 * rgbP[0] + rgbP[1] + rgbP[2] / 20.0 - 0.305) * m_Nbb);
+
+	m_refScale[0] = (icFloatNumber)(m_refFactor[0] * m_Fl / 100.0);
+	m_refScale[1] = (icFloatNumber)(m_refFactor[1] * m_Fl / 100.0);
+	m_refScale[2] = (icFloatNumber)(m_refFactor[2] * m_Fl / 100.0);
+	m_hypScale = (1 + m_alfa) * 400.0f / m_HFl;
+	m_hypInvScale = m_HFl / (1 + m_alfa);
+	m_tFactor = (icFloatNumber)(50000.0 / 13.0 * m_Nc * m_Nbb);
 }
 
 
@@ -342,6 +419,8 @@ CIccCamConverter::CIccCamConverter ()
 	m_alfa = 0.2307f;
 	m_exp = 0.3169f;
 
+	m_bApproxMath = false;
+
 	CalcCoefficients ();
 }
 
@@ -478,6 +557,12 @@ CIccCamConverter::XYZToJab (const icFloatNumber*	xyz,
 	const icFloatNumber*	h_xyz;
 	icFloatNumber*	h_jab;
 
+	if (m_bApproxMath)
+	{
+		XYZToJabApprox (xyz, jab, nbr);
+		return;
+	}
+
 	h_xyz = xyz;
 	h_jab = jab;
 
@@ -539,6 +624,12 @@ CIccCamConverter::JabToXYZ (const icFloatNumber*	jab,
 	const icFloatNumber*	h_jab;
 	icFloatNumber*	h_xyz;
 
+	if (m_bApproxMath)
+	{
+		JabToXYZApprox (jab, xyz, nbr);
+		return;
+	}
+
 	h_jab = jab;
 	h_xyz = xyz;
 
@@ -634,6 +725,172 @@ CIccCamConverter::JabToXYZ (const icFloatNumber*	jab,
 	}
 }
 
+/*---------------------------------------------------------------------------------*/
+
+void
+CIccCamConverter::XYZToJabApprox (const icFloatNumber*	xyz,
+									icFloatNumber*	jab,
+									int		nbr)
+{
+	const icFloatNumber	cos2 = -0.416146837f, sin2 = 0.909297427f;
+	const icFloatNumber	jExp = m_c * m_z;
+	const icFloatNumber	cFactor = m_factor * 0.1f;
+	int		k, i;
+	icFloatNumber		rgb[3], rgbP[3];
+	icFloatNumber		x, p, la, lb, lchroma, ch, sh, A, J, et, t, C;
+
+	for (k=0;k<nbr;k++)
+	{
+		Multiply_vect_by_mx (xyz, rgb, m_mFor);
+
+		for (i=0; i<3; i++)
+		{
+			// clipping to the HPE triangle
+			x = rgb[i] > 0 ? rgb[i] * m_refScale[i] : 0.0f;
+
+			if (x <= m_x0)
+			{
+				rgbP[i] = m_cc * x + 0.1f;
+			}
+			else
+			{
+				p = icCamPow (x, m_exp);
+				rgbP[i] = (m_hypScale * p / (27.13f + p) - m_alfa) * m_FFl + 0.1f;
+			}
+		}
+
+		la = rgbP[0] - 12.0f * rgbP[1] / 11.0f + rgbP[2] / 11.0f;
+		lb = (rgbP[0] + rgbP[1] - 2.0f * rgbP[2]) / 9.0f;
+		lchroma = sqrtf (la * la + lb * lb);
+
+		// cosine and sine of the hue angle
+		if (lchroma > 0)
+		{
+			ch = la / lchroma;
+			sh = lb / lchroma;
+		}
+		else
+		{
+			ch = 1.0f;
+			sh = 0.0f;
+		}
+
+		A = (2.0f * rgbP[0] + rgbP[1] + rgbP[2] / 20.0f - 0.305f) * m_Nbb;
+		J = 100.0f * icCamPow (A / m_AWhite, jExp);
+
+		et = (ch * cos2 - sh * sin2 + 3.8f) * 0.25f;
+		t = m_tFactor * lchroma * et / (rgbP[0] + rgbP[1] + 21.0f / 20.0f * rgbP[2]);
+		C = icCamPow (t, 0.9f) * sqrtf (J) * cFactor;
+
+		jab[0] = J;
+		jab[1] = C * ch;
+		jab[2] = C * sh;
+
+		xyz += 3;
+		jab += 3;
+	}
+}
+
+/*---------------------------------------------------------------------------------*/
+
+void
+CIccCamConverter::JabToXYZApprox (const icFloatNumber*	jab,
+									icFloatNumber*	xyz,
+									int		nbr)
+{
+	const icFloatNumber	cos2 = -0.416146837f, sin2 = 0.909297427f;
+	const icFloatNumber	tExp = 1.0f / 0.9f;
+	const icFloatNumber	aExp = 1.0f / (m_c * m_z);
+	const icFloatNumber	xExp = 1.0f / m_exp;
+	const icFloatNumber	cFactor = m_factor * 0.1f;
+	const icFloatNumber	p3 = 21.0f / 20.0f;
+	const icFloatNumber	yMin = m_cc * m_x0;
+	int		k, i;
+	icFloatNumber		rgb[3], rgbP[3];
+	icFloatNumber		C, t, A, p1, p2, ch, sh, et, numerator, ratio, a, b, y, h_y, x;
+
+	for (k=0;k<nbr;k++)
+	{
+		if (jab[0] < 1.0e-5)
+		{
+			rgbP[0] = 0.1f;
+			rgbP[1] = 0.1f;
+			rgbP[2] = 0.1f;
+		}
+		else
+		{
+			C = sqrtf (jab[1] * jab[1] + jab[2] * jab[2]);
+
+			t = icCamPow (C / (sqrtf (jab[0]) * cFactor), tExp);
+			A = m_AWhite * icCamPow (jab[0] * 0.01f, aExp);
+
+			p2 = (A / m_Nbb + 0.305f) * 460.0f / 1403.0f;
+
+			if (t < 1.0e-5)
+			{
+				rgbP[0] = p2;
+				rgbP[1] = p2;
+				rgbP[2] = p2;
+			}
+			else
+			{
+				// cosine and sine of the hue angle
+				ch = jab[1] / C;
+				sh = jab[2] / C;
+
+				et = (ch * cos2 - sh * sin2 + 3.8f) * 0.25f;
+
+				p1 = m_tFactor * et / t;
+
+				numerator = p2 * (2.0f + p3);
+
+				if (fabsf (jab[1]) >= fabsf (jab[2])) /* |a| > |b| */
+				{
+					ratio = jab[2] / jab[1];
+
+					a = numerator / (p1 / ch + (2.0f+p3)*(220.0f/1403.0f) - (27.0f/1403.0f - p3*(6300.0f/1403.0f)) * ratio);
+					b = a * ratio;
+				}
+				else /* |b| > |a| */
+				{
+					ratio = jab[1] / jab[2];
+
+					b = numerator / (p1 / sh + (2.0f+p3)*(220.0f/1403.0f) * ratio - 27.0f/1403.0f + p3*(6300.0f/1403.0f));
+					a = b * ratio;
+				}
+
+				rgbP[0] = p2 + ( 451.0f * a +  288.0f * b) / 1403.0f;
+				rgbP[1] = p2 + (-891.0f * a -  261.0f * b) / 1403.0f;
+				rgbP[2] = p2 + (-220.0f * a - 6300.0f * b) / 1403.0f;
+			}
+		}
+
+		for (i=0; i<3; i++)
+		{
+			y = (rgbP[i] > 0 ? rgbP[i] : 0.0f) - 0.1f;
+
+			if (fabsf (y) <= yMin)
+			{
+				x = y / m_cc;
+			}
+			else
+			{
+				h_y = (fabsf (y) / m_FFl + m_alfa) * m_hypInvScale;
+				x = icCamPow (27.13f * h_y / (400.0f - h_y), xExp);
+				if (y < 0)
+					x = -x;
+			}
+
+			rgb[i] = x / m_refScale[i];
+		}
+
+		Multiply_vect_by_mx (rgb, xyz, m_mInv);
+
+		jab += 3;
+		xyz += 3;
+	}
+}
+
 CIccCamConverter& CIccCamConverter::operator=(const CIccCamConverter &camcon)
 {
   memcpy(&m_WhitePoint, &camcon.m_WhitePoint, sizeof(m_WhitePoint));
@@ -665,6 +922,16 @@ CIccCamConverter& CIccCamConverter::operator=(const CIccCamConverter &camcon)
   m_alfa=camcon.m_alfa;
   m_exp=camcon.m_exp;
 
+  memcpy(m_refFactor, camcon.m_refFactor, sizeof(m_refFactor));
+  m_HFl=camcon.m_HFl;
+  m_FFl=camcon.m_FFl;
+  memcpy(m_refScale, camcon.m_refScale, sizeof(m_refScale));
+  m_hypScale=camcon.m_hypScale;
+  m_hypInvScale=camcon.m_hypInvScale;
+  m_tFactor=camcon.m_tFactor;
+
+  m_bApproxMath=camcon.m_bApproxMath;
+
   return *this;
 }
 
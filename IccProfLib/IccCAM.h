@@ -110,6 +110,18 @@ private:
 	icFloatNumber								m_alfa;
 	icFloatNumber								m_exp;
 
+	// viewing condition dependent terms used for every pixel
+	double											m_refFactor[3];	/* CIECAT02 adaptation factor per channel */
+	icFloatNumber								m_HFl;	/* H_Function (m_Fl) */
+	icFloatNumber								m_FFl;	/* F_Function (m_Fl) */
+	icFloatNumber								m_refScale[3];	/* m_refFactor * m_Fl / 100 */
+	icFloatNumber								m_hypScale;	/* (1 + m_alfa) * 400 / m_HFl */
+	icFloatNumber								m_hypInvScale;	/* m_HFl / (1 + m_alfa) */
+	icFloatNumber								m_tFactor;	/* 50000/13 * m_Nc * m_Nbb */
+
+	// use the approximate batch kernels
+	bool												m_bApproxMath;
+
 	// helper functions
 	void	Multiply_vect_by_mx (const icFloatNumber	*in, icFloatNumber *out, icFloatNumber m[3][3]);
 
@@ -127,6 +139,9 @@ private:
 
 	void	CalcCoefficients ();
 
+	void	XYZToJabApprox (const icFloatNumber* xyz, icFloatNumber* jab, int nbr);
+	void	JabToXYZApprox (const icFloatNumber* jab, icFloatNumber* xyz, int nbr);
+
 public:
 	CIccCamConverter();
 	~CIccCamConverter();
@@ -136,6 +151,12 @@ public:
 	void	JabToXYZ (const icFloatNumber* jab, icFloatNumber* xyz, int nbr);
 	void	XYZToJab (const icFloatNumber* xyz, icFloatNumber* jab, int nbr);
 
+	// When set XYZToJab and JabToXYZ use polynomial approximations of pow and
+	// avoid trigonometric functions.  Results differ from the exact conversion
+	// by less than 0.001 in J, a, b and X, Y, Z (relative to 100).
+	void	SetApproxMath (bool bApproxMath) { m_bApproxMath = bApproxMath; }
+	bool	GetApproxMath () const { return m_bApproxMath; }
+
 	void	SetParameter_WhitePoint (icFloatNumber*	whitePoint);
   //Set absolute luminance of adapting field La
 	void	SetParameter_La (icFloatNumber	La);
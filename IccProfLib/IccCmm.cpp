@@ -84,6 +84,9 @@
 #include "IccSparseMatrix.h"
 #include "IccEncoding.h"
 #include "IccMatrixMath.h"
+#include "IccCAM.h"
+#include "IccMD5.h"
+#include <cmath>
 
 #ifdef USEICCDEVNAMESPACE
 namespace iccDEV {
@@ -454,6 +457,10 @@ CIccXform::CIccXform()
   m_nInterp = icInterpLinear;
   m_bUseD2BTags = false;
   m_bLuminanceMatching = false;
+  m_bBakeMpe = false;
+  m_nBakeGridPoints = 0;
+  m_fBakeMaxError = 0;
+  m_bApproxCam = false;
   m_PCSOffset[0] = m_PCSOffset[1] = m_PCSOffset[2] = 0;
 }
 
@@ -1325,6 +1332,19 @@ void CIccXform::SetParams(CIccProfile *pProfile, bool bInput, icRenderingIntent
     if (pHint) {
       m_bLuminanceMatching = true;
     }
+
+    pHint = pHintManager->GetHint("CIccCreateMpeBakeXformHint");
+    if (pHint) {
+      CIccCreateMpeBakeXformHint *pBakeHint = (CIccCreateMpeBakeXformHint*)pHint;
+      m_bBakeMpe = true;
+      m_nBakeGridPoints = pBakeHint->nGridPoints;
+      m_fBakeMaxError = pBakeHint->maxError;
+    }
+
+    pHint = pHintManager->GetHint("CIccCreateCamApproxXformHint");
+    if (pHint) {
+      m_bApproxCam = true;
+    }
   }
 }
 
@@ -1525,6 +1545,32 @@ CIccApplyXform *CIccXform::GetNewApply(icStatusCMM &status)
   return rv;
 }
 
+/**
+**************************************************************************
+* Name: CIccXform::ApplyBatch
+* 
+* Purpose: 
+*  Applies the xform to nPixels packed pixels.  Xforms that can process
+*  many pixels at once more efficiently override this.
+*  
+* Args:
+*  pApply = ApplyXform object containging temporary storage used during Apply
+*  DstPixels = nPixels*GetNumDstSamples() destination values,
+*  SrcPixels = nPixels*GetNumSrcSamples() source values (not overlapping DstPixels),
+*  nPixels = number of pixels to apply
+**************************************************************************
+*/
+void CIccXform::ApplyBatch(CIccApplyXform *pApply, icFloatNumber *DstPixels, const icFloatNumber *SrcPixels, icUInt32Number nPixels) const
+{
+  icUInt16Number nSrc = GetNumSrcSamples();
+  icUInt16Number nDst = GetNumDstSamples();
+  icUInt32Number i;
+
+  for (i=0; i<nPixels; i++, DstPixels+=nDst, SrcPixels+=nSrc) {
+    Apply(pApply, DstPixels, SrcPixels);
+  }
+}
+
 /**
  **************************************************************************
 * Name: CIccXform::AdjustPCS
@@ -1849,6 +1895,8 @@ CIccApplyPcsXform::CIccApplyPcsXform(CIccXform *pXform) : CIccApplyXform(pXform)
   m_list = new CIccApplyPcsStepList();
   m_temp1 = NULL;
   m_temp2 = NULL;
+  m_batch1 = NULL;
+  m_batch2 = NULL;
 }
 
 /**
@@ -1876,6 +1924,10 @@ CIccApplyPcsXform::~CIccApplyPcsXform()
     delete [] m_temp1;
   if (m_temp2)
     delete [] m_temp2;
+  if (m_batch1)
+    delete [] m_batch1;
+  if (m_batch2)
+    delete [] m_batch2;
 }
 
 /**
@@ -1899,6 +1951,33 @@ bool CIccApplyPcsXform::Init()
   return m_temp1!=NULL && m_temp2!=NULL;
 }
 
+/**
+**************************************************************************
+* Name: CIccApplyPcsXform::InitBatch
+* 
+* Purpose: 
+*  Allocates the pixel block buffers used by CIccPcsXform::ApplyBatch
+**************************************************************************
+*/
+bool CIccApplyPcsXform::InitBatch()
+{
+  if (m_batch1 && m_batch2)
+    return true;
+
+  CIccPcsXform *pXform = (CIccPcsXform*)m_pXform;
+  size_t nSize = (size_t)pXform->MaxChannels() * ICC_APPLY_BATCH_SIZE;
+
+  if (!nSize)
+    return false;
+
+  if (!m_batch1)
+    m_batch1 = new icFloatNumber[nSize];
+  if (!m_batch2)
+    m_batch2 = new icFloatNumber[nSize];
+
+  return m_batch1!=NULL && m_batch2!=NULL;
+}
+
 
 void CIccApplyPcsXform::AppendApplyStep(CIccApplyPcsStep *pStep)
 {
@@ -3056,7 +3135,6 @@ icStatusCMM CIccPcsXform::pushXYZConvert(CIccXform *pFromXform, CIccXform *pToXf
 void CIccPcsXform::pushXYZNormalize(IIccProfileConnectionConditions *pPcc, const icSpectralRange &srcRange, const icSpectralRange &dstRange)
 {
   const CIccTagSpectralViewingConditions *pView = pPcc->getPccViewingConditions();
-  CIccPcsXform tmp;
 
   icSpectralRange illuminantRange;
   const icFloatNumber *illuminant = pView->getIlluminant(illuminantRange);
@@ -3064,44 +3142,64 @@ void CIccPcsXform::pushXYZNormalize(IIccProfileConnectionConditions *pPcc, const
   icSpectralRange observerRange;
   const icFloatNumber *observer = pView->getObserver(observerRange);
 
-  //make sure illuminant goes through identical conversion steps
-  if (!icSameSpectralRange(srcRange, illuminantRange) || !icSameSpectralRange(dstRange, illuminantRange)) {
-    tmp.pushSpecToRange(illuminantRange, srcRange);
-    tmp.pushSpecToRange(srcRange, dstRange);
-    tmp.pushSpecToRange(dstRange, observerRange);
-  }
-  else {
-    tmp.pushSpecToRange(illuminantRange, observerRange);
+  icFloatNumber xyz[3], normxyz[3], pccxyz[3];
+
+  //Absolute xyz for illuminant and observer only depends on their data and the ranges
+  CIccSpectralObserverCache *pCache = CIccSpectralObserverCache::GetGlobal();
+  std::string key("N");
+  bool bCache = observer && illuminant;
+
+  if (bCache) {
+    CIccSpectralObserverCache::AppendKey(key, observerRange, observer, 3);
+    CIccSpectralObserverCache::AppendKey(key, illuminantRange, illuminant);
+    CIccSpectralObserverCache::AppendKey(key, srcRange);
+    CIccSpectralObserverCache::AppendKey(key, dstRange);
   }
-  tmp.pushMatrix(3, observerRange.steps, observer);
 
-  icStatusCMM stat=icCmmStatOk;
-  CIccApplyXform *pApply = tmp.GetNewApply(stat);
-  if (pApply) {
-    icFloatNumber xyz[3], normxyz[3], pccxyz[3];
+  if (!bCache || !pCache->Find(key, xyz, 3)) {
+    CIccPcsXform tmp;
+
+    //make sure illuminant goes through identical conversion steps
+    if (!icSameSpectralRange(srcRange, illuminantRange) || !icSameSpectralRange(dstRange, illuminantRange)) {
+      tmp.pushSpecToRange(illuminantRange, srcRange);
+      tmp.pushSpecToRange(srcRange, dstRange);
+      tmp.pushSpecToRange(dstRange, observerRange);
+    }
+    else {
+      tmp.pushSpecToRange(illuminantRange, observerRange);
+    }
+    tmp.pushMatrix(3, observerRange.steps, observer);
+
+    icStatusCMM stat=icCmmStatOk;
+    CIccApplyXform *pApply = tmp.GetNewApply(stat);
+    if (!pApply)
+      return;
 
     //Get absolute xyz for illuminant and observer
     tmp.Apply(pApply, xyz, illuminant);
 
-    //calculate normalized XYZ
-    normxyz[0] = xyz[0] / xyz[1];
-    normxyz[1] = xyz[1] / xyz[1];
-    normxyz[2] = xyz[2] / xyz[1];
+    delete pApply;
+
+    if (bCache)
+      pCache->Add(key, xyz, 3);
+  }
 
-    //get desired XYZ from pcc (might be slightly different from calculated normxyz)
-    pPcc->getNormIlluminantXYZ(pccxyz);
+  //calculate normalized XYZ
+  normxyz[0] = xyz[0] / xyz[1];
+  normxyz[1] = xyz[1] / xyz[1];
+  normxyz[2] = xyz[2] / xyz[1];
+
+  //get desired XYZ from pcc (might be slightly different from calculated normxyz)
+  pPcc->getNormIlluminantXYZ(pccxyz);
 
 #if 1
-    //push scale factor to normalize XYZ values and correct for difference between calculated and desired XYZ
-    pushScale3(pccxyz[0] / (normxyz[0] * xyz[1]), 
-               pccxyz[1] / (normxyz[1] * xyz[1]),
-               pccxyz[2] / (normxyz[2] * xyz[1]));
+  //push scale factor to normalize XYZ values and correct for difference between calculated and desired XYZ
+  pushScale3(pccxyz[0] / (normxyz[0] * xyz[1]), 
+             pccxyz[1] / (normxyz[1] * xyz[1]),
+             pccxyz[2] / (normxyz[2] * xyz[1]));
 #else
-    pushScale3(1.0f/xyz[1], 1.0f/xyz[1], 1.0f/xyz[1]);
+  pushScale3(1.0f/xyz[1], 1.0f/xyz[1], 1.0f/xyz[1]);
 #endif
-
-    delete pApply;
-  }
 }
 
 /**
@@ -3509,6 +3607,66 @@ void CIccPcsXform::Apply(CIccApplyXform *pXform, icFloatNumber *DstPixel, const
   }
 }
 
+/**
+**************************************************************************
+* Name: CIccPcsXform::ApplyBatch
+* 
+* Purpose: 
+*  Applies the PCS steps to nPixels packed pixels.  Blocks of up to
+*  ICC_APPLY_BATCH_SIZE pixels are passed through each step at a time so
+*  that steps can use their batch implementations.
+**************************************************************************
+*/
+void CIccPcsXform::ApplyBatch(CIccApplyXform *pXform, icFloatNumber *DstPixels, const icFloatNumber *SrcPixels, icUInt32Number nPixels) const
+{
+  CIccApplyPcsXform *pApplyXform = (CIccApplyPcsXform*)pXform;
+  CIccApplyPcsStepList *pList = pApplyXform->m_list;
+  icUInt16Number nSrc = GetNumSrcSamples();
+  icUInt16Number nDst = GetNumDstSamples();
+
+  if (!pList || pList->begin()==pList->end()) {
+    memcpy(DstPixels, SrcPixels, (size_t)nPixels*nSrc*sizeof(icFloatNumber));
+    return;
+  }
+
+  CIccApplyPcsStepList::iterator s, n;
+  icUInt32Number p, nb;
+
+  //Packed pixels require each step to read what the previous step wrote
+  bool bPacked = pList->front().ptr->GetStep()->GetSrcChannels()==nSrc &&
+                 pList->back().ptr->GetStep()->GetDstChannels()==nDst;
+
+  s = n = pList->begin();
+  for (n++; bPacked && n!=pList->end(); s=n, n++) {
+    if (s->ptr->GetStep()->GetDstChannels()!=n->ptr->GetStep()->GetSrcChannels())
+      bPacked = false;
+  }
+
+  if (!bPacked || !pApplyXform->InitBatch()) {
+    CIccXform::ApplyBatch(pXform, DstPixels, SrcPixels, nPixels);
+    return;
+  }
+
+  for (p=0; p<nPixels; p+=nb) {
+    nb = nPixels - p;
+    if (nb > ICC_APPLY_BATCH_SIZE)
+      nb = ICC_APPLY_BATCH_SIZE;
+
+    const icFloatNumber *src = SrcPixels + (size_t)p*nSrc;
+    icFloatNumber *p1 = pApplyXform->m_batch1;
+    icFloatNumber *p2 = pApplyXform->m_batch2;
+    icFloatNumber *t;
+
+    s = n = pList->begin();
+    for (n++; n!=pList->end(); s=n, n++) {
+      s->ptr->ApplyBatch(p1, src, nb);
+      src=p1;
+      t=p1; p1=p2; p2=t;
+    }
+    s->ptr->ApplyBatch(DstPixels + (size_t)p*nDst, src, nb);
+  }
+}
+
 /**
 **************************************************************************
 * Name: CIccPcsStep::GetNewApply
@@ -3523,6 +3681,27 @@ CIccApplyPcsStep* CIccPcsStep::GetNewApply()
 }
 
 
+/**
+**************************************************************************
+* Name: CIccPcsStep::ApplyBatch
+* 
+* Purpose: 
+*  Applies the step to nPixels packed pixels.  Steps that can process many
+*  pixels at once more efficiently override this.
+**************************************************************************
+*/
+void CIccPcsStep::ApplyBatch(CIccApplyPcsStep *pApply, icFloatNumber *pDst, const icFloatNumber *pSrc, icUInt32Number nPixels) const
+{
+  icUInt16Number nSrc = GetSrcChannels();
+  icUInt16Number nDst = GetDstChannels();
+  icUInt32Number i;
+
+  for (i=0; i<nPixels; i++, pDst+=nDst, pSrc+=nSrc) {
+    Apply(pApply, pDst, pSrc);
+  }
+}
+
+
 /**
 **************************************************************************
 * Name: CIccPcsStepIdentity::Apply
@@ -4581,9 +4760,10 @@ CIccPcsStep *CIccPcsStepMatrix::reduce() const
   if (nNonZeros<nVals*3/4) {
     icUInt32Number nMatrixBytes = CIccSparseMatrix::MemSize(nNonZeros, m_nRows, sizeof(icFloatNumber))+4*sizeof(icFloatNumber);
     CIccPcsStepSparseMatrix *pMtx = new CIccPcsStepSparseMatrix(m_nRows, m_nCols, nMatrixBytes);
-    CIccSparseMatrix mtx(pMtx->data(), nMatrixBytes);
+    CIccSparseMatrix &mtx = pMtx->matrix();
     mtx.Init(m_nRows, m_nCols, true);
     mtx.FillFromFullMatrix(m_vals);
+    mtx.DecodeData();
     return pMtx;
   }
 
@@ -4653,6 +4833,22 @@ void CIccPcsStepMpe::Apply(CIccApplyPcsStep *pApply, icFloatNumber *pDst, const
 }
 
 
+/**
+**************************************************************************
+* Name: CIccPcsStepMpe::ApplyBatch
+* 
+* Purpose: 
+*  Applies a MultiProcessingElement to nPixels packed Source vectors
+**************************************************************************
+*/
+void CIccPcsStepMpe::ApplyBatch(CIccApplyPcsStep *pApply, icFloatNumber *pDst, const icFloatNumber *pSrc, icUInt32Number nPixels) const
+{
+  CIccApplyPcsStepMpe *pMpeApply = (CIccApplyPcsStepMpe*)pApply;
+
+  m_pMpe->ApplyBatch(pMpeApply->m_pApply, pDst, pSrc, nPixels);
+}
+
+
 /**
 **************************************************************************
 * Name: CIccPcsStepMpe::dump
@@ -4848,6 +5044,7 @@ CIccPcsStepSparseMatrix::CIccPcsStepSparseMatrix(icUInt16Number nRows, icUInt16N
   m_nBytesPerMatrix = nBytesPerMatrix;
   m_nChannels = 0;
   m_vals = new icFloatNumber[m_nBytesPerMatrix/sizeof(icFloatNumber)];
+  m_mtx.Reset(m_vals, m_nBytesPerMatrix, icSparseMatrixFloatNum, false);
 }
 
 
@@ -4877,9 +5074,22 @@ CIccPcsStepSparseMatrix::~CIccPcsStepSparseMatrix()
 */
 void CIccPcsStepSparseMatrix::Apply(CIccApplyPcsStep * /* pApply */, icFloatNumber *pDst, const icFloatNumber *pSrc) const
 {
-  CIccSparseMatrix mtx((icUInt8Number*)m_vals, m_nBytesPerMatrix, icSparseMatrixFloatNum, true);
+  m_mtx.MultiplyVector(pDst, pSrc);
+}
 
-  mtx.MultiplyVector(pDst, pSrc);
+
+/**
+**************************************************************************
+* Name: CIccPcsStepSparseMatrix::ApplyBatch
+* 
+* Purpose: 
+*  Multiplies each of nPixels pSrc vectors by the sparse matrix decoded
+*  when the step was made
+**************************************************************************
+*/
+void CIccPcsStepSparseMatrix::ApplyBatch(CIccApplyPcsStep * /* pApply */, icFloatNumber *pDst, const icFloatNumber *pSrc, icUInt32Number nPixels) const
+{
+  m_mtx.MultiplyVectors(pDst, pSrc, nPixels);
 }
 
 
@@ -4954,6 +5164,27 @@ void CIccPcsStepSrcSparseMatrix::Apply(CIccApplyPcsStep * /* pApply */, icFloatN
 }
 
 
+/**
+**************************************************************************
+* Name: CIccPcsStepSrcSparseMatrix::ApplyBatch
+* 
+* Purpose: 
+*  Multiplies illuminant stored in m_vals by each of nPixels pSrc matrices
+*  using a single sparse matrix view that is reset for each pixel
+**************************************************************************
+*/
+void CIccPcsStepSrcSparseMatrix::ApplyBatch(CIccApplyPcsStep * /* pApply */, icFloatNumber *pDst, const icFloatNumber *pSrc, icUInt32Number nPixels) const
+{
+  CIccSparseMatrix mtx;
+  icUInt32Number i;
+
+  for (i=0; i<nPixels; i++, pDst+=m_nRows, pSrc+=m_nChannels) {
+    mtx.Reset((icUInt8Number*)pSrc, m_nBytesPerMatrix, icSparseMatrixFloatNum, true);
+    mtx.MultiplyVector(pDst, m_vals);
+  }
+}
+
+
 /**
 **************************************************************************
 * Name: CIccPcsStepSrcSparseMatrix::dump
@@ -6724,6 +6955,7 @@ CIccXformNamedColor::CIccXformNamedColor(CIccTag *pTag, icColorSpaceSignature cs
 {
   m_nApplyInterface = icApplyPixel2Pixel; // was uninitialized
   m_pTag = NULL;
+  m_pArray = NULL;
   if (pTag) {
     if (pTag->GetType()==icSigNamedColor2Type) {
       m_pTag = (CIccTagNamedColor2*)pTag;
@@ -6745,7 +6977,6 @@ CIccXformNamedColor::CIccXformNamedColor(CIccTag *pTag, icColorSpaceSignature cs
 
   m_nSrcSpace = icSigUnknownData;
   m_nDestSpace = icSigUnknownData;
-  m_pArray = NULL;
 }
 
 
@@ -6852,12 +7083,11 @@ icStatusCMM CIccXformNamedColor::Apply(CIccApplyXform* pApply, icChar *DstColorN
         icFloatNumber pix[3];
         memcpy(pix, SrcPixel, 3*sizeof(icFloatNumber));
 
+        //FindPcsColor() converts XYZ to Lab itself
         if (m_nSrcSpace == icSigLabPcsData)
           icLabFromPcs(pix);
-        else {
+        else
           icXyzFromPcs(pix);
-          icXYZtoLab(pix, pix);
-        }
 
         pColor = pArray->FindPcsColor(pix);
         if (pColor) 
@@ -7101,6 +7331,205 @@ bool CIccXformNamedColor::IsDestPCS() const
 }
 
 
+/**
+**************************************************************************
+* Name: CIccLateBindingMpe::CIccLateBindingMpe
+* 
+* Purpose: 
+*  Constructor.  Takes ownership of the begun pTag and holds the first
+*  reference to it.
+**************************************************************************
+*/
+CIccLateBindingMpe::CIccLateBindingMpe(CIccTagMultiProcessElement *pTag) : m_nRefCount(1)
+{
+  m_pTag = pTag;
+}
+
+/**
+**************************************************************************
+* Name: CIccLateBindingMpe::~CIccLateBindingMpe
+* 
+* Purpose: 
+*  Destructor
+**************************************************************************
+*/
+CIccLateBindingMpe::~CIccLateBindingMpe()
+{
+  delete m_pTag;
+}
+
+/**
+**************************************************************************
+* Name: CIccLateBindingMpe::Release
+* 
+* Purpose: 
+*  Releases a reference, deleting the MPE when it was the last one.
+**************************************************************************
+*/
+void CIccLateBindingMpe::Release()
+{
+  if (--m_nRefCount == 0)
+    delete this;
+}
+
+
+/**
+**************************************************************************
+* Name: CIccLateBindingCache::CIccLateBindingCache
+* 
+* Purpose: 
+*  Constructor
+* 
+* Args: 
+*  nMaxEntries = number of begun MPEs retained before the least recently
+*   used ones are released
+**************************************************************************
+*/
+CIccLateBindingCache::CIccLateBindingCache(icUInt32Number nMaxEntries/*=ICC_LATE_BINDING_CACHE_SIZE*/)
+{
+  m_nMaxEntries = nMaxEntries ? nMaxEntries : 1;
+}
+
+/**
+**************************************************************************
+* Name: CIccLateBindingCache::~CIccLateBindingCache
+* 
+* Purpose: 
+*  Destructor
+**************************************************************************
+*/
+CIccLateBindingCache::~CIccLateBindingCache()
+{
+  Clear();
+}
+
+/**
+**************************************************************************
+* Name: CIccLateBindingCache::Find
+* 
+* Purpose: 
+*  Looks up the begun MPE for key, making it the most recently used one.
+* 
+* Return:
+*  A new reference to the MPE that the caller must release, or NULL if
+*  key is not cached.
+**************************************************************************
+*/
+CIccLateBindingMpe *CIccLateBindingCache::Find(const std::string &key)
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+
+  IccLateBindingList::iterator e;
+  for (e=m_Entries.begin(); e!=m_Entries.end(); e++) {
+    if (e->key == key) {
+      m_Entries.splice(m_Entries.begin(), m_Entries, e);
+      e->pMpe->AddRef();
+      return e->pMpe;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+**************************************************************************
+* Name: CIccLateBindingCache::Add
+* 
+* Purpose: 
+*  Caches pMpe for key, releasing the least recently used entries beyond
+*  the maximum.  Nothing is added if another thread already cached key.
+**************************************************************************
+*/
+void CIccLateBindingCache::Add(const std::string &key, CIccLateBindingMpe *pMpe)
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+
+  IccLateBindingList::iterator e;
+  for (e=m_Entries.begin(); e!=m_Entries.end(); e++) {
+    if (e->key == key)
+      return;
+  }
+
+  IccLateBindingEntry entry;
+  entry.key = key;
+  entry.pMpe = pMpe;
+
+  pMpe->AddRef();
+  m_Entries.push_front(entry);
+
+  Trim();
+}
+
+/**
+**************************************************************************
+* Name: CIccLateBindingCache::SetMaxEntries
+* 
+* Purpose: 
+*  Sets the number of begun MPEs retained, releasing the least recently
+*  used ones if the cache is now over the limit.
+**************************************************************************
+*/
+void CIccLateBindingCache::SetMaxEntries(icUInt32Number nMaxEntries)
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+
+  m_nMaxEntries = nMaxEntries ? nMaxEntries : 1;
+
+  Trim();
+}
+
+/**
+**************************************************************************
+* Name: CIccLateBindingCache::Clear
+* 
+* Purpose: 
+*  Releases all cached MPEs
+**************************************************************************
+*/
+void CIccLateBindingCache::Clear()
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+
+  IccLateBindingList::iterator e;
+  for (e=m_Entries.begin(); e!=m_Entries.end(); e++)
+    e->pMpe->Release();
+
+  m_Entries.clear();
+}
+
+size_t CIccLateBindingCache::GetCount()
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+
+  return m_Entries.size();
+}
+
+//Caller must hold m_Mutex
+void CIccLateBindingCache::Trim()
+{
+  while (m_Entries.size() > m_nMaxEntries) {
+    m_Entries.back().pMpe->Release();
+    m_Entries.pop_back();
+  }
+}
+
+/**
+**************************************************************************
+* Name: GetLateBindingCache
+* 
+* Purpose: 
+*  Returns the process wide CIccLateBindingCache used by CIccXformMpe so
+*  that its size can be configured.
+**************************************************************************
+*/
+CIccLateBindingCache &GetLateBindingCache()
+{
+  static CIccLateBindingCache cache;
+
+  return cache;
+}
+
+
 /**
 **************************************************************************
 * Name: CIccXformMPE::CIccXformMPE
@@ -7116,9 +7545,16 @@ CIccXformMpe::CIccXformMpe(CIccTag *pTag)
   else
     m_pTag = NULL;
 
+  m_pProfileTag = m_pTag;
+  m_bOwnsProfileTag = false;
+  m_pLateBinding = NULL;
+
   m_bUsingAcs = false;
   m_pAppliedPCC = NULL;
   m_bDeleteAppliedPCC = false;
+
+  m_pBakedCLUT = NULL;
+  m_fBakeError = 0;
 }
 
 /**
@@ -7131,8 +7567,17 @@ CIccXformMpe::CIccXformMpe(CIccTag *pTag)
 */
 CIccXformMpe::~CIccXformMpe()
 {
+  if (m_pLateBinding)
+    m_pLateBinding->Release();
+
+  if (m_bOwnsProfileTag)
+    delete m_pProfileTag;
+
   if (m_pAppliedPCC && m_bDeleteAppliedPCC)
     delete m_pAppliedPCC;
+
+  if (m_pBakedCLUT)
+    delete m_pBakedCLUT;
 }
 
 /**
@@ -7467,6 +7912,14 @@ void CIccXformMpe::SetAppliedCC(IIccProfileConnectionConditions *pPCC)
     return;
   }
 
+  if (pPCC == m_pAppliedPCC)
+    return;
+
+  if (m_pAppliedPCC && m_bDeleteAppliedPCC)
+    delete m_pAppliedPCC;
+  m_pAppliedPCC = NULL;
+  m_bDeleteAppliedPCC = false;
+
   if (m_pTag) {
     bool bReflectance = m_pTag->IsLateBindingReflectance();
 
@@ -7512,6 +7965,13 @@ void CIccXformMpe::SetAppliedCC(IIccProfileConnectionConditions *pPCC)
 *  should also call the base class function to initialize for Absolute Colorimetric
 *  Intent handling which is performed through the use of the CheckSrcAbs and
 *  CheckDstAbs functions.
+*
+*  Begin() may be called again after SetAppliedCC() or AttachCmmEnvVarLookup()
+*  to switch conditions.  Late binding MPEs are begun through the process
+*  wide CIccLateBindingCache, so xforms (including those of new CMMs) made
+*  from the same profile under conditions used recently do not begin the
+*  MPE again.  Apply objects must be obtained again with GetNewApply()
+*  after each Begin().
 **************************************************************************
 */
 icStatusCMM CIccXformMpe::Begin()
@@ -7522,18 +7982,329 @@ icStatusCMM CIccXformMpe::Begin()
   if (status != icCmmStatOk)
     return status;
 
-  if (!m_pTag) {
+  if (!m_pProfileTag) {
     return icCmmStatInvalidLut;
   }
 
-  if (!m_pTag->Begin(icElemInterpLinear, GetProfileCC(), GetConnectionConditions(), GetCmmEnvVarLookup())) {
+  //The approximate CAM setting belongs to this xform, so it is applied to a
+  //copy of the MPE owned by the xform rather than to the profile's tag.
+  if (m_bApproxCam && !m_bOwnsProfileTag && HasCamElements(m_pProfileTag)) {
+    CIccTagMultiProcessElement *pCopy = (CIccTagMultiProcessElement*)m_pProfileTag->NewCopy();
+    if (!pCopy)
+      return icCmmStatAllocErr;
+
+    icUInt32Number i, n = pCopy->NumElements();
+    for (i=0; i<n; i++) {
+      CIccMultiProcessElement *pElem = pCopy->GetElement((int)i);
+      if (pElem && (pElem->GetType()==icSigXYZToJabElemType || pElem->GetType()==icSigJabToXYZElemType)) {
+        CIccCamConverter *pCAM = ((CIccMpeCAM*)pElem)->GetCAM();
+        if (pCAM)
+          pCAM->SetApproxMath(true);
+      }
+    }
+
+    m_pProfileTag = pCopy;
+    m_pTag = pCopy;
+    m_bOwnsProfileTag = true;
+  }
+
+  if (m_pProfileTag->IsLateBinding()) {
+    if (!BeginLateBinding())
+      return icCmmStatInvalidProfile;
+  }
+  else if (!m_pTag->Begin(icElemInterpLinear, GetProfileCC(), GetConnectionConditions(), GetCmmEnvVarLookup())) {
     return icCmmStatInvalidProfile;
   }
 
+  if (m_pBakedCLUT) {
+    delete m_pBakedCLUT;
+    m_pBakedCLUT = NULL;
+  }
+  m_fBakeError = 0;
+
+  if (m_bBakeMpe && !BakeMpe())
+    return icCmmStatAllocErr;
+
   return icCmmStatOk;
 }
 
 
+/**
+**************************************************************************
+* Name: CIccXformMpe::HasCamElements
+* 
+* Purpose: 
+*  Returns true if the MPE has XYZToJab or JabToXYZ elements.
+**************************************************************************
+*/
+bool CIccXformMpe::HasCamElements(CIccTagMultiProcessElement *pTag)
+{
+  icUInt32Number i, n = pTag->NumElements();
+  for (i=0; i<n; i++) {
+    CIccMultiProcessElement *pElem = pTag->GetElement((int)i);
+    if (pElem && (pElem->GetType()==icSigXYZToJabElemType || pElem->GetType()==icSigJabToXYZElemType))
+      return true;
+  }
+
+  return false;
+}
+
+
+/**
+**************************************************************************
+* Name: CIccXformMpe::AddConditionsKey
+* 
+* Purpose: 
+*  Appends the viewing conditions, illuminant and media white of pPCC to key.
+**************************************************************************
+*/
+void CIccXformMpe::AddConditionsKey(std::string &key, IIccProfileConnectionConditions *pPCC)
+{
+  if (!pPCC) {
+    key.append(1, '\0');
+    return;
+  }
+
+  key.append(1, '\1');
+
+  const CIccTagSpectralViewingConditions *pView = pPCC->getPccViewingConditions();
+  if (pView) {
+    std::string viewKey;
+    pView->getConditionsKey(viewKey);
+    key.append(viewKey);
+  }
+
+  icFloatNumber xyz[9];
+  bool bMediaWhite;
+
+  pPCC->getNormIlluminantXYZ(&xyz[0]);
+  pPCC->getLumIlluminantXYZ(&xyz[3]);
+  bMediaWhite = pPCC->getMediaWhiteXYZ(&xyz[6]);
+  if (!bMediaWhite)
+    xyz[6] = xyz[7] = xyz[8] = 0;
+
+  key.append((const char*)xyz, sizeof(xyz));
+  key.append((const char*)&bMediaWhite, sizeof(bMediaWhite));
+}
+
+
+/**
+**************************************************************************
+* Name: CIccXformMpe::GetLateBindingKey
+* 
+* Purpose: 
+*  Builds the CIccLateBindingCache key of the active conditions from the
+*  MD5 of the written MPE, the approximate CAM setting, the profile and
+*  applied connection conditions and the values of the CMM environment
+*  variables.  The lookup itself is not part of the key: elements of the
+*  begun MPE read variables when applied through the lookup given to each
+*  apply object (see CIccXformMpe::GetNewApply), so an entry never refers
+*  to the lookup of the CMM that made it.
+*
+* Return:
+*  false if the MPE could not be written.
+**************************************************************************
+*/
+bool CIccXformMpe::GetLateBindingKey(std::string &key)
+{
+  if (m_lateBindingDigest.empty()) {
+    CIccMemIO io;
+    if (!io.Alloc(1024, true))
+      return false;
+    io.SetGrowable();
+
+    if (!m_pProfileTag->Write(&io))
+      return false;
+
+    MD5_CTX context;
+    icUInt8Number digest[16];
+    icMD5Init(&context);
+    icMD5Update(&context, io.GetData(), (unsigned int)io.GetLength());
+    icMD5Final(digest, &context);
+
+    m_lateBindingDigest.assign((const char*)digest, sizeof(digest));
+  }
+
+  IIccCmmEnvVarLookup *pEnv = GetCmmEnvVarLookup();
+
+  key = m_lateBindingDigest;
+  key.append(1, m_bApproxCam ? '\1' : '\0');
+
+  AddConditionsKey(key, GetProfileCC());
+  AddConditionsKey(key, GetConnectionConditions());
+
+  if (pEnv) {
+    icSigCmmEnvVar sig;
+    icFloatNumber val;
+    icUInt32Number i;
+
+    for (i=0; pEnv->IndexedEnvVar(i, sig, val); i++) {
+      key.append((const char*)&sig, sizeof(sig));
+      key.append((const char*)&val, sizeof(val));
+    }
+  }
+
+  return true;
+}
+
+
+/**
+**************************************************************************
+* Name: CIccXformMpe::BeginLateBinding
+* 
+* Purpose: 
+*  Makes the late binding MPE begun with the current connection conditions
+*  and environment variables the active MPE.  A begun MPE is taken from
+*  CIccLateBindingCache when available.  Otherwise a copy of the profile's
+*  MPE is begun and added to the cache.  The xform holds a reference to
+*  the active MPE until the next Begin() or its destruction.
+*
+* Return:
+*  true if the MPE was successfully begun, false otherwise.
+**************************************************************************
+*/
+bool CIccXformMpe::BeginLateBinding()
+{
+  std::string key;
+
+  if (!GetLateBindingKey(key))
+    return false;
+
+  CIccLateBindingCache &cache = GetLateBindingCache();
+  CIccLateBindingMpe *pMpe = cache.Find(key);
+
+  if (!pMpe) {
+    CIccTagMultiProcessElement *pTag = (CIccTagMultiProcessElement*)m_pProfileTag->NewCopy();
+    if (!pTag)
+      return false;
+
+    if (!pTag->Begin(icElemInterpLinear, GetProfileCC(), GetConnectionConditions(), GetCmmEnvVarLookup())) {
+      delete pTag;
+      return false;
+    }
+
+    pMpe = new CIccLateBindingMpe(pTag);
+    cache.Add(key, pMpe);
+  }
+
+  if (m_pLateBinding)
+    m_pLateBinding->Release();
+
+  m_pLateBinding = pMpe;
+  m_pTag = pMpe->GetTag();
+
+  return true;
+}
+
+
+/**
+**************************************************************************
+* Name: CIccXformMpe::BakeMpe
+* 
+* Purpose: 
+*  Samples the MPE chain into an internal CLUT so that Apply() only needs a
+*  single interpolation per pixel.  Only fixed function chains (no late
+*  binding) with 3 or 4 device input channels are baked.  The largest error
+*  found at the grid cell centers is kept in m_fBakeError.  If it exceeds
+*  the maximum error requested by the hint the CLUT is discarded and the
+*  MPE chain is used.
+*
+* Return:
+*  false if memory could not be allocated, true otherwise.
+**************************************************************************
+*/
+bool CIccXformMpe::BakeMpe()
+{
+  icUInt16Number nSrc = m_pTag->NumInputChannels();
+  icUInt16Number nDst = m_pTag->NumOutputChannels();
+
+  if (m_pTag->IsLateBinding() || !m_bInput || m_bPcsAdjustXform || IsSpacePCS(GetSrcSpace()) ||
+      (nSrc != 3 && nSrc != 4) || !nDst)
+    return true;
+
+  icUInt8Number nGrid = m_nBakeGridPoints;
+  if (nGrid < 2)
+    nGrid = (nSrc == 3 ? 33 : 17);
+
+  CIccApplyTagMpe *pApply = m_pTag->GetNewApply();
+  if (!pApply)
+    return false;
+
+  CIccCLUT *pCLUT = new CIccCLUT((icUInt8Number)nSrc, nDst);
+  if (!pCLUT || !pCLUT->Init(nGrid)) {
+    delete pApply;
+    if (pCLUT)
+      delete pCLUT;
+    return false;
+  }
+
+  icFloatNumber src[4], *pDst = pCLUT->GetData(0);
+  icFloatNumber fMax = (icFloatNumber)(nGrid - 1);
+  icUInt32Number nPoints = pCLUT->NumPoints();
+  icUInt32Number i, j, n;
+
+  //Grid data is ordered with the last input channel changing fastest
+  for (i=0; i<nPoints; i++, pDst += nDst) {
+    n = i;
+    for (j=nSrc; j>0; j--) {
+      src[j-1] = (icFloatNumber)(n % nGrid) / fMax;
+      n /= nGrid;
+    }
+    m_pTag->Apply(pApply, pDst, src);
+  }
+
+  pCLUT->Begin();
+
+  //Determine error at cell centers
+  icFloatNumber *pExact = new icFloatNumber[nDst];
+  icFloatNumber *pBaked = new icFloatNumber[nDst];
+  icUInt32Number nCells = 1;
+  icFloatNumber fErr = 0;
+
+  for (j=0; j<nSrc; j++)
+    nCells *= nGrid - 1;
+
+  for (i=0; i<nCells; i++) {
+    n = i;
+    for (j=nSrc; j>0; j--) {
+      src[j-1] = ((icFloatNumber)(n % (nGrid-1)) + 0.5f) / fMax;
+      n /= (nGrid-1);
+    }
+    m_pTag->Apply(pApply, pExact, src);
+
+    if (nSrc == 3) {
+      if (m_nInterp == icInterpTetrahedral)
+        pCLUT->Interp3dTetra(pBaked, src);
+      else
+        pCLUT->Interp3d(pBaked, src);
+    }
+    else
+      pCLUT->Interp4d(pBaked, src);
+
+    for (j=0; j<nDst; j++) {
+      icFloatNumber d = (icFloatNumber)fabs(pExact[j] - pBaked[j]);
+      if (d > fErr)
+        fErr = d;
+    }
+  }
+
+  delete [] pExact;
+  delete [] pBaked;
+  delete pApply;
+
+  m_fBakeError = fErr;
+
+  if (m_fBakeMaxError > 0 && fErr > m_fBakeMaxError) {
+    delete pCLUT;
+    return true;
+  }
+
+  m_pBakedCLUT = pCLUT;
+
+  return true;
+}
+
+
 /**
 **************************************************************************
 * Name: CIccXformMpe::GetNewApply
@@ -7555,13 +8326,20 @@ CIccApplyXform *CIccXformMpe::GetNewApply(icStatusCMM &status)
     return NULL;
   }
 
-  rv->m_pApply = m_pTag->GetNewApply();
+  //A late binding MPE may be shared with xforms of other CMMs so the
+  //environment variables are always read through this xform's lookup
+  rv->m_pApply = m_pTag->GetNewApply(GetCmmEnvVarLookup());
   if (!rv->m_pApply) {
     status = icCmmStatAllocErr;
     delete rv;
     return NULL;
   }
 
+  if (m_pLateBinding) {
+    m_pLateBinding->AddRef();
+    rv->m_pLateBinding = m_pLateBinding;
+  }
+
   status = icCmmStatOk;
   return rv;
 }
@@ -7611,10 +8389,22 @@ void CIccXformMpe::Apply(CIccApplyXform* pApply, icFloatNumber *DstPixel, const
     }
   }
 
-  //Note: pApply should be a CIccApplyXformMpe type here
-  CIccApplyXformMpe *pApplyMpe = (CIccApplyXformMpe *)pApply;
+  if (m_pBakedCLUT) {
+    if (m_pBakedCLUT->GetInputDim() == 3) {
+      if (m_nInterp == icInterpTetrahedral)
+        m_pBakedCLUT->Interp3dTetra(DstPixel, SrcPixel);
+      else
+        m_pBakedCLUT->Interp3d(DstPixel, SrcPixel);
+    }
+    else
+      m_pBakedCLUT->Interp4d(DstPixel, SrcPixel);
+  }
+  else {
+    //Note: pApply should be a CIccApplyXformMpe type here
+    CIccApplyXformMpe *pApplyMpe = (CIccApplyXformMpe *)pApply;
 
-  pTag->Apply(pApplyMpe->m_pApply, DstPixel, SrcPixel);
+    pTag->Apply(pApplyMpe->m_pApply, DstPixel, SrcPixel);
+  }
 
   if (m_bInput) { //PCS going out?
     //Since MPE tags use "real" values for PCS we need to convert to
@@ -7639,6 +8429,98 @@ void CIccXformMpe::Apply(CIccApplyXform* pApply, icFloatNumber *DstPixel, const
   }
 }
 
+/**
+**************************************************************************
+* Name: CIccXformMPE::ApplyBatch
+* 
+* Purpose: 
+*  Applies the xform to nPixels packed pixels.  PCS values are decoded and
+*  encoded a pixel at a time around a call to the MPE tag's ApplyBatch()
+*  for each block of up to ICC_APPLY_BATCH_SIZE pixels.  Baked CLUTs are
+*  applied a pixel at a time.
+**************************************************************************
+*/
+void CIccXformMpe::ApplyBatch(CIccApplyXform *pApply, icFloatNumber *DstPixels, const icFloatNumber *SrcPixels, icUInt32Number nPixels) const
+{
+  const CIccTagMultiProcessElement *pTag = m_pTag;
+  CIccApplyXformMpe *pApplyMpe = (CIccApplyXformMpe *)pApply;
+  icUInt16Number nSrc = GetNumSrcSamples();
+  icUInt16Number nDst = GetNumDstSamples();
+
+  if (m_pBakedCLUT || !pTag || pTag->NumInputChannels()!=nSrc || pTag->NumOutputChannels()!=nDst) {
+    CIccXform::ApplyBatch(pApply, DstPixels, SrcPixels, nPixels);
+    return;
+  }
+
+  bool bSrcAbs = false, bDstAbs = false;
+  icColorSpaceSignature srcSpace = icSigUnknownData, dstSpace = icSigUnknownData;
+
+  if (!m_bInput || m_bPcsAdjustXform) {
+    bSrcAbs = (m_nIntent != icAbsoluteColorimetric || m_nIntent != m_nTagIntent) && m_bSrcPcsConversion;
+    srcSpace = GetSrcSpace();
+    if (srcSpace!=icSigXYZData && srcSpace!=icSigLabData)
+      srcSpace = icSigUnknownData;
+  }
+  if (m_bInput) {
+    bDstAbs = (m_nIntent != icAbsoluteColorimetric || m_nIntent != m_nTagIntent) && m_bDstPcsConversion;
+    dstSpace = GetDstSpace();
+  }
+
+  bool bSrcConvert = bSrcAbs || srcSpace!=icSigUnknownData;
+
+  if (bSrcConvert) {
+    //PCS adjustments are made in 3 channel storage
+    if (nSrc!=3) {
+      CIccXform::ApplyBatch(pApply, DstPixels, SrcPixels, nPixels);
+      return;
+    }
+    if (!pApplyMpe->m_pBatchSrc)
+      pApplyMpe->m_pBatchSrc = new icFloatNumber[(size_t)nSrc*ICC_APPLY_BATCH_SIZE];
+  }
+
+  icUInt32Number p, nb, k;
+
+  for (p=0; p<nPixels; p+=nb) {
+    nb = nPixels - p;
+    if (nb > ICC_APPLY_BATCH_SIZE)
+      nb = ICC_APPLY_BATCH_SIZE;
+
+    const icFloatNumber *pSrc = SrcPixels + (size_t)p*nSrc;
+    icFloatNumber *pDst = DstPixels + (size_t)p*nDst;
+
+    if (bSrcConvert) {
+      icFloatNumber *pBuf = pApplyMpe->m_pBatchSrc;
+
+      for (k=0; k<nb; k++, pBuf+=nSrc) {
+        const icFloatNumber *pPixel = pSrc + (size_t)k*nSrc;
+        if (bSrcAbs)
+          pPixel = CheckSrcAbs(pApply, pPixel);
+        memcpy(pBuf, pPixel, nSrc*sizeof(icFloatNumber));
+
+        if (srcSpace==icSigXYZData)
+          icXyzFromPcs(pBuf);
+        else if (srcSpace==icSigLabData)
+          icLabFromPcs(pBuf);
+      }
+      pSrc = pApplyMpe->m_pBatchSrc;
+    }
+
+    pTag->ApplyBatch(pApplyMpe->m_pApply, pDst, pSrc, nb);
+
+    if (m_bInput) {
+      for (k=0; k<nb; k++, pDst+=nDst) {
+        if (dstSpace==icSigXYZData)
+          icXyzToPcs(pDst);
+        else if (dstSpace==icSigLabData)
+          icLabToPcs(pDst);
+
+        if (bDstAbs)
+          CheckDstAbs(pDst);
+      }
+    }
+  }
+}
+
 /**
 **************************************************************************
 * Name: CIccApplyXformMpe::CIccApplyXformMpe
@@ -7650,6 +8532,8 @@ void CIccXformMpe::Apply(CIccApplyXform* pApply, icFloatNumber *DstPixel, const
 CIccApplyXformMpe::CIccApplyXformMpe(CIccXformMpe *pXform) : CIccApplyXform(pXform)
 {
     m_pApply = NULL;
+    m_pLateBinding = NULL;
+    m_pBatchSrc = NULL;
 }
 
 /**
@@ -7664,6 +8548,12 @@ CIccApplyXformMpe::~CIccApplyXformMpe()
 {
   if (m_pApply)
     delete m_pApply;
+
+  if (m_pLateBinding)
+    m_pLateBinding->Release();
+
+  if (m_pBatchSrc)
+    delete [] m_pBatchSrc;
 }
 
 
@@ -7688,6 +8578,11 @@ CIccApplyCmm::CIccApplyCmm(CIccCmm *pCmm)
 
   m_Pixel = NULL;
   m_Pixel2 = NULL;
+
+  m_pBatch1 = NULL;
+  m_pBatch2 = NULL;
+  m_bBatchInit = false;
+  m_bBatch = false;
 }
 
 /**
@@ -7718,6 +8613,11 @@ CIccApplyCmm::~CIccApplyCmm()
     free(m_Pixel);
   if (m_Pixel2)
     free(m_Pixel2);
+
+  if (m_pBatch1)
+    free(m_pBatch1);
+  if (m_pBatch2)
+    free(m_pBatch2);
 }
 
 bool CIccApplyCmm::InitPixel()
@@ -7744,6 +8644,51 @@ bool CIccApplyCmm::InitPixel()
   return true;
 }
 
+/**
+**************************************************************************
+* Name: CIccApplyCmm::InitBatch
+* 
+* Purpose: 
+*  Determines whether Apply(nPixels) can pass blocks of pixels through each
+*  xform with ApplyBatch().  This requires each xform's source samples to
+*  match the previous xform's destination samples.  Allocates the buffers
+*  used between xforms.
+**************************************************************************
+*/
+bool CIccApplyCmm::InitBatch()
+{
+  CIccApplyXformList::iterator i;
+  icUInt16Number nSamples = m_pCmm->GetSourceSamples();
+  icUInt16Number nMax = nSamples;
+
+  m_bBatchInit = true;
+  m_bBatch = false;
+
+  for (i=m_Xforms->begin(); i!=m_Xforms->end(); i++) {
+    const CIccXform *pXform = i->ptr->GetXform();
+
+    if (!pXform || pXform->GetNumSrcSamples()!=nSamples)
+      return true;
+
+    nSamples = pXform->GetNumDstSamples();
+    if (nSamples > nMax)
+      nMax = nSamples;
+  }
+
+  if (!nMax || nSamples!=m_pCmm->GetDestSamples())
+    return true;
+
+  m_pBatch1 = (icFloatNumber*)malloc((size_t)nMax*ICC_APPLY_BATCH_SIZE*sizeof(icFloatNumber));
+  m_pBatch2 = (icFloatNumber*)malloc((size_t)nMax*ICC_APPLY_BATCH_SIZE*sizeof(icFloatNumber));
+
+  if (!m_pBatch1 || !m_pBatch2)
+    return false;
+
+  m_bBatch = true;
+
+  return true;
+}
+
 //#define DEBUG_CMM_APPLY
 
 #ifdef DEBUG_CMM_APPLY
@@ -7867,6 +8812,44 @@ icStatusCMM CIccApplyCmm::Apply(icFloatNumber *DstPixel, const icFloatNumber *Sr
   if (!n)
     return icCmmStatBadXform;
 
+  if (!m_bBatchInit && !InitBatch())
+    return icCmmStatAllocErr;
+
+  if (m_bBatch) {
+    icUInt16Number nSrcSamples = m_pCmm->GetSourceSamples();
+    icUInt16Number nDstSamples = m_pCmm->GetDestSamples();
+    const icFloatNumber *pSrcEnd = SrcPixel + (size_t)nPixels*nSrcSamples;
+    icFloatNumber *pDstEnd = DstPixel + (size_t)nPixels*nDstSamples;
+
+    //In place application writes the last xform's results to a batch buffer
+    bool bOverlap = DstPixel < pSrcEnd && SrcPixel < pDstEnd;
+    icUInt32Number nb;
+
+    for (k=0; k<nPixels; k+=nb) {
+      nb = nPixels - k;
+      if (nb > ICC_APPLY_BATCH_SIZE)
+        nb = ICC_APPLY_BATCH_SIZE;
+
+      pSrc = SrcPixel + (size_t)k*nSrcSamples;
+      icFloatNumber *pBlockDst = DstPixel + (size_t)k*nDstSamples;
+
+      for (j=0, i=m_Xforms->begin(); i!=m_Xforms->end(); i++, j++) {
+        if (j==n-1 && !bOverlap)
+          pDst = pBlockDst;
+        else
+          pDst = (pSrc==m_pBatch1 ? m_pBatch2 : m_pBatch1);
+
+        i->ptr->ApplyBatch(pDst, pSrc, nb);
+        pSrc = pDst;
+      }
+
+      if (pSrc != pBlockDst)
+        memcpy(pBlockDst, pSrc, (size_t)nb*nDstSamples*sizeof(icFloatNumber));
+    }
+
+    return icCmmStatOk;
+  }
+
   if (!m_Pixel && !InitPixel()) {
     return icCmmStatAllocErr;
   }
@@ -73,7 +73,11 @@
 #include "IccTag.h"
 #include "IccUtil.h"
 #include "IccMatrixMath.h"
+#include "IccSparseMatrix.h"
 #include <list>
+#include <string>
+#include <mutex>
+#include <atomic>
 #include <cstring>
 #include <cstdlib>
 
@@ -318,6 +322,43 @@ public:
   virtual const char *GetHintType() const { return "CIccLuminanceMatchingHint"; }
 };
 
+/**
+**************************************************************************
+* Type: Class
+*
+* Purpose:
+*  Hint for baking non late binding MPE transforms with 3 or 4 input
+*  channels into an internal CLUT when Begin() is called.  This trades
+*  exactness for speed.
+**************************************************************************
+*/
+class ICCPROFLIB_API CIccCreateMpeBakeXformHint : public IIccCreateXformHint
+{
+public:
+  CIccCreateMpeBakeXformHint(icUInt8Number nGrid=0, icFloatNumber fMaxErr=0) { nGridPoints = nGrid; maxError = fMaxErr; }
+
+  virtual const char *GetHintType() const { return "CIccCreateMpeBakeXformHint"; }
+
+  icUInt8Number nGridPoints;  //grid points per dimension (0 = default for input dimension)
+  icFloatNumber maxError;     //largest sampled error allowed before falling back to MPE (0 = no limit)
+};
+
+/**
+**************************************************************************
+* Type: Class
+*
+* Purpose:
+*  Hint for using the approximate CIECAM02 kernels of CIccCamConverter in
+*  the XYZToJab and JabToXYZ elements of MPE transforms.  This trades
+*  exactness for speed (see CIccCamConverter::SetApproxMath).
+**************************************************************************
+*/
+class ICCPROFLIB_API CIccCreateCamApproxXformHint : public IIccCreateXformHint
+{
+public:
+  virtual const char *GetHintType() const { return "CIccCreateCamApproxXformHint"; }
+};
+
 
 
 //forward reference to CIccXform used by CIccApplyXform
@@ -381,6 +422,9 @@ public:
 
   virtual void Apply(CIccApplyXform *pXform, icFloatNumber *DstPixel, const icFloatNumber *SrcPixel) const = 0;
 
+  ///Applies nPixels packed pixels.  DstPixels must not overlap SrcPixels.
+  virtual void ApplyBatch(CIccApplyXform *pXform, icFloatNumber *DstPixels, const icFloatNumber *SrcPixels, icUInt32Number nPixels) const;
+
   //Detach and remove CIccIO object associated with xform's profile.  Must call after Begin()
   virtual bool RemoveIO() { return m_pProfile ? m_pProfile->Detach() : false; }
 
@@ -468,7 +512,15 @@ protected:
   bool m_bAbsToRel;
   icMCSConnectionType m_nMCS;
   bool m_bLuminanceMatching;
-  
+
+  //MPE baking (see CIccCreateMpeBakeXformHint)
+  bool m_bBakeMpe;
+  icUInt8Number m_nBakeGridPoints;
+  icFloatNumber m_fBakeMaxError;
+
+  //Approximate CAM element math (see CIccCreateCamApproxXformHint)
+  bool m_bApproxCam;
+
   //Temporary field
   bool m_bSrcPcsConversion;
   bool m_bDstPcsConversion;
@@ -509,6 +561,9 @@ public:
 typedef std::list<CIccXformPtr> CIccXformList;
 
 
+//Number of pixels passed through each xform at a time by batch Apply functions
+#define ICC_APPLY_BATCH_SIZE 64
+
 /**
 **************************************************************************
 * Type: Class
@@ -524,6 +579,7 @@ public:
   virtual icXformType GetXformType() const { return icXformTypeUnknown; }
 
   void __inline Apply(icFloatNumber *DstPixel, const icFloatNumber *SrcPixel) { m_pXform->Apply(this, DstPixel, SrcPixel); }
+  void __inline ApplyBatch(icFloatNumber *DstPixels, const icFloatNumber *SrcPixels, icUInt32Number nPixels) { m_pXform->ApplyBatch(this, DstPixels, SrcPixels, nPixels); }
 
   const CIccXform *GetXform() { return m_pXform; }
 
@@ -591,6 +647,7 @@ public:
 
   virtual ~CIccPcsStep() {}
   virtual void Apply(CIccApplyPcsStep *pApply, icFloatNumber *pDst, const icFloatNumber *pSrc) const=0;
+  virtual void ApplyBatch(CIccApplyPcsStep *pApply, icFloatNumber *pDst, const icFloatNumber *pSrc, icUInt32Number nPixels) const;
   virtual icUInt16Number GetSrcChannels() const =0;
   virtual icUInt16Number GetDstChannels() const =0;
 
@@ -616,6 +673,7 @@ public:
   virtual icPcsStepType GetXformType() const { return m_stepType; }
 
   void __inline Apply(icFloatNumber *DstPixel, const icFloatNumber *SrcPixel) { m_pStep->Apply(this, DstPixel, SrcPixel); }
+  void __inline ApplyBatch(icFloatNumber *DstPixels, const icFloatNumber *SrcPixels, icUInt32Number nPixels) { m_pStep->ApplyBatch(this, DstPixels, SrcPixels, nPixels); }
 
   const CIccPcsStep *GetStep() const { return m_pStep; }
 
@@ -846,6 +904,7 @@ public:
   virtual ~CIccPcsStepMatrix() {}
 
   virtual void Apply(CIccApplyPcsStep * /* pApply */, icFloatNumber *pDst, const icFloatNumber *pSrc) const {VectorMult(pDst, pSrc); }//Must support pApply=NULL
+  virtual void ApplyBatch(CIccApplyPcsStep * /* pApply */, icFloatNumber *pDst, const icFloatNumber *pSrc, icUInt32Number nPixels) const { VectorMultBatch(pDst, pSrc, nPixels); }
   virtual icUInt16Number GetSrcChannels() const { return m_nCols; }
   virtual icUInt16Number GetDstChannels() const { return m_nRows; }
 
@@ -872,6 +931,7 @@ public:
   virtual CIccApplyPcsStep *GetNewApply();
 
   virtual void Apply(CIccApplyPcsStep *pApply, icFloatNumber *pDst, const icFloatNumber *pSrc) const;
+  virtual void ApplyBatch(CIccApplyPcsStep *pApply, icFloatNumber *pDst, const icFloatNumber *pSrc, icUInt32Number nPixels) const;
   virtual icUInt16Number GetSrcChannels() const;
   virtual icUInt16Number GetDstChannels() const;
 
@@ -935,12 +995,16 @@ public:
   virtual ~CIccPcsStepSparseMatrix();
 
   virtual void Apply(CIccApplyPcsStep *pApply, icFloatNumber *pDst, const icFloatNumber *pSrc) const;
+  virtual void ApplyBatch(CIccApplyPcsStep *pApply, icFloatNumber *pDst, const icFloatNumber *pSrc, icUInt32Number nPixels) const;
   virtual icUInt16Number GetSrcChannels() const { return m_nCols; }
   virtual icUInt16Number GetDstChannels() const { return m_nRows; }
 
   icFloatNumber *data() { return m_vals;}
   const icFloatNumber *data() const { return m_vals;}
 
+  ///Sparse matrix view of data() used by Apply()
+  CIccSparseMatrix &matrix() { return m_mtx; }
+
   virtual CIccPcsStep *concat(CIccPcsStep * /* pNext */) const { return NULL; }
 
   virtual void dump(std::string &str) const;
@@ -949,6 +1013,7 @@ protected:
   icUInt32Number m_nBytesPerMatrix;
   icFloatNumber *m_vals;
 
+  CIccSparseMatrix m_mtx;
 };
 
 class ICCPROFLIB_API CIccPcsStepSrcSparseMatrix : public CIccPcsStep //Apply a vector to the matrix provided by the source
@@ -960,7 +1025,8 @@ public:
   virtual ~CIccPcsStepSrcSparseMatrix();
 
   virtual void Apply(CIccApplyPcsStep *pApply, icFloatNumber *pDst, const icFloatNumber *pSrc) const;
-  virtual icUInt16Number GetSrcChannels() const { return m_nCols; }
+  virtual void ApplyBatch(CIccApplyPcsStep *pApply, icFloatNumber *pDst, const icFloatNumber *pSrc, icUInt32Number nPixels) const;
+  virtual icUInt16Number GetSrcChannels() const { return m_nChannels; }
   virtual icUInt16Number GetDstChannels() const { return m_nRows; }
 
   icFloatNumber *data() { return m_vals;}
@@ -1023,6 +1089,7 @@ public:
   virtual CIccApplyXform *GetNewApply(icStatusCMM &status);  //Must be called after Begin
 
   virtual void Apply(CIccApplyXform *pXform, icFloatNumber *DstPixel, const icFloatNumber *SrcPixel) const;
+  virtual void ApplyBatch(CIccApplyXform *pXform, icFloatNumber *DstPixels, const icFloatNumber *SrcPixels, icUInt32Number nPixels) const;
 
   ///Returns the source color space of the transform
   virtual icColorSpaceSignature GetSrcSpace() const { return m_srcSpace; }
@@ -1129,11 +1196,16 @@ public:
 protected:
   CIccApplyPcsXform(CIccXform *pXform);
   bool Init();
+  bool InitBatch();
 
   CIccApplyPcsStepList *m_list;
 
   icFloatNumber *m_temp1;
   icFloatNumber *m_temp2;
+
+  //ICC_APPLY_BATCH_SIZE pixel buffers used by ApplyBatch (allocated on first use)
+  icFloatNumber *m_batch1;
+  icFloatNumber *m_batch2;
 };
 
 
@@ -1409,6 +1481,84 @@ protected:
 };
 
 
+/**
+**************************************************************************
+* Type: Class
+* 
+* Purpose: 
+*  A begun copy of a late binding MPE.  The xforms using it, the apply
+*  objects made from them and CIccLateBindingCache each hold a reference,
+*  and the MPE is deleted when the last reference is released.  Entries
+*  evicted from the cache therefore stay valid while still in use.
+**************************************************************************
+*/
+class ICCPROFLIB_API CIccLateBindingMpe
+{
+public:
+  CIccLateBindingMpe(CIccTagMultiProcessElement *pTag);
+
+  CIccTagMultiProcessElement *GetTag() const { return m_pTag; }
+
+  void AddRef() { m_nRefCount++; }
+  void Release();
+
+protected:
+  ~CIccLateBindingMpe();
+
+  CIccTagMultiProcessElement *m_pTag;
+  std::atomic<icUInt32Number> m_nRefCount;
+};
+
+/**
+**************************************************************************
+* Type: Class
+* 
+* Purpose: 
+*  Least recently used cache of begun late binding MPEs.  Entries are keyed
+*  by the contents of the MPE, the profile and applied connection conditions
+*  and the CMM environment variables (see CIccXformMpe::GetLateBindingKey),
+*  so transforms of separate CMMs that are made from the same profile under
+*  the same conditions share one begun MPE.  Access is thread safe.
+**************************************************************************
+*/
+#ifndef ICC_LATE_BINDING_CACHE_SIZE
+#define ICC_LATE_BINDING_CACHE_SIZE 16
+#endif
+class ICCPROFLIB_API CIccLateBindingCache
+{
+public:
+  CIccLateBindingCache(icUInt32Number nMaxEntries=ICC_LATE_BINDING_CACHE_SIZE);
+  ~CIccLateBindingCache();
+
+  ///Returns a new reference to the MPE cached for key, or NULL
+  CIccLateBindingMpe *Find(const std::string &key);
+  ///Adds a reference to pMpe to the cache unless key is already cached
+  void Add(const std::string &key, CIccLateBindingMpe *pMpe);
+
+  void SetMaxEntries(icUInt32Number nMaxEntries);
+  icUInt32Number GetMaxEntries() const { return m_nMaxEntries; }
+
+  void Clear();
+  size_t GetCount();
+
+protected:
+  void Trim();
+
+  struct IccLateBindingEntry {
+    std::string key;
+    CIccLateBindingMpe *pMpe;
+  };
+  typedef std::list<IccLateBindingEntry> IccLateBindingList;
+
+  //Entries in most recently used order
+  IccLateBindingList m_Entries;
+
+  icUInt32Number m_nMaxEntries;
+  std::mutex m_Mutex;
+};
+
+CIccLateBindingCache ICCPROFLIB_API &GetLateBindingCache();
+
 /**
 **************************************************************************
 * Type: Class
@@ -1433,6 +1583,7 @@ public:
 
   virtual CIccApplyXform *GetNewApply(icStatusCMM &status);
   virtual void Apply(CIccApplyXform *pApplyXform, icFloatNumber *DstPixel, const icFloatNumber *SrcPixel) const;
+  virtual void ApplyBatch(CIccApplyXform *pApplyXform, icFloatNumber *DstPixels, const icFloatNumber *SrcPixels, icUInt32Number nPixels) const;
 
   virtual bool UseLegacyPCS() const { return false; }
   virtual LPIccCurve* ExtractInputCurves() {return NULL;}
@@ -1445,12 +1596,35 @@ public:
   virtual IIccProfileConnectionConditions *GetConnectionConditions() const;
   virtual void SetAppliedCC(IIccProfileConnectionConditions *pPCC);
 
+  ///Returns true if Begin() replaced the MPE chain with a sampled CLUT
+  bool IsBaked() const { return m_pBakedCLUT != NULL; }
+  ///Returns the largest sampled error of the baked CLUT (valid when IsBaked())
+  icFloatNumber GetBakeError() const { return m_fBakeError; }
 
 protected:
+  bool BakeMpe();
+  bool BeginLateBinding();
+  bool GetLateBindingKey(std::string &key);
+  static void AddConditionsKey(std::string &key, IIccProfileConnectionConditions *pPCC);
+  static bool HasCamElements(CIccTagMultiProcessElement *pTag);
+
+  //Active MPE, either the profile's tag or a late binding state
   CIccTagMultiProcessElement *m_pTag;
+  //The profile's tag, or an owned copy of it when the xform changes element
+  //settings (approximate CAM math) that must not leak to other xforms
+  CIccTagMultiProcessElement *m_pProfileTag;
+  bool m_bOwnsProfileTag;
   bool m_bUsingAcs;
   IIccProfileConnectionConditions *m_pAppliedPCC;
   bool m_bDeleteAppliedPCC;
+
+  CIccCLUT *m_pBakedCLUT;
+  icFloatNumber m_fBakeError;
+
+  //Begun late binding MPE that m_pTag points to (NULL when not late binding)
+  CIccLateBindingMpe *m_pLateBinding;
+  //MD5 of the written m_pProfileTag, calculated by the first late binding Begin()
+  std::string m_lateBindingDigest;
 };
 
 /**
@@ -1471,6 +1645,11 @@ protected:
   CIccApplyXformMpe(CIccXformMpe *pXform);
 
   CIccApplyTagMpe *m_pApply;
+  //Reference that keeps the late binding MPE of m_pApply alive
+  CIccLateBindingMpe *m_pLateBinding;
+
+  //ICC_APPLY_BATCH_SIZE pixel buffer for PCS decoding in ApplyBatch (allocated on first use)
+  icFloatNumber *m_pBatchSrc;
 };
 
 
@@ -1585,12 +1764,19 @@ public:
 
 protected:
   CIccApplyCmm(CIccCmm *pCmm);
+  bool InitBatch();
 
   CIccApplyXformList *m_Xforms;
   CIccCmm *m_pCmm;
 
   icFloatNumber *m_Pixel;
   icFloatNumber *m_Pixel2;
+
+  //ICC_APPLY_BATCH_SIZE pixel buffers used between xforms by Apply(nPixels)
+  icFloatNumber *m_pBatch1;
+  icFloatNumber *m_pBatch2;
+  bool m_bBatchInit;
+  bool m_bBatch;
 };
 
 class IXformIterator
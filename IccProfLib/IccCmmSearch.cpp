@@ -69,6 +69,123 @@
  //////////////////////////////////////////////////////////////////////
 
 #include "IccCmmSearch.h"
+#include <cstring>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+
+/**
+**************************************************************************
+* Type: Class
+*
+* Purpose: A thread that searches runs of pixels for a batch
+*  CIccApplyCmmSearch::Apply() with an apply object of its own.  Workers
+*  are kept by the apply object that started them and reused by its later
+*  batches.
+**************************************************************************
+*/
+class CIccSearchWorker
+{
+public:
+  CIccSearchWorker(CIccApplyCmmSearch* pApply);
+  ~CIccSearchWorker();
+
+  bool Launch();
+  void Start(icFloatNumber* DstPixel, const icFloatNumber* SrcPixel, icUInt32Number nPixels);
+  icStatusCMM Wait();
+
+protected:
+  void Run();
+
+  CIccApplyCmmSearch* m_pApply;
+
+  std::thread m_thread;
+  std::mutex m_mutex;
+  std::condition_variable m_cond;
+  bool m_bBusy;
+  bool m_bStop;
+
+  icFloatNumber* m_pDst;
+  const icFloatNumber* m_pSrc;
+  icUInt32Number m_nPixels;
+  icStatusCMM m_status;
+};
+
+CIccSearchWorker::CIccSearchWorker(CIccApplyCmmSearch* pApply)
+{
+  m_pApply = pApply;
+  m_bBusy = false;
+  m_bStop = false;
+  m_pDst = NULL;
+  m_pSrc = NULL;
+  m_nPixels = 0;
+  m_status = icCmmStatOk;
+}
+
+CIccSearchWorker::~CIccSearchWorker()
+{
+  if (m_thread.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_bStop = true;
+    }
+    m_cond.notify_all();
+    m_thread.join();
+  }
+
+  delete m_pApply;
+}
+
+bool CIccSearchWorker::Launch()
+{
+  try {
+    m_thread = std::thread(&CIccSearchWorker::Run, this);
+  }
+  catch (...) {
+    return false;
+  }
+  return true;
+}
+
+void CIccSearchWorker::Start(icFloatNumber* DstPixel, const icFloatNumber* SrcPixel, icUInt32Number nPixels)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pDst = DstPixel;
+    m_pSrc = SrcPixel;
+    m_nPixels = nPixels;
+    m_bBusy = true;
+  }
+  m_cond.notify_all();
+}
+
+icStatusCMM CIccSearchWorker::Wait()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_cond.wait(lock, [this]() { return !m_bBusy; });
+
+  return m_status;
+}
+
+void CIccSearchWorker::Run()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  for (;;) {
+    m_cond.wait(lock, [this]() { return m_bBusy || m_bStop; });
+    if (!m_bBusy)
+      break;
+
+    lock.unlock();
+    icStatusCMM rv = m_pApply->ApplyPixels(m_pDst, m_pSrc, m_nPixels);
+    lock.lock();
+
+    m_status = rv;
+    m_bBusy = false;
+    m_cond.notify_all();
+  }
+}
 
 
 CIccApplyCmmSearch::CIccApplyCmmSearch(CIccCmm* pBaseCmm) : CIccApplyCmm(pBaseCmm)
@@ -88,6 +205,12 @@ CIccApplyCmmSearch::CIccApplyCmmSearch(CIccCmm* pBaseCmm) : CIccApplyCmm(pBaseCm
   }
   m_pixel.resize(m_nSamples);
   m_startPixel.resize(nSrcSamples);
+  m_nSearchSamples = nSrcSamples;
+
+  m_nSrcSamples = (icUInt16Number)pCmm->GetSourceSamples();
+  m_lastSrc.resize(m_nSrcSamples);
+  m_bWarmStart = pCmm->m_bWarmStart;
+  m_bHaveLast = false;
 
   bUseBounds = pCmm->m_bUsesBounds;
   overBoundsCost = pCmm->m_fOverBoundsCost;
@@ -100,6 +223,39 @@ CIccApplyCmmSearch::CIccApplyCmmSearch(CIccCmm* pBaseCmm) : CIccApplyCmm(pBaseCm
 
 CIccApplyCmmSearch::~CIccApplyCmmSearch()
 {
+  for (size_t i = 0; i < m_workers.size(); i++)
+    delete m_workers[i];
+}
+
+icStatusCMM CIccApplyCmmSearch::Init()
+{
+  CIccCmmSearch* pCmm = (CIccCmmSearch*)m_pCmm;
+  icStatusCMM rv = icCmmStatOk;
+  CIccApplyCmm* pApply;
+
+  if (m_nSearchSamples > ICC_SEARCHVEC_MAXSIZE)
+    return icCmmStatTooManySamples;
+
+  for (auto& cmm : pCmm->m_src_to_mid) {
+    pApply = cmm->GetNewApplyCmm(rv);
+    if (!pApply)
+      return rv != icCmmStatOk ? rv : icCmmStatAllocErr;
+    m_src_to_mid.push_back(CIccApplyCmmPtr(pApply));
+  }
+
+  for (auto& cmm : pCmm->m_dst_to_mid) {
+    pApply = cmm->GetNewApplyCmm(rv);
+    if (!pApply)
+      return rv != icCmmStatOk ? rv : icCmmStatAllocErr;
+    m_dst_to_mid.push_back(CIccApplyCmmPtr(pApply));
+  }
+
+  pApply = pCmm->m_mid_to_dst->GetNewApplyCmm(rv);
+  if (!pApply)
+    return rv != icCmmStatOk ? rv : icCmmStatAllocErr;
+  m_mid_to_dst = CIccApplyCmmPtr(pApply);
+
+  return icCmmStatOk;
 }
 
 static icFloatNumber sq(icFloatNumber x) { return x * x; }
@@ -109,7 +265,7 @@ icFloatNumber CIccApplyCmmSearch::costFunc(CIccSearchVec& point)
   CIccCmmSearch* pCmm = (CIccCmmSearch*)m_pCmm;
   icFloatNumber sum = 0.0;
   for (size_t i = 0; i < m_nApply; i++) {
-    pCmm->m_dst_to_mid[i]->Apply(&m_pixel[0], &point.vec()[0]);
+    m_dst_to_mid[i]->Apply(&m_pixel[0], point.data());
 
     if (m_bNeedPcsToLab) {
       icLabFromPcs(&m_pixel[0]);
@@ -124,6 +280,17 @@ icFloatNumber CIccApplyCmmSearch::costFunc(CIccSearchVec& point)
   return sum;
 }
 
+//Cost of a point as seen by the search including any bounds penalty
+icFloatNumber CIccApplyCmmSearch::startCost(CIccSearchVec& point)
+{
+  icFloatNumber cost;
+
+  if (bUseBounds && boundsCheck(point, cost))
+    return cost + overBoundsCost;
+
+  return costFunc(point);
+}
+
 bool CIccApplyCmmSearch::boundsCheck(const CIccSearchVec& point, icFloatNumber& boundsCost) const
 {
   bool rv = false;
@@ -164,18 +331,28 @@ icStatusCMM CIccApplyCmmSearch::Apply(icFloatNumber* DstPixel, const icFloatNumb
 {
   CIccCmmSearch* pCmm = (CIccCmmSearch*)m_pCmm;
 
-    if (!pCmm->m_src_to_mid.size()) { //src == mid so copy pixel data into mid search pixels
+  //Runs of identical pixels are common in images and give identical results
+  if (m_bHaveLast && !memcmp(SrcPixel, &m_lastSrc[0], m_nSrcSamples * sizeof(icFloatNumber))) {
+    memcpy(DstPixel, m_lastResult.data(), m_lastResult.size() * sizeof(icFloatNumber));
+    return icCmmStatOk;
+  }
+
+  if (!pCmm->m_src_to_mid.size()) { //src == mid so copy pixel data into mid search pixels
     for (size_t i = 0; i < m_nApply; i++) {
       memcpy(&m_mid_data[i][0], SrcPixel, m_nSamples*sizeof(icFloatNumber));
     }
   }
   else {
     for (size_t i = 0; i < m_nApply; i++) {
-      pCmm->m_src_to_mid[i]->Apply(&m_mid_data[i][0], SrcPixel);
+      icStatusCMM rv = m_src_to_mid[i]->Apply(&m_mid_data[i][0], SrcPixel);
+      if (rv != icCmmStatOk)
+        return rv;
     }
   }
 
-  pCmm->m_mid_to_dst->Apply(&m_startPixel[0], &m_mid_data[0][0]);
+  icStatusCMM rv = m_mid_to_dst->Apply(&m_startPixel[0], &m_mid_data[0][0]);
+  if (rv != icCmmStatOk)
+    return rv;
 
   //Cost function needs delteEab so convert from PCS encoding to Lab for comparisons
   if (m_bNeedPcsToLab) {
@@ -184,21 +361,131 @@ icStatusCMM CIccApplyCmmSearch::Apply(icFloatNumber* DstPixel, const icFloatNumb
     }
   }
 
-  icFloatVector result = findMin(m_startPixel);
+  CIccSearchVec start(&m_startPixel[0], m_nSearchSamples);
+  CIccSearchVec guess;
+  icFloatNumber cost = 0;
+  bool bHaveCost = false;
+  bool bRefine = false;
+
+  //A start near the answer only needs a small simplex to refine it
+  if (gridStart(guess, SrcPixel)) {
+    cost = startCost(start);
+    bHaveCost = true;
+
+    icFloatNumber guessCost = startCost(guess);
+    if (guessCost < cost) {
+      start = guess;
+      cost = guessCost;
+      bRefine = true;
+    }
+  }
+
+  if (m_bWarmStart && m_bHaveLast) {
+    CIccSearchVec last(m_lastResult);
 
-  memcpy(DstPixel, &result[0], result.size() * sizeof(icFloatNumber));
+    if (!bHaveCost)
+      cost = startCost(start);
+
+    if (startCost(last) < cost) {
+      start = last;
+      bRefine = true;
+    }
+  }
+
+  m_bHaveLast = false;
+
+  if (bRefine) {
+    CIccSearchVec simplex[ICC_SEARCHVEC_MAXSIZE + 1];
+
+    simplex[0] = start;
+    for (icUInt16Number i = 1; i <= m_nSearchSamples; i++) {
+      simplex[i] = start;
+      simplex[i](i - 1) += ICC_SEARCH_REFINE_STEP;
+    }
+    findMin(m_lastResult, start, simplex);
+  }
+  else {
+    findMin(m_lastResult, start);
+  }
+
+  //SrcPixel and DstPixel may be the same pixel so the source is kept first
+  memcpy(&m_lastSrc[0], SrcPixel, m_nSrcSamples * sizeof(icFloatNumber));
+  m_bHaveLast = true;
+
+  memcpy(DstPixel, m_lastResult.data(), m_lastResult.size() * sizeof(icFloatNumber));
 
   return icCmmStatOk;
 }
 
-icStatusCMM CIccApplyCmmSearch::Apply(icFloatNumber* DstPixel, const icFloatNumber* SrcPixel, icUInt32Number nPixels)
+//Interpolates a starting point from the grid tabulated by CIccCmmSearch::Begin()
+bool CIccApplyCmmSearch::gridStart(CIccSearchVec& start, const icFloatNumber* SrcPixel) const
+{
+  CIccCmmSearch* pCmm = (CIccCmmSearch*)m_pCmm;
+
+  if (!pCmm->m_initGrid.size())
+    return false;
+
+  icUInt32Number nDim = pCmm->m_nInitGridDim;
+  icUInt32Number nPoints = pCmm->m_nInitGridPoints;
+  icUInt32Number i, j, nBase = 0, nStride = 1;
+  icUInt32Number nStep[ICC_SEARCH_GRID_MAXDIM];
+  icFloatNumber fFrac[ICC_SEARCH_GRID_MAXDIM];
+
+  for (i = nDim; i > 0; i--) {
+    icFloatNumber v = SrcPixel[i - 1];
+    if (v < 0.0f)
+      v = 0.0f;
+    else if (v > 1.0f)
+      v = 1.0f;
+
+    v *= (icFloatNumber)(nPoints - 1);
+    icUInt32Number n = (icUInt32Number)v;
+    if (n >= nPoints - 1)
+      n = nPoints - 2;
+
+    fFrac[i - 1] = v - (icFloatNumber)n;
+    nBase += n * nStride;
+    nStep[i - 1] = nStride;
+    nStride *= nPoints;
+  }
+
+  start.resize(m_nSearchSamples);
+  for (j = 0; j < m_nSearchSamples; j++)
+    start(j) = 0;
+
+  for (icUInt32Number nCorner = 0; nCorner < (1u << nDim); nCorner++) {
+    icFloatNumber w = 1.0f;
+    icUInt32Number nIdx = nBase;
+
+    for (i = 0; i < nDim; i++) {
+      if (nCorner & (1u << i)) {
+        w *= fFrac[i];
+        nIdx += nStep[i];
+      }
+      else
+        w *= 1.0f - fFrac[i];
+    }
+
+    if (w != 0.0f) {
+      const icFloatNumber* pNode = &pCmm->m_initGrid[(size_t)nIdx * m_nSearchSamples];
+      for (j = 0; j < m_nSearchSamples; j++)
+        start(j) += w * pNode[j];
+    }
+  }
+
+  return true;
+}
+
+icStatusCMM CIccApplyCmmSearch::ApplyPixels(icFloatNumber* DstPixel, const icFloatNumber* SrcPixel, icUInt32Number nPixels)
 {
   CIccCmmSearch* pCmm = (CIccCmmSearch*)m_pCmm;
   icUInt32Number nSrcSamples = pCmm->GetSourceSamples();
   icUInt32Number nDstSamples = pCmm->GetDestSamples();
 
   for (icUInt32Number i = 0; i < nPixels; i++) {
-    Apply(DstPixel, SrcPixel);
+    icStatusCMM rv = Apply(DstPixel, SrcPixel);
+    if (rv != icCmmStatOk)
+      return rv;
     DstPixel += nDstSamples;
     SrcPixel += nSrcSamples;
   }
@@ -206,6 +493,80 @@ icStatusCMM CIccApplyCmmSearch::Apply(icFloatNumber* DstPixel, const icFloatNumb
   return icCmmStatOk;
 }
 
+/**
+**************************************************************************
+* Name: CIccApplyCmmSearch::Apply
+*
+* Purpose:
+*  Searches nPixels pixels.  When the CMM has more than one apply thread
+*  the pixels are split into contiguous runs (keeping neighbouring pixels
+*  together for warm starts) and each extra run is searched by a worker
+*  thread with its own apply object.  Workers are started by the first
+*  batch that needs them and kept for later batches.
+*
+* Return:
+*  The status of the first run that failed, otherwise icCmmStatOk.
+**************************************************************************
+*/
+icStatusCMM CIccApplyCmmSearch::Apply(icFloatNumber* DstPixel, const icFloatNumber* SrcPixel, icUInt32Number nPixels)
+{
+  CIccCmmSearch* pCmm = (CIccCmmSearch*)m_pCmm;
+  icUInt32Number nSrcSamples = pCmm->GetSourceSamples();
+  icUInt32Number nDstSamples = pCmm->GetDestSamples();
+  icUInt32Number nThreads = pCmm->m_nApplyThreads;
+
+  if (nThreads > nPixels / ICC_SEARCH_MIN_THREAD_PIXELS)
+    nThreads = nPixels / ICC_SEARCH_MIN_THREAD_PIXELS;
+
+  //In place application with differing sample counts has to run in order
+  if (nSrcSamples != nDstSamples &&
+      (const icFloatNumber*)DstPixel < SrcPixel + (size_t)nPixels * nSrcSamples &&
+      SrcPixel < (const icFloatNumber*)DstPixel + (size_t)nPixels * nDstSamples)
+    nThreads = 1;
+
+  if (nThreads <= 1)
+    return ApplyPixels(DstPixel, SrcPixel, nPixels);
+
+  //Workers that cannot be started leave their share to this thread
+  while (m_workers.size() < nThreads - 1) {
+    CIccApplyCmmSearch* pApply = new CIccApplyCmmSearch(pCmm);
+    if (pApply->Init() != icCmmStatOk) {
+      delete pApply;
+      break;
+    }
+
+    CIccSearchWorker* pWorker = new CIccSearchWorker(pApply);
+    if (!pWorker->Launch()) {
+      delete pWorker;
+      break;
+    }
+    m_workers.push_back(pWorker);
+  }
+
+  icUInt32Number nWorkers = (icUInt32Number)m_workers.size();
+  if (nWorkers > nThreads - 1)
+    nWorkers = nThreads - 1;
+
+  icUInt32Number nRun = (nPixels + nWorkers) / (nWorkers + 1);
+  icUInt32Number nStarted = 0;
+
+  for (icUInt32Number nFirst = nRun; nStarted < nWorkers && nFirst < nPixels; nFirst += nRun, nStarted++) {
+    icUInt32Number nCount = nPixels - nFirst < nRun ? nPixels - nFirst : nRun;
+
+    m_workers[nStarted]->Start(DstPixel + (size_t)nFirst * nDstSamples, SrcPixel + (size_t)nFirst * nSrcSamples, nCount);
+  }
+
+  icStatusCMM rv = ApplyPixels(DstPixel, SrcPixel, nRun < nPixels ? nRun : nPixels);
+
+  for (icUInt32Number t = 0; t < nStarted; t++) {
+    icStatusCMM stat = m_workers[t]->Wait();
+    if (rv == icCmmStatOk)
+      rv = stat;
+  }
+
+  return rv;
+}
+
 
 CIccCmmSearch::CIccCmmSearch(bool bUsesBounds, icFloatNumber overBoundsCost, const icFloatVector &minBounds, const icFloatVector &maxBounds)
 {
@@ -429,13 +790,98 @@ icStatusCMM CIccCmmSearch::Begin(bool /* bAllocNewApply */, bool /* bUsePcsConve
   else
     m_bNeedPcsToLab = false;
 
-  m_pApply = new CIccApplyCmmSearch(this);
+  CIccApplyCmmSearch* pApply = new CIccApplyCmmSearch(this);
+  rv = pApply->Init();
+  if (rv == icCmmStatOk)
+    rv = BuildInitGrid(pApply);
+
+  if (rv != icCmmStatOk) {
+    delete pApply;
+    return rv;
+  }
+  m_pApply = pApply;
 
   m_bValid = true;
 
   return rv;
 }
 
+/**
+**************************************************************************
+* Name: CIccCmmSearch::SetInitGridPoints
+*
+* Purpose:
+*  Sets the number of points per source channel of the initial search
+*  grid.  Values below 2 turn the grid off and values above
+*  ICC_SEARCH_GRID_MAXPOINTS are limited to it.
+**************************************************************************
+*/
+void CIccCmmSearch::SetInitGridPoints(icUInt32Number nGridPoints)
+{
+  if (nGridPoints < 2)
+    nGridPoints = 0;
+  else if (nGridPoints > ICC_SEARCH_GRID_MAXPOINTS)
+    nGridPoints = ICC_SEARCH_GRID_MAXPOINTS;
+
+  m_nInitGridPoints = nGridPoints;
+}
+
+/**
+**************************************************************************
+* Name: CIccCmmSearch::BuildInitGrid
+*
+* Purpose:
+*  Searches every point of a regular grid of source values so that Apply
+*  can start from an interpolated answer and only refine it.  The grid
+*  points are searched with the (possibly threaded) batch Apply.
+*
+* Return:
+*  icCmmStatAllocErr if the grid is too large to allocate.
+**************************************************************************
+*/
+icStatusCMM CIccCmmSearch::BuildInitGrid(CIccApplyCmmSearch* pApply)
+{
+  m_initGrid.clear();
+  m_nInitGridDim = 0;
+
+  icUInt32Number nDim = GetSourceSamples();
+  icUInt32Number nDstSamples = GetDestSamples();
+
+  if (m_nInitGridPoints < 2 || !nDim || nDim > ICC_SEARCH_GRID_MAXDIM)
+    return icCmmStatOk;
+
+  icUInt32Number i, j, n, nGrid = 1;
+  for (i = 0; i < nDim; i++) {
+    if (nGrid > 0xffffffff / m_nInitGridPoints)
+      return icCmmStatAllocErr;
+    nGrid *= m_nInitGridPoints;
+  }
+
+  if ((size_t)nGrid > (size_t)-1 / sizeof(icFloatNumber) / (nDim > nDstSamples ? nDim : nDstSamples))
+    return icCmmStatAllocErr;
+
+  icFloatVector src((size_t)nGrid * nDim);
+  icFloatVector grid((size_t)nGrid * nDstSamples);
+
+  for (n = 0; n < nGrid; n++) {
+    icUInt32Number nIdx = n;
+    for (i = nDim; i > 0; i--) {
+      j = nIdx % m_nInitGridPoints;
+      nIdx /= m_nInitGridPoints;
+      src[(size_t)n * nDim + i - 1] = (icFloatNumber)j / (icFloatNumber)(m_nInitGridPoints - 1);
+    }
+  }
+
+  icStatusCMM rv = pApply->Apply(&grid[0], &src[0], nGrid);
+  pApply->m_bHaveLast = false;
+  checkCmmStatus(rv);
+
+  m_initGrid.swap(grid);
+  m_nInitGridDim = nDim;
+
+  return icCmmStatOk;
+}
+
 //Call to Detach and remove all pending IO objects attached to the profiles used by the CMM. Should be called only after Begin()
 icStatusCMM CIccCmmSearch::RemoveAllIO()
 {
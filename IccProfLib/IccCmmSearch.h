@@ -82,6 +82,21 @@ typedef std::shared_ptr<CIccCmm> CIccCmmPtr;
 typedef std::vector<CIccCmmPtr> CIccCmmPtrArray;
 typedef std::vector<IIccProfileConnectionConditions*> CIccPccPtrArray;
 typedef std::vector<icFloatVector> CIccPixelArray;
+typedef std::shared_ptr<CIccApplyCmm> CIccApplyCmmPtr;
+typedef std::vector<CIccApplyCmmPtr> CIccApplyCmmPtrArray;
+
+class CIccSearchWorker;
+typedef std::vector<CIccSearchWorker*> CIccSearchWorkerList;
+
+//Fewest pixels worth handing to an extra thread in a batch Apply
+#define ICC_SEARCH_MIN_THREAD_PIXELS 16
+
+//Largest number of source channels that an initial search grid is built for
+#define ICC_SEARCH_GRID_MAXDIM 4
+//Largest number of points per channel of an initial search grid
+#define ICC_SEARCH_GRID_MAXPOINTS 33
+//Initial simplex step used when refining a start taken from the grid
+#define ICC_SEARCH_REFINE_STEP 0.005f
 
 /**
 **************************************************************************
@@ -95,6 +110,7 @@ typedef std::vector<icFloatVector> CIccPixelArray;
 class ICCPROFLIB_API CIccApplyCmmSearch : public CIccApplyCmm, public CIccMinSearch
 {
   friend class CIccCmmSearch;
+  friend class CIccSearchWorker;
 public:
   virtual ~CIccApplyCmmSearch();
 
@@ -110,11 +126,32 @@ public:
 protected:
   CIccApplyCmmSearch(CIccCmm* pCmm);
 
+  icStatusCMM Init();
+  icStatusCMM ApplyPixels(icFloatNumber* DstPixel, const icFloatNumber* SrcPixel, icUInt32Number nPixels);
+  icFloatNumber startCost(CIccSearchVec& point);
+  bool gridStart(CIccSearchVec& start, const icFloatNumber* SrcPixel) const;
+
+  //Apply objects of their own so that several searches can run at once
+  CIccApplyCmmPtrArray m_src_to_mid;
+  CIccApplyCmmPtrArray m_dst_to_mid;
+  CIccApplyCmmPtr m_mid_to_dst;
+
+  //Threads (each with its own apply object) kept between batch Apply calls
+  CIccSearchWorkerList m_workers;
+
   CIccPixelArray m_mid_data;
   icFloatVector m_pixel;
   icFloatVector m_startPixel;
   size_t m_nApply;
   icUInt16Number m_nSamples;
+  icUInt16Number m_nSrcSamples;
+  icUInt16Number m_nSearchSamples;
+
+  //Result of the previous pixel, reused for repeated pixels and as a warm start
+  bool m_bWarmStart;
+  bool m_bHaveLast;
+  icFloatVector m_lastSrc;
+  CIccSearchVec m_lastResult;
 
   bool m_bUnitBounds;
   icFloatVector m_minBounds;
@@ -157,6 +194,20 @@ public:
 
   icStatusCMM AttachPCC(IIccProfileConnectionConditions* pPCC, icFloatNumber dWeight);
 
+  //Number of threads used by the batch Apply (default 1)
+  void SetApplyThreads(icUInt32Number nThreads) { m_nApplyThreads = nThreads ? nThreads : 1; }
+  icUInt32Number GetApplyThreads() const { return m_nApplyThreads; }
+
+  //Start each search from the previous pixel's result when that costs less than the initial estimate
+  void SetWarmStart(bool bWarmStart) { m_bWarmStart = bWarmStart; }
+  bool GetWarmStart() const { return m_bWarmStart; }
+
+  //Number of points per source channel in a grid of search results tabulated by Begin() and
+  //interpolated to start each search (0 = no grid).  Only used when the source has at most
+  //ICC_SEARCH_GRID_MAXDIM channels.  Larger values are limited to ICC_SEARCH_GRID_MAXPOINTS.
+  void SetInitGridPoints(icUInt32Number nGridPoints);
+  icUInt32Number GetInitGridPoints() const { return m_nInitGridPoints; }
+
   //The Begin function should be called before Apply or GetNewApplyCmm()
   virtual icStatusCMM Begin(bool bAllocNewApply = true, bool bUsePcsConversion = false);
 
@@ -180,6 +231,15 @@ protected:
   icFloatVector m_maxBounds;
 
   bool m_bNeedPcsToLab;
+
+  icUInt32Number m_nApplyThreads = 1;
+  bool m_bWarmStart = false;
+
+  icStatusCMM BuildInitGrid(CIccApplyCmmSearch* pApply);
+
+  icUInt32Number m_nInitGridPoints = 0;
+  icUInt32Number m_nInitGridDim = 0;
+  icFloatVector m_initGrid;
   
   CIccProfile* m_pSrcProfile = nullptr;
   icRenderingIntent m_nSrcIntent;
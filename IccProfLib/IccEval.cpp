@@ -69,6 +69,8 @@ Copyright:  (c) see ICC Software License
 //////////////////////////////////////////////////////////////////////
 
 #include <math.h>
+#include <thread>
+#include <vector>
 #include "IccEval.h"
 #include "IccTag.h"
 
@@ -127,9 +129,6 @@ icStatusCMM CIccEvalCompare::EvaluateProfile(CIccProfile *pProfile, icUInt8Numbe
     return result;
   }
 
-  icFloatNumber sPixel[15];
-  icFloatNumber devPcs[15], roundPcs1[15], roundPcs2[15];
-
   const int ndim = icGetSpaceSamples(pProfile->m_Header.colorSpace);
   // safety, and add hints for static analysis
   if (ndim < 1)
@@ -155,6 +154,33 @@ icStatusCMM CIccEvalCompare::EvaluateProfile(CIccProfile *pProfile, icUInt8Numbe
     }
   }
 
+  // each thread converts its share of a block with its own apply objects
+  std::vector<CIccApplyCmm*> dev2LabApply, roundApply;
+  icUInt32Number t;
+
+  for (t=0; t<m_nThreads; t++) {
+    CIccApplyCmm *pDev2Lab = dev2Lab.GetNewApplyCmm(result);
+    if (!pDev2Lab)
+      break;
+
+    CIccApplyCmm *pLab2Dev2Lab = Lab2Dev2Lab.GetNewApplyCmm(result);
+    if (!pLab2Dev2Lab) {
+      delete pDev2Lab;
+      break;
+    }
+
+    dev2LabApply.push_back(pDev2Lab);
+    roundApply.push_back(pLab2Dev2Lab);
+  }
+
+  if (dev2LabApply.empty())
+    return result;
+
+  const icUInt32Number nApply = (icUInt32Number)dev2LabApply.size();
+  const icUInt32Number nBlock = nApply * ICC_EVAL_BLOCK_PIXELS;
+  std::vector<icFloatNumber> sPixels((size_t)nBlock*ndim);
+  std::vector<icFloatNumber> devPcs((size_t)nBlock*3), roundPcs1((size_t)nBlock*3), roundPcs2((size_t)nBlock*3);
+
   // ccox - what the heck are we trying to do with steps? We don't really use the values.
   const icFloatNumber stepsize = (icFloatNumber)(1.0/(icFloatNumber)(nGran-1));
   const icFloatNumber nstart = 0.0;
@@ -165,31 +191,79 @@ icStatusCMM CIccEvalCompare::EvaluateProfile(CIccProfile *pProfile, icUInt8Numbe
   }
 
   while ( steps[0] == nstart ) {
-    for(int j=0; j<ndim; j++) {
-      sPixel[j] = icMin(steps[j+1],1.0);
+    icUInt32Number nPixels;
+
+    for (nPixels=0; nPixels<nBlock && steps[0] == nstart; nPixels++) {
+      icFloatNumber *sPixel = &sPixels[(size_t)nPixels*ndim];
+
+      for(int j=0; j<ndim; j++) {
+        sPixel[j] = icMin(steps[j+1],1.0);
+      }
+      steps[ndim] = (steps[ndim]+stepsize);
+
+      // NOTE - if i == 0, then we cannot access steps[i-1], but steps[0] should always be zero
+      for(int i=ndim; i>0; i--) {
+        if ( steps[i] > nEnd ) {
+          steps[i] = nstart;
+          steps[i-1] = (steps[i-1]+stepsize);
+        }
+        else break;
+      }
     }
-    steps[ndim] = (steps[ndim]+stepsize);
-    
-    // NOTE - if i == 0, then we cannot access steps[i-1], but steps[0] should always be zero
-    for(int i=ndim; i>0; i--) {
-      if ( steps[i] > nEnd ) {
-        steps[i] = nstart;
-        steps[i-1] = (steps[i-1]+stepsize);
+
+    icUInt32Number nRun = (nPixels + nApply - 1) / nApply;
+    std::vector<std::thread> pool;
+
+    for (t=0; t*nRun<nPixels; t++) {
+      icUInt32Number nFirst = t*nRun;
+      icUInt32Number nCount = nPixels - nFirst < nRun ? nPixels - nFirst : nRun;
+      CIccApplyCmm *pDev2Lab = dev2LabApply[t];
+      CIccApplyCmm *pLab2Dev2Lab = roundApply[t];
+      const icFloatNumber *pPixels = &sPixels[(size_t)nFirst*ndim];
+      icFloatNumber *pDevPcs = &devPcs[(size_t)nFirst*3];
+      icFloatNumber *pRoundPcs1 = &roundPcs1[(size_t)nFirst*3];
+      icFloatNumber *pRoundPcs2 = &roundPcs2[(size_t)nFirst*3];
+
+      auto roundTrip = [=]() {
+        pDev2Lab->Apply(pDevPcs, pPixels, nCount); //Convert device value to pcs from input table
+        pLab2Dev2Lab->Apply(pRoundPcs1, pDevPcs, nCount);  //First round trip gets color into output gamut
+        pLab2Dev2Lab->Apply(pRoundPcs2, pRoundPcs1, nCount);  //Second round trip find reproducibility error
+      };
+
+      if (!t) {
+        roundTrip();
+        continue;
+      }
+
+      try {
+        pool.push_back(std::thread(roundTrip));
+      }
+      catch (...) {
+        roundTrip();
       }
-      else break;
     }
 
-    dev2Lab.Apply(devPcs, sPixel); //Convert device value to pcs from input table
-    Lab2Dev2Lab.Apply(roundPcs1, devPcs);  //First round trip gets color into output gamut
-    Lab2Dev2Lab.Apply(roundPcs2, roundPcs1);  //Second round trip find reproducibility error
+    for (t=0; t<(icUInt32Number)pool.size(); t++)
+      pool[t].join();
 
-    icLabFromPcs(devPcs);
-    icLabFromPcs(roundPcs1);
-    icLabFromPcs(roundPcs2);
+    for (icUInt32Number k=0; k<nPixels; k++) {
+      icFloatNumber *pDevLab = &devPcs[(size_t)k*3];
+      icFloatNumber *pLab1 = &roundPcs1[(size_t)k*3];
+      icFloatNumber *pLab2 = &roundPcs2[(size_t)k*3];
 
-    Compare(sPixel, devPcs, roundPcs1, roundPcs2);
+      icLabFromPcs(pDevLab);
+      icLabFromPcs(pLab1);
+      icLabFromPcs(pLab2);
+
+      Compare(&sPixels[(size_t)k*ndim], pDevLab, pLab1, pLab2);
+    }
   }
-  
+
+  for (t=0; t<nApply; t++) {
+    delete dev2LabApply[t];
+    delete roundApply[t];
+  }
+
   return icCmmStatOk;
 }
 
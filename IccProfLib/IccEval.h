@@ -74,8 +74,14 @@ namespace iccDEV {
 #endif
 
 
+//Number of grid points converted by each evaluation thread between calls to Compare
+#define ICC_EVAL_BLOCK_PIXELS 4096
+
 class CIccEvalCompare {
 public:
+  CIccEvalCompare() { m_nThreads = 1; }
+  virtual ~CIccEvalCompare() {}
+
   //Create prototype for Compare function that must be implemented by a derived class
   virtual void Compare(icFloatNumber *pPixel, icFloatNumber *deviceLab, icFloatNumber *destLab1, icFloatNumber *destLab2)=0;
 
@@ -86,6 +92,14 @@ public:
   icStatusCMM ICCPROFLIB_API EvaluateProfile(const icChar *szProfilePath, icUInt8Number nGran=0, 
                                              icRenderingIntent nIntent=icUnknownIntent, icXformInterp nInterp=icInterpLinear,
                                              bool buseMpeTags=true);
+
+  //Number of threads used to convert grid points (default 1).  Compare is always called
+  //from the calling thread in grid order.
+  void SetThreads(icUInt32Number nThreads) { m_nThreads = nThreads ? nThreads : 1; }
+  icUInt32Number GetThreads() const { return m_nThreads; }
+
+protected:
+  icUInt32Number m_nThreads;
 };
 
 #ifdef USEICCDEVNAMESPACE
@@ -74,6 +74,19 @@
 #include <memory.h>
 #include <string.h>
 
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(__F16C__)
+#include <immintrin.h>
+#endif
+
 #ifndef __max
 #define __max(a,b)  (((a) > (b)) ? (a) : (b))
 #endif
@@ -89,6 +102,53 @@ namespace iccDEV {
 // Class CIccIO
 //////////////////////////////////////////////////////////////////////
 
+//Number of elements converted per Read8 or Write8 call by the bulk readers
+//and writers
+#define ICC_IO_BULK_CHUNK 2048
+
+#ifdef ICC_BYTE_ORDER_LITTLE_ENDIAN
+/**
+ **************************************************************************
+ * Name: icSwab16Block / icSwab32Block
+ * 
+ * Purpose: 
+ *  Byte swap arrays of 16 or 32 bit values in place using SSE2 shifts and
+ *  shuffles for the bulk of the array.
+ **************************************************************************
+ */
+static void icSwab16Block(void *pVoid, size_t num)
+{
+  icUInt8Number *ptr = (icUInt8Number*)pVoid;
+
+#if defined(__SSE2__) || defined(_M_X64)
+  for (; num>=8; num-=8, ptr+=16) {
+    __m128i v = _mm_loadu_si128((const __m128i*)ptr);
+    v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+    _mm_storeu_si128((__m128i*)ptr, v);
+  }
+#endif
+
+  icSwab16Array(ptr, num);
+}
+
+static void icSwab32Block(void *pVoid, size_t num)
+{
+  icUInt8Number *ptr = (icUInt8Number*)pVoid;
+
+#if defined(__SSE2__) || defined(_M_X64)
+  for (; num>=4; num-=4, ptr+=16) {
+    __m128i v = _mm_loadu_si128((const __m128i*)ptr);
+    v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+    v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+    v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+    _mm_storeu_si128((__m128i*)ptr, v);
+  }
+#endif
+
+  icSwab32Array(ptr, num);
+}
+#endif
+
 
 size_t CIccIO::ReadLine(void *pBuf8, size_t nNum/*=256*/)
 {
@@ -121,7 +181,7 @@ size_t CIccIO::Read16(void *pBuf16, size_t nNum)
 
   nNum = Read8(pBuf16, nNum<<1)>>1;
 #ifdef ICC_BYTE_ORDER_LITTLE_ENDIAN
-  icSwab16Array(pBuf16, nNum);
+  icSwab16Block(pBuf16, nNum);
 #endif
 
   return nNum;
@@ -135,19 +195,23 @@ size_t CIccIO::Write16(void *pBuf16, size_t nNum)
 #ifndef ICC_BYTE_ORDER_LITTLE_ENDIAN
   return Write8(pBuf16, nNum<<1)>>1;
 #else
-  icUInt16Number *ptr = (icUInt16Number*)pBuf16;
-  icUInt16Number tmp;
-  size_t i;
-
-  for (i=0; i<nNum; i++) {
-    tmp = *ptr;
-    icSwab16(tmp);
-    if (Write8(&tmp, 2)!=2)
+  const icUInt16Number *ptr = (const icUInt16Number*)pBuf16;
+  icUInt16Number tmp[ICC_IO_BULK_CHUNK];
+  size_t n, nWritten, nTotal=0;
+
+  while (nTotal<nNum) {
+    n = __min(nNum-nTotal, ICC_IO_BULK_CHUNK);
+    memcpy(tmp, ptr, n*sizeof(icUInt16Number));
+    icSwab16Block(tmp, n);
+
+    nWritten = Write8(tmp, n<<1)>>1;
+    ptr += nWritten;
+    nTotal += nWritten;
+    if (nWritten!=n)
       break;
-    ptr++;
   }
 
-  return i;
+  return nTotal;
 #endif
 }
 
@@ -158,7 +222,7 @@ size_t CIccIO::Read32(void *pBuf32, size_t nNum)
 
   nNum = Read8(pBuf32, nNum<<2)>>2;
 #ifdef ICC_BYTE_ORDER_LITTLE_ENDIAN
-  icSwab32Array(pBuf32, nNum);
+  icSwab32Block(pBuf32, nNum);
 #endif
 
   return nNum;
@@ -173,19 +237,23 @@ size_t CIccIO::Write32(void *pBuf32, size_t nNum)
 #ifndef ICC_BYTE_ORDER_LITTLE_ENDIAN
   return Write8(pBuf32, nNum<<2)>>2;
 #else
-  icUInt32Number *ptr = (icUInt32Number*)pBuf32;
-  icUInt32Number tmp;
-  size_t i;
-
-  for (i=0; i<nNum; i++) {
-    tmp = *ptr;
-    icSwab32(tmp);
-    if (Write8(&tmp, 4)!=4)
+  const icUInt32Number *ptr = (const icUInt32Number*)pBuf32;
+  icUInt32Number tmp[ICC_IO_BULK_CHUNK];
+  size_t n, nWritten, nTotal=0;
+
+  while (nTotal<nNum) {
+    n = __min(nNum-nTotal, ICC_IO_BULK_CHUNK);
+    memcpy(tmp, ptr, n*sizeof(icUInt32Number));
+    icSwab32Block(tmp, n);
+
+    nWritten = Write8(tmp, n<<2)>>2;
+    ptr += nWritten;
+    nTotal += nWritten;
+    if (nWritten!=n)
       break;
-    ptr++;
   }
 
-  return i;
+  return nTotal;
 #endif
 }
 
@@ -211,19 +279,23 @@ size_t CIccIO::Write64(void *pBuf64, size_t nNum)
 #ifndef ICC_BYTE_ORDER_LITTLE_ENDIAN
   return Write8(pBuf64, nNum<<3)>>3;
 #else
-  icUInt64Number *ptr = (icUInt64Number*)pBuf64;
-  icUInt64Number tmp;
-  size_t i;
-
-  for (i=0; i<nNum; i++) {
-    tmp = *ptr;
-    icSwab64(tmp);
-    if (Write8(&tmp, 8)!=8)
+  const icUInt64Number *ptr = (const icUInt64Number*)pBuf64;
+  icUInt64Number tmp[ICC_IO_BULK_CHUNK];
+  size_t n, nWritten, nTotal=0;
+
+  while (nTotal<nNum) {
+    n = __min(nNum-nTotal, ICC_IO_BULK_CHUNK);
+    memcpy(tmp, ptr, n*sizeof(icUInt64Number));
+    icSwab64Array(tmp, n);
+
+    nWritten = Write8(tmp, n<<3)>>3;
+    ptr += nWritten;
+    nTotal += nWritten;
+    if (nWritten!=n)
       break;
-    ptr++;
   }
 
-  return i;
+  return nTotal;
 #endif
 }
 
@@ -233,37 +305,48 @@ size_t CIccIO::ReadUInt8Float(void *pBufFloat, size_t nNum)
     return 0;
 
   icFloatNumber *ptr = (icFloatNumber*)pBufFloat;
-  icUInt8Number tmp;
-  size_t i;
+  icUInt8Number tmp[ICC_IO_BULK_CHUNK];
+  size_t i, n, nRead, nTotal=0;
 
-  for (i=0; i<nNum; i++) {
-    if (Read8(&tmp, 1)!=1)
+  while (nTotal<nNum) {
+    n = __min(nNum-nTotal, ICC_IO_BULK_CHUNK);
+    nRead = Read8(tmp, n);
+
+    for (i=0; i<nRead; i++)
+      ptr[i] = (icFloatNumber)((icFloatNumber)tmp[i] / 255.0);
+
+    ptr += nRead;
+    nTotal += nRead;
+    if (nRead!=n)
       break;
-    *ptr = (icFloatNumber)((icFloatNumber)tmp / 255.0);
-    ptr++;
   }
 
-  return i;
+  return nTotal;
 }
 
-size_t CIccIO::WriteUInt8Float(void *pBufFloat, size_t nNum)
+size_t CIccIO::WriteUInt8Float(const void *pBufFloat, size_t nNum)
 {
   if (!pBufFloat)
     return 0;
 
-  icFloatNumber *ptr = (icFloatNumber*)pBufFloat;
-  icUInt8Number tmp;
-  size_t i;
+  const icFloatNumber *ptr = (const icFloatNumber*)pBufFloat;
+  icUInt8Number tmp[ICC_IO_BULK_CHUNK];
+  size_t i, n, nWritten, nTotal=0;
 
-  for (i=0; i<nNum; i++) {
-    tmp = (icUInt8Number)(__max(0.0, __min(1.0, *ptr)) * 255.0 + 0.5);
+  while (nTotal<nNum) {
+    n = __min(nNum-nTotal, ICC_IO_BULK_CHUNK);
 
-    if (Write8(&tmp, 1)!=1)
+    for (i=0; i<n; i++)
+      tmp[i] = (icUInt8Number)(__max(0.0, __min(1.0, ptr[i])) * 255.0 + 0.5);
+
+    nWritten = Write8(tmp, n);
+    ptr += nWritten;
+    nTotal += nWritten;
+    if (nWritten!=n)
       break;
-    ptr++;
   }
 
-  return i;
+  return nTotal;
 }
 
 size_t CIccIO::ReadUInt16Float(void *pBufFloat, size_t nNum)
@@ -272,37 +355,48 @@ size_t CIccIO::ReadUInt16Float(void *pBufFloat, size_t nNum)
     return 0;
 
   icFloatNumber *ptr = (icFloatNumber*)pBufFloat;
-  icUInt16Number tmp;
-  size_t i;
+  icUInt16Number tmp[ICC_IO_BULK_CHUNK];
+  size_t i, n, nRead, nTotal=0;
 
-  for (i=0; i<nNum; i++) {
-    if (Read16(&tmp, 1)!=1)
+  while (nTotal<nNum) {
+    n = __min(nNum-nTotal, ICC_IO_BULK_CHUNK);
+    nRead = Read16(tmp, n);
+
+    for (i=0; i<nRead; i++)
+      ptr[i] = (icFloatNumber)((icFloatNumber)tmp[i] / 65535.0);
+
+    ptr += nRead;
+    nTotal += nRead;
+    if (nRead!=n)
       break;
-    *ptr = (icFloatNumber)((icFloatNumber)tmp / 65535.0);
-    ptr++;
   }
 
-  return i;
+  return nTotal;
 }
 
-size_t CIccIO::WriteUInt16Float(void *pBufFloat, size_t nNum)
+size_t CIccIO::WriteUInt16Float(const void *pBufFloat, size_t nNum)
 {
   if (!pBufFloat)
     return 0;
 
-  icFloatNumber *ptr = (icFloatNumber*)pBufFloat;
-  icUInt16Number tmp;
-  size_t i;
+  const icFloatNumber *ptr = (const icFloatNumber*)pBufFloat;
+  icUInt16Number tmp[ICC_IO_BULK_CHUNK];
+  size_t i, n, nWritten, nTotal=0;
 
-  for (i=0; i<nNum; i++) {
-    tmp = (icUInt16Number)(__max(0.0, __min(1.0, *ptr)) * 65535.0 + 0.5);
+  while (nTotal<nNum) {
+    n = __min(nNum-nTotal, ICC_IO_BULK_CHUNK);
+
+    for (i=0; i<n; i++)
+      tmp[i] = (icUInt16Number)(__max(0.0, __min(1.0, ptr[i])) * 65535.0 + 0.5);
 
-    if (Write16(&tmp, 1)!=1)
+    nWritten = Write16(tmp, n);
+    ptr += nWritten;
+    nTotal += nWritten;
+    if (nWritten!=n)
       break;
-    ptr++;
   }
 
-  return i;
+  return nTotal;
 }
 
 size_t CIccIO::ReadFloat16Float(void *pBufFloat, size_t nNum)
@@ -311,37 +405,56 @@ size_t CIccIO::ReadFloat16Float(void *pBufFloat, size_t nNum)
     return 0;
 
   icFloatNumber *ptr = (icFloatNumber*)pBufFloat;
-  icFloat16Number tmp;
-  size_t i;
+  icFloat16Number tmp[ICC_IO_BULK_CHUNK];
+  size_t i, n, nRead, nTotal=0;
+
+  while (nTotal<nNum) {
+    n = __min(nNum-nTotal, ICC_IO_BULK_CHUNK);
+    nRead = Read16(tmp, n);
+
+    i = 0;
+#if defined(__F16C__)
+    //F16C conversion matches icF16toF except for the bit pattern of NaNs
+    if (sizeof(icFloatNumber)==sizeof(float)) {
+      for (; i+8<=nRead; i+=8)
+        _mm256_storeu_ps((float*)ptr+i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(tmp+i))));
+    }
+#endif
+    for (; i<nRead; i++)
+      ptr[i] = icF16toF(tmp[i]);
 
-  for (i=0; i<nNum; i++) {
-    if (Read16(&tmp, 1)!=1)
+    ptr += nRead;
+    nTotal += nRead;
+    if (nRead!=n)
       break;
-    *ptr = icF16toF(tmp);
-    ptr++;
   }
 
-  return i;
+  return nTotal;
 }
 
-size_t CIccIO::WriteFloat16Float(void *pBufFloat, size_t nNum)
+size_t CIccIO::WriteFloat16Float(const void *pBufFloat, size_t nNum)
 {
   if (!pBufFloat)
     return 0;
 
-  icFloatNumber *ptr = (icFloatNumber*)pBufFloat;
-  icUInt16Number tmp;
-  size_t i;
+  const icFloatNumber *ptr = (const icFloatNumber*)pBufFloat;
+  icUInt16Number tmp[ICC_IO_BULK_CHUNK];
+  size_t i, n, nWritten, nTotal=0;
 
-  for (i=0; i<nNum; i++) {
-    tmp = icFtoF16(*ptr);
+  while (nTotal<nNum) {
+    n = __min(nNum-nTotal, ICC_IO_BULK_CHUNK);
+
+    for (i=0; i<n; i++)
+      tmp[i] = icFtoF16(ptr[i]);
 
-    if (Write16(&tmp, 1)!=1)
+    nWritten = Write16(tmp, n);
+    ptr += nWritten;
+    nTotal += nWritten;
+    if (nWritten!=n)
       break;
-    ptr++;
   }
 
-  return i;
+  return nTotal;
 }
 
 size_t CIccIO::ReadFloat32Float(void *pBufFloat, size_t nNum)
@@ -366,15 +479,15 @@ size_t CIccIO::ReadFloat32Float(void *pBufFloat, size_t nNum)
   return i;
 }
 
-size_t CIccIO::WriteFloat32Float(void *pBufFloat, size_t nNum)
+size_t CIccIO::WriteFloat32Float(const void *pBufFloat, size_t nNum)
 {
   if (sizeof(icFloat32Number)==sizeof(icFloatNumber))
-    return Write32(pBufFloat, nNum);
+    return Write32((void*)pBufFloat, nNum);
 
   if (!pBufFloat)
     return 0;
 
-  icFloatNumber *ptr = (icFloatNumber*)pBufFloat;
+  const icFloatNumber *ptr = (const icFloatNumber*)pBufFloat;
   icFloat32Number tmp;
   size_t i;
 
@@ -423,6 +536,12 @@ bool CIccIO::Sync32(size_t nOffset)
 CIccFileIO::CIccFileIO() : CIccIO()
 {
   m_fFile = NULL;
+
+  m_pBuf = NULL;
+  m_nBufLen = 0;
+  m_nBufOffset = 0;
+  m_nBufPos = 0;
+  m_nLength = -1;
 }
 
 CIccFileIO::~CIccFileIO()
@@ -444,10 +563,13 @@ bool CIccFileIO::Open(const icChar *szFilename, const icChar *szAttr)
 #endif
 
   if (m_fFile)
-    fclose(m_fFile);
+    Close();
 
   m_fFile = fopen(szFilename, szAttr);
 
+  if (m_fFile)
+    SetReadBuffered(szAttr);
+
   return m_fFile != NULL;
 }
 
@@ -465,19 +587,76 @@ bool CIccFileIO::Open(const icWChar *szFilename, const icWChar *szAttr)
   }
 
   if (m_fFile)
-    fclose(m_fFile);
+    Close();
 
   m_fFile = _wfopen(szFilename, szAttr);
 
+  if (m_fFile) {
+    char attr[20];
+    size_t i;
+    for (i=0; szAttr[i] && i<sizeof(attr)-1; i++)
+      attr[i] = (char)szAttr[i];
+    attr[i] = 0;
+    SetReadBuffered(attr);
+  }
+
   return m_fFile != NULL;
 }
 #endif
 
 
+//Size of the read buffer used for files opened read only
+#define ICC_FILEIO_BUFSIZE 65536
+
+/**
+ **************************************************************************
+ * Name: CIccFileIO::SetReadBuffered
+ * 
+ * Purpose: 
+ *  Switches to buffered read mode when the file was opened read only.
+ *  The length of a read only file is cached since it cannot change.
+ **************************************************************************
+ */
+void CIccFileIO::SetReadBuffered(const char *szAttr)
+{
+  FreeReadBuffer();
+
+  if (szAttr[0]!='r' || strchr(szAttr, '+'))
+    return;
+
+  fseek(m_fFile, 0, SEEK_END);
+  m_nLength = ftell(m_fFile);
+  fseek(m_fFile, 0, SEEK_SET);
+
+  if (m_nLength<0) {
+    m_nLength = -1;
+    return;
+  }
+
+  m_pBuf = (icUInt8Number*)malloc(ICC_FILEIO_BUFSIZE);
+  m_nBufLen = 0;
+  m_nBufOffset = 0;
+  m_nBufPos = 0;
+}
+
+
+void CIccFileIO::FreeReadBuffer()
+{
+  if (m_pBuf) {
+    free(m_pBuf);
+    m_pBuf = NULL;
+  }
+  m_nBufLen = 0;
+  m_nBufOffset = 0;
+  m_nBufPos = 0;
+  m_nLength = -1;
+}
+
+
 bool CIccFileIO::Attach(FILE *f)
 {
   if (m_fFile)
-    fclose(m_fFile);
+    Close();
 
   m_fFile = f;
 
@@ -487,12 +666,19 @@ bool CIccFileIO::Attach(FILE *f)
 
 void CIccFileIO::Detach()
 {
+  //Leave the stream at the logical read position
+  if (m_fFile && m_pBuf)
+    fseek(m_fFile, (long)(m_nBufPos + m_nBufOffset), SEEK_SET);
+  FreeReadBuffer();
+
   m_fFile = NULL;
 }
 
 
 void CIccFileIO::Close()
 {
+  FreeReadBuffer();
+
   if (m_fFile) {
     fclose(m_fFile);
     m_fFile = NULL;
@@ -505,13 +691,48 @@ size_t CIccFileIO::Read8(void *pBuf, size_t nNum)
   if (!m_fFile || !pBuf)
     return 0;
 
-  return fread(pBuf, 1, nNum, m_fFile);
+  if (!m_pBuf)
+    return fread(pBuf, 1, nNum, m_fFile);
+
+  icUInt8Number *pDst = (icUInt8Number*)pBuf;
+  size_t nRead = 0;
+
+  while (nRead<nNum) {
+    size_t nAvail = m_nBufLen - m_nBufOffset;
+
+    if (!nAvail) {
+      //Stream position is always at the end of the buffered data
+      m_nBufPos += m_nBufLen;
+      m_nBufLen = 0;
+      m_nBufOffset = 0;
+
+      //Large reads bypass the buffer
+      if (nNum-nRead >= ICC_FILEIO_BUFSIZE) {
+        size_t n = fread(pDst+nRead, 1, nNum-nRead, m_fFile);
+        m_nBufPos += n;
+        nRead += n;
+        break;
+      }
+
+      m_nBufLen = fread(m_pBuf, 1, ICC_FILEIO_BUFSIZE, m_fFile);
+      if (!m_nBufLen)
+        break;
+      nAvail = m_nBufLen;
+    }
+
+    size_t n = __min(nAvail, nNum-nRead);
+    memcpy(pDst+nRead, m_pBuf+m_nBufOffset, n);
+    m_nBufOffset += n;
+    nRead += n;
+  }
+
+  return nRead;
 }
 
 
 size_t CIccFileIO::Write8(void *pBuf, size_t nNum)
 {
-  if (!m_fFile || !pBuf)
+  if (!m_fFile || !pBuf || m_pBuf)
     return 0;
 
   return fwrite(pBuf, 1, nNum, m_fFile);
@@ -523,6 +744,9 @@ size_t CIccFileIO::GetLength()
   if (!m_fFile)
     return 0;
 
+  if (m_nLength>=0)
+    return (size_t)m_nLength;
+
   fflush(m_fFile);
   size_t current = ftell(m_fFile);
   fseek (m_fFile, 0, SEEK_END);
@@ -537,7 +761,41 @@ int64_t CIccFileIO::Seek(int64_t nOffset, icSeekVal pos)
   if (!m_fFile)
     return -1;
 
-  return !fseek(m_fFile, nOffset, pos) ? ftell(m_fFile) : -1;
+  if (!m_pBuf)
+    return !fseek(m_fFile, nOffset, pos) ? ftell(m_fFile) : -1;
+
+  int64_t nPos;
+  switch(pos) {
+  case icSeekSet:
+    nPos = nOffset;
+    break;
+  case icSeekCur:
+    nPos = m_nBufPos + m_nBufOffset + nOffset;
+    break;
+  case icSeekEnd:
+    nPos = m_nLength + nOffset;
+    break;
+  default:
+    return -1;
+  }
+
+  if (nPos<0)
+    return -1;
+
+  //Seeks within the buffered data just move the read position
+  if (nPos>=m_nBufPos && nPos<=m_nBufPos+(int64_t)m_nBufLen) {
+    m_nBufOffset = (size_t)(nPos - m_nBufPos);
+    return nPos;
+  }
+
+  if (fseek(m_fFile, (long)nPos, SEEK_SET))
+    return -1;
+
+  m_nBufPos = nPos;
+  m_nBufLen = 0;
+  m_nBufOffset = 0;
+
+  return nPos;
 }
 
 
@@ -546,6 +804,9 @@ int64_t CIccFileIO::Tell()
   if (!m_fFile)
     return -1;
 
+  if (m_pBuf)
+    return m_nBufPos + m_nBufOffset;
+
   return ftell(m_fFile);
 }
 
@@ -705,6 +966,7 @@ CIccMemIO::CIccMemIO() : CIccIO()
   m_nPos = 0;
 
   m_bFreeData = false;
+  m_bGrowable = false;
 }
 
 CIccMemIO::~CIccMemIO()
@@ -788,6 +1050,16 @@ size_t CIccMemIO::Write8(void *pBuf, size_t nNum)
   if (!m_pData || !pBuf)
     return 0;
 
+  if (m_bGrowable && m_bFreeData && m_nPos + nNum > m_nAvail) {
+    size_t nAvail = __max(m_nAvail*2, m_nPos + nNum);
+    icUInt8Number *pData = (icUInt8Number*)realloc(m_pData, nAvail);
+
+    if (pData) {
+      m_pData = pData;
+      m_nAvail = nAvail;
+    }
+  }
+
   nNum = __min((m_nAvail-m_nPos), nNum);
 
   memcpy(m_pData + m_nPos, pBuf, nNum);
@@ -858,6 +1130,169 @@ int64_t CIccMemIO::Tell()
 
 ///////////////////////////////
 
+//////////////////////////////////////////////////////////////////////
+// Class CIccMmapIO
+//////////////////////////////////////////////////////////////////////
+
+CIccMmapIO::CIccMmapIO() : CIccMemIO()
+{
+#ifdef WIN32
+  m_hFile = INVALID_HANDLE_VALUE;
+  m_hMap = NULL;
+#else
+  m_nFile = -1;
+#endif
+  m_bMapped = false;
+}
+
+CIccMmapIO::~CIccMmapIO()
+{
+  Close();
+}
+
+
+#ifdef WIN32
+bool CIccMmapIO::Open(const icChar *szFilename)
+{
+  Close();
+
+  m_hFile = CreateFileA(szFilename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                        FILE_ATTRIBUTE_NORMAL, NULL);
+  if (m_hFile == INVALID_HANDLE_VALUE)
+    return false;
+
+  LARGE_INTEGER nSize;
+  if (!GetFileSizeEx((HANDLE)m_hFile, &nSize)) {
+    Close();
+    return false;
+  }
+
+  return Map((size_t)nSize.QuadPart);
+}
+
+
+bool CIccMmapIO::Open(const icWChar *szFilename)
+{
+  Close();
+
+  m_hFile = CreateFileW(szFilename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                        FILE_ATTRIBUTE_NORMAL, NULL);
+  if (m_hFile == INVALID_HANDLE_VALUE)
+    return false;
+
+  LARGE_INTEGER nSize;
+  if (!GetFileSizeEx((HANDLE)m_hFile, &nSize)) {
+    Close();
+    return false;
+  }
+
+  return Map((size_t)nSize.QuadPart);
+}
+
+
+bool CIccMmapIO::Map(size_t nSize)
+{
+  if (!nSize) {
+    Close();
+    return false;
+  }
+
+  m_hMap = CreateFileMappingA((HANDLE)m_hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (!m_hMap) {
+    Close();
+    return false;
+  }
+
+  void *pData = MapViewOfFile((HANDLE)m_hMap, FILE_MAP_READ, 0, 0, 0);
+  if (!pData) {
+    Close();
+    return false;
+  }
+
+  m_bMapped = true;
+
+  return Attach((icUInt8Number*)pData, nSize);
+}
+
+
+void CIccMmapIO::Close()
+{
+  if (m_bMapped && m_pData)
+    UnmapViewOfFile(m_pData);
+  m_bMapped = false;
+  m_pData = NULL;
+
+  if (m_hMap) {
+    CloseHandle((HANDLE)m_hMap);
+    m_hMap = NULL;
+  }
+  if (m_hFile != INVALID_HANDLE_VALUE) {
+    CloseHandle((HANDLE)m_hFile);
+    m_hFile = INVALID_HANDLE_VALUE;
+  }
+
+  CIccMemIO::Close();
+}
+
+#else
+
+bool CIccMmapIO::Open(const icChar *szFilename)
+{
+  Close();
+
+  m_nFile = open(szFilename, O_RDONLY);
+  if (m_nFile < 0)
+    return false;
+
+  struct stat st;
+  if (fstat(m_nFile, &st) || !S_ISREG(st.st_mode)) {
+    Close();
+    return false;
+  }
+
+  return Map((size_t)st.st_size);
+}
+
+
+bool CIccMmapIO::Map(size_t nSize)
+{
+  if (!nSize) {
+    Close();
+    return false;
+  }
+
+  void *pData = mmap(NULL, nSize, PROT_READ, MAP_PRIVATE, m_nFile, 0);
+  if (pData == MAP_FAILED) {
+    Close();
+    return false;
+  }
+
+  //The mapping keeps its own reference to the file
+  close(m_nFile);
+  m_nFile = -1;
+
+  m_bMapped = true;
+
+  return Attach((icUInt8Number*)pData, nSize);
+}
+
+
+void CIccMmapIO::Close()
+{
+  if (m_bMapped && m_pData)
+    munmap(m_pData, m_nSize);
+  m_bMapped = false;
+  m_pData = NULL;
+
+  if (m_nFile >= 0) {
+    close(m_nFile);
+    m_nFile = -1;
+  }
+
+  CIccMemIO::Close();
+}
+#endif
+
 //////////////////////////////////////////////////////////////////////
 // Class CIccNullIO
 //////////////////////////////////////////////////////////////////////
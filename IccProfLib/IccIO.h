@@ -70,6 +70,7 @@
 #include "IccDefs.h"
 #include "stdio.h"
 #include <stdint.h>
+#include <mutex>
 
 #ifdef USEICCDEVNAMESPACE
 namespace iccDEV {
@@ -114,16 +115,16 @@ public:
   size_t Write64(void *pBuf64, size_t nNum=1);
 
   size_t ReadUInt8Float(void *pBufFloat, size_t nNum=1);
-  size_t WriteUInt8Float(void *pBuf16, size_t nNum=1);
+  size_t WriteUInt8Float(const void *pBuf16, size_t nNum=1);
 
   size_t ReadUInt16Float(void *pBufFloat, size_t nNum=1);
-  size_t WriteUInt16Float(void *pBuf16, size_t nNum=1);
+  size_t WriteUInt16Float(const void *pBuf16, size_t nNum=1);
 
   size_t ReadFloat16Float(void *pBufFloat, size_t nNum=1);
-  size_t WriteFloat16Float(void *pBuf16, size_t nNum=1);
+  size_t WriteFloat16Float(const void *pBuf16, size_t nNum=1);
 
   size_t ReadFloat32Float(void *pBufFloat, size_t nNum=1);
-  size_t WriteFloat32Float(void *pBufFloat, size_t nNum=1);
+  size_t WriteFloat32Float(const void *pBufFloat, size_t nNum=1);
 
   virtual size_t GetLength() {return 0;}
 
@@ -135,13 +136,21 @@ public:
 
   ///Operation to make sure read position is evenly divisible by 4
   bool Sync32(size_t nOffset=0); 
+
+  ///Held while a profile seeks and reads deferred data so that all profiles
+  ///sharing this IO (see CIccProfile::CopyAttach) take turns
+  std::mutex &GetReadMutex() { return m_ReadMutex; }
+
+protected:
+  std::mutex m_ReadMutex;
 };
 
 /**
  **************************************************************************
  * Type: Class
  * 
- * Purpose: Handles generic File IO
+ * Purpose: Handles generic File IO.  Files opened read only are read
+ *  through an internal buffer and have their length cached.
  **************************************************************************
  */
 class ICCPROFLIB_API CIccFileIO : public CIccIO
@@ -168,8 +177,20 @@ public:
   virtual int64_t Seek(int64_t nOffset, icSeekVal pos);
   virtual int64_t Tell();
 
+  bool IsReadBuffered() const { return m_pBuf!=NULL; }
+
 protected:
+  void SetReadBuffered(const char *szAttr);
+  void FreeReadBuffer();
+
   FILE *m_fFile;
+
+  //Buffered read mode
+  icUInt8Number *m_pBuf;
+  size_t m_nBufLen;      //Number of valid bytes in m_pBuf
+  size_t m_nBufOffset;   //Read position within m_pBuf
+  int64_t m_nBufPos;     //File position of m_pBuf[0]
+  int64_t m_nLength;     //Cached file length
 };
 
 /**
@@ -222,6 +243,9 @@ public:
   bool Attach(icUInt8Number *pData, size_t nSize, bool bWrite=false);
   virtual void Close();
 
+  //Let writes past the end of an Alloc'd buffer grow it
+  void SetGrowable(bool bGrowable=true) { m_bGrowable = bGrowable; }
+
   virtual size_t Read8(void *pBuf, size_t nNum=1);
   virtual size_t Write8(void *pBuf, size_t nNum=1);
 
@@ -239,6 +263,49 @@ protected:
   size_t m_nPos;
 
   bool m_bFreeData;
+  bool m_bGrowable;
+};
+
+/**
+ **************************************************************************
+ * Type: Class
+ * 
+ * Purpose: Handles read only File IO through a memory mapping of the file.
+ *  Only pages that are actually read are brought into memory so profiles
+ *  that are opened with deferred tag loading only pay for the tags that
+ *  are used.
+ *
+ *  The mapping is only valid while the file keeps its size.  If another
+ *  process truncates the file, reading the missing pages raises SIGBUS
+ *  (EXCEPTION_IN_PAGE_ERROR on Windows) instead of returning a short
+ *  read.  Profiles kept attached to their file for deferred tag loading
+ *  therefore use CIccFileIO unless OpenIccProfile() is asked to map.
+ **************************************************************************
+ */
+class ICCPROFLIB_API CIccMmapIO : public CIccMemIO
+{
+public:
+  CIccMmapIO();
+  virtual ~CIccMmapIO();
+
+  bool Open(const icChar *szFilename);
+#ifdef WIN32
+  bool Open(const icWChar *szFilename);
+#endif
+  virtual void Close();
+
+  virtual size_t Write8(void * /*pBuf*/, size_t /*nNum*/=1) { return 0; }
+
+protected:
+  bool Map(size_t nSize);
+
+#ifdef WIN32
+  void *m_hFile;
+  void *m_hMap;
+#else
+  int m_nFile;
+#endif
+  bool m_bMapped;
 };
 
 /**
@@ -61,8 +61,10 @@ static unsigned char PADDING[64] = {
 
 /* F, G, H and I are basic MD5 functions.
  */
-#define F(x, y, z) (((x) & (y)) | ((~x) & (z)))
-#define G(x, y, z) (((x) & (z)) | ((y) & (~z)))
+/* F and G use the equivalent selection forms that need one less operation
+ */
+#define F(x, y, z) ((z) ^ ((x) & ((y) ^ (z))))
+#define G(x, y, z) ((y) ^ ((z) & ((x) ^ (y))))
 #define H(x, y, z) ((x) ^ (y) ^ (z))
 #define I(x, y, z) ((y) ^ ((x) | (~z)))
 
@@ -283,10 +285,15 @@ static void Encode (unsigned char *output, UINT4 *input, unsigned int len)
  */
 static void Decode (UINT4 *output, unsigned char *input, unsigned int len)
 {
+#ifdef ICC_BYTE_ORDER_LITTLE_ENDIAN
+  /* MD5 words are little endian so they can be copied directly */
+  memcpy(output, input, len);
+#else
   unsigned int i, j;
 
   for (i = 0, j = 0; j < len; i++, j += 4)
     output[i] = ((UINT4)input[j]) | (((UINT4)input[j+1]) << 8) |
       (((UINT4)input[j+2]) << 16) | (((UINT4)input[j+3]) << 24);
+#endif
 }
 
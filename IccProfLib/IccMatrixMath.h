@@ -94,6 +94,7 @@ public:
   virtual ~CIccMatrixMath();
 
   virtual void VectorMult(icFloatNumber *pDst, const icFloatNumber *pSrc) const;
+  void VectorMultBatch(icFloatNumber *pDst, const icFloatNumber *pSrc, icUInt32Number nVectors) const;
   virtual icUInt16Number GetCols() const { return m_nCols; }
   virtual icUInt16Number GetRows() const { return m_nRows; }
 
@@ -2543,6 +2543,15 @@ CIccSegmentedCurve::CIccSegmentedCurve()
   m_nReserved1 = 0;
   m_nReserved2 = 0;
 
+  m_pSegments = NULL;
+  m_pEndPoints = NULL;
+  m_nSegments = 0;
+  m_bSortedEndPoints = false;
+
+  m_nTableSize = 0;
+  m_pTable = NULL;
+  m_pTableSplit = NULL;
+  m_tableStart = m_tableEnd = m_tableScale = 0;
 }
 
 
@@ -2567,6 +2576,16 @@ CIccSegmentedCurve::CIccSegmentedCurve(const CIccSegmentedCurve &curve)
   }
   m_nReserved1 = curve.m_nReserved1;
   m_nReserved2 = curve.m_nReserved2;
+
+  m_pSegments = NULL;
+  m_pEndPoints = NULL;
+  m_nSegments = 0;
+  m_bSortedEndPoints = false;
+
+  m_nTableSize = curve.m_nTableSize;
+  m_pTable = NULL;
+  m_pTableSplit = NULL;
+  m_tableStart = m_tableEnd = m_tableScale = 0;
 }
 
 
@@ -2591,6 +2610,7 @@ CIccSegmentedCurve &CIccSegmentedCurve::operator=(const CIccSegmentedCurve &curv
   }
   m_nReserved1 = curve.m_nReserved1;
   m_nReserved2 = curve.m_nReserved2;
+  m_nTableSize = curve.m_nTableSize;
 
   return (*this);
 }
@@ -2823,6 +2843,8 @@ void CIccSegmentedCurve::Reset()
 {
   CIccCurveSegmentList::iterator i;
 
+  ResetApply();
+
   for (i=m_list->begin(); i!=m_list->end(); i++) {
     delete (*i);
   }
@@ -2830,6 +2852,37 @@ void CIccSegmentedCurve::Reset()
 }
 
 
+/**
+ ******************************************************************************
+ * Name: CIccSegmentedCurve::ResetApply
+ * 
+ * Purpose: 
+ *  Frees the segment array and dense table set up by Begin()
+ ******************************************************************************/
+void CIccSegmentedCurve::ResetApply()
+{
+  if (m_pSegments) {
+    delete [] m_pSegments;
+    m_pSegments = NULL;
+  }
+  if (m_pEndPoints) {
+    delete [] m_pEndPoints;
+    m_pEndPoints = NULL;
+  }
+  m_nSegments = 0;
+  m_bSortedEndPoints = false;
+
+  if (m_pTable) {
+    delete [] m_pTable;
+    m_pTable = NULL;
+  }
+  if (m_pTableSplit) {
+    delete [] m_pTableSplit;
+    m_pTableSplit = NULL;
+  }
+}
+
+
 /**
  ******************************************************************************
  * Name: CIccSegmentedCurve::Insert
@@ -2842,6 +2895,8 @@ void CIccSegmentedCurve::Reset()
  ******************************************************************************/
 bool CIccSegmentedCurve::Insert(CIccCurveSegment *pCurveSegment)
 {
+  ResetApply();
+
   CIccCurveSegmentList::reverse_iterator last = m_list->rbegin();
 
   if (last!=m_list->rend()) {
@@ -2871,6 +2926,8 @@ bool CIccSegmentedCurve::Insert(CIccCurveSegment *pCurveSegment)
  ******************************************************************************/
 bool CIccSegmentedCurve::Begin(icElemInterp /* nInterp */, CIccTagMultiProcessElement * /* pMPE */)
 {
+  ResetApply();
+
   if (m_list->size()==0)
     return false;
 
@@ -2883,6 +2940,64 @@ bool CIccSegmentedCurve::Begin(icElemInterp /* nInterp */, CIccTagMultiProcessEl
     pLast = *i;
   }
 
+  m_nSegments = (icUInt32Number)m_list->size();
+  m_pSegments = new CIccCurveSegment*[m_nSegments];
+  m_pEndPoints = new icFloatNumber[m_nSegments];
+
+  icUInt32Number n;
+  for (n=0, i=m_list->begin(); i!=m_list->end(); i++, n++) {
+    m_pSegments[n] = *i;
+    m_pEndPoints[n] = (*i)->EndPoint();
+  }
+
+  //The binary search only finds the first segment ending at or after v when
+  //the end points are in order, so malformed curves keep the linear scan
+  m_bSortedEndPoints = true;
+  for (n=1; n<m_nSegments; n++) {
+    if (!(m_pEndPoints[n-1] <= m_pEndPoints[n])) {
+      m_bSortedEndPoints = false;
+      break;
+    }
+  }
+
+  if (m_nTableSize>=2) {
+    //Table covers the unit range plus any finite break points between segments
+    m_tableStart = 0.0f;
+    m_tableEnd = 1.0f;
+    for (n=0; n+1<m_nSegments; n++) {
+      if (m_pEndPoints[n] < m_tableStart)
+        m_tableStart = m_pEndPoints[n];
+      if (m_pEndPoints[n] > m_tableEnd)
+        m_tableEnd = m_pEndPoints[n];
+    }
+
+    m_pTable = new icFloatNumber[m_nTableSize];
+    m_tableScale = (icFloatNumber)(m_nTableSize-1) / (m_tableEnd - m_tableStart);
+
+    for (n=0; n<m_nTableSize; n++) {
+      icFloatNumber v = m_tableStart + (icFloatNumber)n / m_tableScale;
+      m_pTable[n] = ApplySegments(v);
+    }
+
+    //Interpolating across a break point would smear the join between segments
+    //so cells containing one (and their neighbors to allow for rounding) are
+    //evaluated from the segments directly
+    m_pTableSplit = new icUInt8Number[m_nTableSize-1];
+    memset(m_pTableSplit, 0, m_nTableSize-1);
+
+    for (n=0; n+1<m_nSegments; n++) {
+      icFloatNumber p = (m_pEndPoints[n] - m_tableStart) * m_tableScale;
+      if (p < 0 || p > (icFloatNumber)(m_nTableSize-1))
+        continue;
+
+      icUInt32Number c = (icUInt32Number)p;
+      icUInt32Number first = c ? c-1 : 0;
+      icUInt32Number last = c+1 < m_nTableSize-1 ? c+1 : m_nTableSize-2;
+      for (; first<=last; first++)
+        m_pTableSplit[first] = 1;
+    }
+  }
+
   return true;
 }
 
@@ -2899,6 +3014,59 @@ bool CIccSegmentedCurve::Begin(icElemInterp /* nInterp */, CIccTagMultiProcessEl
  ******************************************************************************/
 icFloatNumber CIccSegmentedCurve::Apply(icFloatNumber v) const
 {
+  if (m_pTable && v>=m_tableStart && v<=m_tableEnd) {
+    icFloatNumber p = (v - m_tableStart) * m_tableScale;
+    icUInt32Number n = (icUInt32Number)p;
+
+    if (n >= m_nTableSize-1)
+      return m_pTable[m_nTableSize-1];
+
+    if (m_pTableSplit[n])
+      return ApplySegments(v);
+
+    icFloatNumber f = p - n;
+    return m_pTable[n] + f * (m_pTable[n+1] - m_pTable[n]);
+  }
+
+  return ApplySegments(v);
+}
+
+
+/**
+ ******************************************************************************
+ * Name: CIccSegmentedCurve::ApplySegments
+ * 
+ * Purpose: 
+ *  Evaluates the segment containing v.  The segment is found with a binary
+ *  search of the end points when Begin() has been called and found them in
+ *  order, otherwise the first segment ending at or after v is used.
+ ******************************************************************************/
+icFloatNumber CIccSegmentedCurve::ApplySegments(icFloatNumber v) const
+{
+  if (m_pEndPoints && !m_bSortedEndPoints) {
+    icUInt32Number n;
+    for (n=0; n<m_nSegments; n++) {
+      if (v <= m_pEndPoints[n])
+        return m_pSegments[n]->Apply(v);
+    }
+    return v;
+  }
+
+  if (m_pEndPoints) {
+    //find first segment with v <= end point
+    icUInt32Number lo = 0, hi = m_nSegments;
+    while (lo < hi) {
+      icUInt32Number mid = (lo + hi) >> 1;
+      if (v <= m_pEndPoints[mid])
+        hi = mid;
+      else
+        lo = mid + 1;
+    }
+    if (lo < m_nSegments)
+      return m_pSegments[lo]->Apply(v);
+    return v;
+  }
+
  CIccCurveSegmentList::iterator i;
 
   for (i=m_list->begin(); i!=m_list->end(); i++) {
@@ -3156,6 +3324,28 @@ bool CIccMpeCurveSet::SetSize(int nNewSize)
   return true;
 }
 
+/**
+ ******************************************************************************
+ * Name: CIccMpeCurveSet::SetCurveTableSize
+ * 
+ * Purpose: 
+ *  Sets the dense table size that segmented curves build in Begin()
+ * 
+ * Args: 
+ *  nSize = number of table entries (0 evaluates the curve segments directly)
+ ******************************************************************************/
+void CIccMpeCurveSet::SetCurveTableSize(icUInt32Number nSize)
+{
+  if (!m_curve)
+    return;
+
+  for (int i=0; i<m_nInputChannels; i++) {
+    if (m_curve[i] && m_curve[i]->GetType()==icSigSegmentedCurve)
+      ((CIccSegmentedCurve*)m_curve[i])->SetTableSize(nSize);
+  }
+}
+
+
 /**
  ******************************************************************************
  * Name: CIccMpeCurveSet::SetCurve
@@ -5622,7 +5812,7 @@ bool CIccMpeCLUT::Write(CIccIO *pIO)
     if (pIO->Write8(gridPoints, 16)!=16)
       return false;
 
-    icFloatNumber *pData = m_pCLUT->GetData(0);
+    const icFloatNumber *pData = m_pCLUT->GetConstData(0);
     size_t nPoints = m_pCLUT->NumPoints()*m_nOutputChannels;
 
     if (pIO->WriteFloat32Float(pData, nPoints) != nPoints) 
@@ -6075,7 +6265,7 @@ bool CIccMpeExtCLUT::Write(CIccIO *pIO)
     if (pIO->Write8(gridPoints, 16)!=16)
       return false;
 
-    icFloatNumber *pData = m_pCLUT->GetData(0);
+    const icFloatNumber *pData = m_pCLUT->GetConstData(0);
     size_t nPoints = m_pCLUT->NumPoints()*m_nOutputChannels;
 
     switch(m_storageType) {
@@ -6331,6 +6521,7 @@ CIccMpeJabToXYZ::CIccMpeJabToXYZ(const CIccMpeJabToXYZ &cam)
     m_pCAM->SetParameter_C(cam.m_pCAM->GetParameter_C());
     m_pCAM->SetParameter_Nc(cam.m_pCAM->GetParameter_Nc());
     m_pCAM->SetParameter_F(cam.m_pCAM->GetParameter_F());
+    m_pCAM->SetApproxMath(cam.m_pCAM->GetApproxMath());
   }
   else
     m_pCAM = NULL;
@@ -6352,6 +6543,7 @@ CIccMpeJabToXYZ &CIccMpeJabToXYZ::operator=(const CIccMpeJabToXYZ &cam)
     m_pCAM->SetParameter_C(cam.m_pCAM->GetParameter_C());
     m_pCAM->SetParameter_Nc(cam.m_pCAM->GetParameter_Nc());
     m_pCAM->SetParameter_F(cam.m_pCAM->GetParameter_F());
+    m_pCAM->SetApproxMath(cam.m_pCAM->GetApproxMath());
   }
   else
     m_pCAM = NULL;
@@ -6369,6 +6561,12 @@ void CIccMpeJabToXYZ::Apply(CIccApplyMpe * /* pApply */, icFloatNumber *dstPixel
     m_pCAM->JabToXYZ(srcPixel, dstPixel, 1);
 }
 
+void CIccMpeJabToXYZ::ApplyBatch(CIccApplyMpe * /* pApply */, icFloatNumber *dstPixels, const icFloatNumber *srcPixels, icUInt32Number nPixels) const
+{
+  if (m_pCAM)
+    m_pCAM->JabToXYZ(srcPixels, dstPixels, (int)nPixels);
+}
+
 CIccMpeXYZToJab::CIccMpeXYZToJab() : CIccMpeCAM()
 {
 }
@@ -6386,6 +6584,7 @@ CIccMpeXYZToJab::CIccMpeXYZToJab(const CIccMpeXYZToJab &cam)
     m_pCAM->SetParameter_C(cam.m_pCAM->GetParameter_C());
     m_pCAM->SetParameter_Nc(cam.m_pCAM->GetParameter_Nc());
     m_pCAM->SetParameter_F(cam.m_pCAM->GetParameter_F());
+    m_pCAM->SetApproxMath(cam.m_pCAM->GetApproxMath());
   }
   else
     m_pCAM = NULL;
@@ -6407,6 +6606,7 @@ CIccMpeXYZToJab &CIccMpeXYZToJab::operator=(const CIccMpeXYZToJab &cam)
     m_pCAM->SetParameter_C(cam.m_pCAM->GetParameter_C());
     m_pCAM->SetParameter_Nc(cam.m_pCAM->GetParameter_Nc());
     m_pCAM->SetParameter_F(cam.m_pCAM->GetParameter_F());
+    m_pCAM->SetApproxMath(cam.m_pCAM->GetApproxMath());
   }
   else
     m_pCAM = NULL;
@@ -6424,6 +6624,12 @@ void CIccMpeXYZToJab::Apply(CIccApplyMpe * /* pApply */, icFloatNumber *dstPixel
     m_pCAM->XYZToJab(srcPixel, dstPixel, 1);
 }
 
+void CIccMpeXYZToJab::ApplyBatch(CIccApplyMpe * /* pApply */, icFloatNumber *dstPixels, const icFloatNumber *srcPixels, icUInt32Number nPixels) const
+{
+  if (m_pCAM)
+    m_pCAM->XYZToJab(srcPixels, dstPixels, (int)nPixels);
+}
+
 
 #ifdef USEICCDEVNAMESPACE
 } //namespace iccDEV
@@ -92,6 +92,9 @@ class CIccCurveSegment
 public:
   virtual ~CIccCurveSegment() {}
 
+  static void *operator new(size_t nSize) { return CIccMemArena::AllocObject(nSize); }
+  static void operator delete(void *pSeg) { CIccMemArena::FreeObject(pSeg); }
+
   static CIccCurveSegment* Create(icCurveSegSignature sig, icFloatNumber start, icFloatNumber end);
   virtual CIccCurveSegment* NewCopy() const = 0;
 
@@ -261,14 +264,37 @@ public:
   void Reset();
   bool Insert(CIccCurveSegment *pCurveSegment);
 
+  //Enables dense table evaluation (built by Begin) with nSize entries, 0 disables table
+  void SetTableSize(icUInt32Number nSize) { m_nTableSize = nSize; }
+  icUInt32Number GetTableSize() const { return m_nTableSize; }
+
   virtual bool Begin(icElemInterp nInterp, CIccTagMultiProcessElement *pMPE);
   virtual icFloatNumber Apply(icFloatNumber v) const;
   virtual icValidateStatus Validate(std::string sigPath, std::string &sReport, const CIccTagMultiProcessElement* pMPE=NULL, const CIccProfile* pProfile = NULL) const;
 
 protected:
+  void ResetApply();
+  icFloatNumber ApplySegments(icFloatNumber v) const;
+
   CIccCurveSegmentList *m_list;
   icUInt32Number m_nReserved1;
   icUInt32Number m_nReserved2;
+
+  //Contiguous copy of segment list with end points for binary search (set by Begin)
+  CIccCurveSegment **m_pSegments;
+  icFloatNumber *m_pEndPoints;
+  icUInt32Number m_nSegments;
+  //False when the end points are out of order and must be scanned in turn
+  bool m_bSortedEndPoints;
+
+  //Optional dense table covering [m_tableStart, m_tableEnd] (set by Begin)
+  icUInt32Number m_nTableSize;
+  icFloatNumber *m_pTable;
+  //Non-zero for table cells containing a break point, evaluated from segments
+  icUInt8Number *m_pTableSplit;
+  icFloatNumber m_tableStart;
+  icFloatNumber m_tableEnd;
+  icFloatNumber m_tableScale;
 };
 
 
@@ -430,6 +456,9 @@ public:
 
   bool SetCurve(int nIndex, icCurveSetCurvePtr newCurve);
 
+  //Sets dense table size used by segmented curves at Begin() (0 = evaluate segments)
+  void SetCurveTableSize(icUInt32Number nSize);
+
   virtual icElemTypeSignature GetType() const { return icSigCurveSetElemType; }
   virtual const icChar *GetClassName() const { return "CIccMpeCurveSet"; }
 
@@ -800,6 +829,7 @@ public:
   virtual const icChar *GetXformName() const {return "XYZToJab"; }
 
   virtual void Apply(CIccApplyMpe *pApply, icFloatNumber *dstPixel, const icFloatNumber *srcPixel) const;
+  virtual void ApplyBatch(CIccApplyMpe *pApply, icFloatNumber *dstPixels, const icFloatNumber *srcPixels, icUInt32Number nPixels) const;
 };
 
 /**
@@ -824,6 +854,7 @@ public:
   virtual const icChar *GetXformName() const {return "JabToXyz"; }
 
   virtual void Apply(CIccApplyMpe *pApply, icFloatNumber *dstPixel, const icFloatNumber *srcPixel) const;
+  virtual void ApplyBatch(CIccApplyMpe *pApply, icFloatNumber *dstPixels, const icFloatNumber *srcPixels, icUInt32Number nPixels) const;
 };
 
 //CIccMPElements support
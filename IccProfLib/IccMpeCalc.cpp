@@ -2805,7 +2805,7 @@ CIccCalculatorFunc::CIccCalculatorFunc(const CIccCalculatorFunc &func)
   m_nOps = func.m_nOps;
 
   if (m_nOps) {
-    m_Op = (SIccCalcOp*)malloc(m_nOps * sizeof(SIccCalcOp));
+    m_Op = (SIccCalcOp*)CIccMemArena::AllocBuffer(m_nOps * sizeof(SIccCalcOp));
     memcpy(m_Op, func.m_Op, m_nOps*sizeof(SIccCalcOp));
   }
   else
@@ -2829,12 +2829,12 @@ CIccCalculatorFunc &CIccCalculatorFunc::operator=(const CIccCalculatorFunc &func
   m_nReserved= func.m_nReserved;
 
   if (m_Op)
-    free(m_Op);
+    CIccMemArena::FreeObject(m_Op);
 
   m_nOps = func.m_nOps;
 
   if (m_nOps) {
-    m_Op = (SIccCalcOp*)malloc(m_nOps * sizeof(SIccCalcOp));
+    m_Op = (SIccCalcOp*)CIccMemArena::AllocBuffer(m_nOps * sizeof(SIccCalcOp));
     memcpy(m_Op, func.m_Op, m_nOps*sizeof(SIccCalcOp));
   }
   else
@@ -2856,7 +2856,7 @@ CIccCalculatorFunc &CIccCalculatorFunc::operator=(const CIccCalculatorFunc &func
 CIccCalculatorFunc::~CIccCalculatorFunc()
 {
   if (m_Op) {
-    free(m_Op);
+    CIccMemArena::FreeObject(m_Op);
   }
 }
 
@@ -3328,7 +3328,7 @@ icFuncParseStatus CIccCalculatorFunc::SetFunction(const char *szFuncDef, std::st
 icFuncParseStatus CIccCalculatorFunc::SetFunction(CIccCalcOpList &opList, std::string &sReport)
 {
   if (m_Op) {
-    free(m_Op);
+    CIccMemArena::FreeObject(m_Op);
     m_Op = NULL;
   }
 
@@ -3338,7 +3338,7 @@ icFuncParseStatus CIccCalculatorFunc::SetFunction(CIccCalcOpList &opList, std::s
     CIccCalcOpList::iterator i;
     int j;
 
-    m_Op = (SIccCalcOp*)calloc(m_nOps , sizeof(SIccCalcOp));
+    m_Op = (SIccCalcOp*)CIccMemArena::AllocBuffer(m_nOps * sizeof(SIccCalcOp));
 
     for (i=opList.begin(), j=0; i!= opList.end(); i++, j++) {
       m_Op[j] = *i;
@@ -3395,16 +3395,18 @@ bool CIccCalculatorFunc::Read(icUInt32Number size, CIccIO *pIO)
     return false;
 
   if (m_Op) {
-    free(m_Op);
+    CIccMemArena::FreeObject(m_Op);
+    m_Op = NULL;
   }
 
   if (m_nOps) {
-    m_Op = (SIccCalcOp*)calloc(m_nOps, sizeof(SIccCalcOp));
+    m_Op = (SIccCalcOp*)CIccMemArena::AllocBuffer(m_nOps * sizeof(SIccCalcOp));
 
     if (!m_Op) {
       m_nOps = 0;
       return false;
     }
+    memset(m_Op, 0, m_nOps * sizeof(SIccCalcOp));
 
     icUInt32Number i;
     for (i=0; i<m_nOps; i++) {
@@ -4835,7 +4837,7 @@ CIccApplyMpe *CIccMpeCalculator::GetNewApply(CIccApplyTagMpe *pApplyTag)
   pApply->m_stack = new CIccFloatVector;
   pApply->m_scratch = new CIccFloatVector;
   pApply->m_scratch->resize(50);
-  pApply->m_pCmmEnvVarLookup = m_pCmmEnvVarLookup;
+  pApply->m_pCmmEnvVarLookup = pApplyTag ? pApplyTag->GetCmmEnvLookup() : m_pCmmEnvVarLookup;
 
   icUInt32Number i;
 
@@ -5133,6 +5135,7 @@ CIccApplyMpeCalculator::~CIccApplyMpeCalculator()
       if (m_SubElem[i])
         delete m_SubElem[i];
     }
+    free(m_SubElem);
   }
 }
 
@@ -613,6 +613,9 @@ bool CIccMpeEmissionMatrix::Begin(icElemInterp /* nInterp */, CIccTagMultiProces
     return false;
 
   //convert m_Matrix emission values to a matrix of XYZ column vectors
+  if (m_pApplyMtx)
+    delete m_pApplyMtx;
+
   m_pApplyMtx = new CIccMatrixMath(3,m_nInputChannels);
 
   if (!m_pApplyMtx)
@@ -665,6 +668,32 @@ void CIccMpeEmissionMatrix::Apply(CIccApplyMpe * /* pApply */, icFloatNumber *ds
 }
 
 
+/**
+ ******************************************************************************
+ * Name: CIccMpeEmissionMatrix::ApplyBatch
+ * 
+ * Purpose: 
+ *  Applies the emission matrix to nPixels packed pixels using the blocked
+ *  matrix kernel.
+ ******************************************************************************/
+void CIccMpeEmissionMatrix::ApplyBatch(CIccApplyMpe * /* pApply */, icFloatNumber *dstPixels, const icFloatNumber *srcPixels, icUInt32Number nPixels) const
+{
+  icUInt32Number i;
+
+  if (m_pApplyMtx) {
+    m_pApplyMtx->VectorMultBatch(dstPixels, srcPixels, nPixels);
+    for (i=0; i<nPixels; i++, dstPixels+=3) {
+      dstPixels[0] += m_xyzOffset[0];
+      dstPixels[1] += m_xyzOffset[1];
+      dstPixels[2] += m_xyzOffset[2];
+    }
+  }
+  else {
+    memset(dstPixels, 0, (size_t)nPixels*3*sizeof(icFloatNumber));
+  }
+}
+
+
 /**
  ******************************************************************************
  * Name: CIccMpeInvEmissionMatrix::Begin
@@ -697,6 +726,9 @@ bool CIccMpeInvEmissionMatrix::Begin(icElemInterp /* nInterp */, CIccTagMultiPro
   observer.VectorMult(m_xyzOffset, m_pOffset);
 
   //convert m_Matrix emission values to a matrix of XYZ column vectors
+  if (m_pApplyMtx)
+    delete m_pApplyMtx;
+
   m_pApplyMtx = new CIccMatrixMath(3,m_nInputChannels);
 
   if (!m_pApplyMtx)
@@ -782,6 +814,89 @@ static icFloatNumber NoClip(icFloatNumber v)
 }
 
 
+/**
+ ******************************************************************************
+ * Name: icGetIlluminatedObserver
+ * 
+ * Purpose: Gets the observer of the applied PCC weighted by its illuminant
+ *  and mapped to reflectance vectors sampled with range.  Results are shared
+ *  through CIccSpectralObserverCache.
+ * 
+ * Args: 
+ *  pAppliedPCC - connection conditions that define observer and illuminant,
+ *  range - spectral range of reflectance vectors,
+ *  xyzi - receives the XYZ of the illuminant.
+ * 
+ * Return: 
+ *  3 x range.steps matrix to be deleted by caller, or NULL on failure.
+ ******************************************************************************/
+static CIccMatrixMath *icGetIlluminatedObserver(IIccProfileConnectionConditions *pAppliedPCC, const icSpectralRange &range,
+                                                icFloatNumber *xyzi)
+{
+  const CIccTagSpectralViewingConditions *pSVC = pAppliedPCC->getPccViewingConditions();
+  if (!pSVC)
+    return NULL;
+
+  icSpectralRange illumRange, obsRange;
+  const icFloatNumber *illum = pSVC->getIlluminant(illumRange);
+  const icFloatNumber *obs = pSVC->getObserver(obsRange);
+
+  CIccSpectralObserverCache *pCache = CIccSpectralObserverCache::GetGlobal();
+  icUInt32Number nSize = 3*range.steps;
+  std::vector<icFloatNumber> data(nSize+3);
+  std::string key("I");
+  bool bCache = obs && illum;
+
+  if (bCache) {
+    CIccSpectralObserverCache::AppendKey(key, obsRange, obs, 3);
+    CIccSpectralObserverCache::AppendKey(key, illumRange, illum);
+    CIccSpectralObserverCache::AppendKey(key, range);
+
+    if (pCache->Find(key, &data[0], nSize+3)) {
+      CIccMatrixMath *pApplyMtx = new CIccMatrixMath(3, range.steps);
+      memcpy(pApplyMtx->entry(0), &data[0], nSize*sizeof(icFloatNumber));
+      memcpy(xyzi, &data[nSize], 3*sizeof(icFloatNumber));
+      return pApplyMtx;
+    }
+  }
+
+  CIccMatrixMath observer(3, illumRange.steps);
+
+  if (!pAppliedPCC->getEmissiveObserver(illumRange, illum, observer.entry(0)))
+    return NULL;
+
+  //apply illuminant to observer and calculate XYZ of illuminant
+  icFloatNumber *pObs = observer.entry(0);
+  int i, j;
+  for (i=0; i<3; i++) {
+    xyzi[i] = 0.0;
+    for (j=0; j<illumRange.steps; j++) {
+      *pObs *= illum[j];
+      xyzi[i] += *pObs;
+      pObs++;
+    }
+  }
+
+  //concatenate reflectance range mapping to observer+illuminant
+  CIccMatrixMath *rangeRef = CIccMatrixMath::rangeMap(range, illumRange);
+  CIccMatrixMath *pApplyMtx;
+  if (!rangeRef) 
+    pApplyMtx = new CIccMatrixMath(observer);
+  else {
+    pApplyMtx = rangeRef->Mult(&observer);
+    delete rangeRef;
+  }
+
+  if (pApplyMtx && bCache) {
+    memcpy(&data[0], pApplyMtx->entry(0), nSize*sizeof(icFloatNumber));
+    memcpy(&data[nSize], xyzi, 3*sizeof(icFloatNumber));
+    pCache->Add(key, &data[0], nSize+3);
+  }
+
+  return pApplyMtx;
+}
+
+
 
 /**
  ******************************************************************************
@@ -1177,7 +1292,7 @@ bool CIccMpeSpectralCLUT::Write(CIccIO *pIO)
     if (pIO->Write8(gridPoints, 16)!=16)
       return false;
 
-    icFloatNumber *pData = m_pCLUT->GetData(0);
+    const icFloatNumber *pData = m_pCLUT->GetConstData(0);
     size_t nPoints = m_pCLUT->NumPoints()*(int)m_Range.steps;
 
     switch(m_nStorageType) {
@@ -1476,7 +1591,7 @@ bool CIccMpeEmissionCLUT::Begin(icElemInterp nInterp, CIccTagMultiProcessElement
   m_pApplyCLUT->SetClipFunc(NoClip);
   m_pApplyCLUT->Init(m_pCLUT->GridPointArray());
 
-  icFloatNumber *pSrc = m_pCLUT->GetData(0);
+  const icFloatNumber *pSrc = m_pCLUT->GetConstData(0);
   icFloatNumber *pDst = m_pApplyCLUT->GetData(0);
 
   icFloatNumber xyzW[3];
@@ -1552,39 +1667,12 @@ bool CIccMpeReflectanceCLUT::Begin(icElemInterp nInterp, CIccTagMultiProcessElem
   if (!pAppliedPCC)
     return false;
 
-  const CIccTagSpectralViewingConditions *pSVC = pAppliedPCC->getPccViewingConditions();
-  if (!pSVC)
-    return false;
-
-  CIccMatrixMath observer(3, m_Range.steps);
-  icSpectralRange illumRange;
-  const icFloatNumber *illum = pSVC->getIlluminant(illumRange);
-
-  if (!pAppliedPCC->getEmissiveObserver(illumRange, illum, observer.entry(0)))
-    return false;
-
-  //
   icFloatNumber xyzi[3];
+  CIccMatrixMath *pApplyMtx = icGetIlluminatedObserver(pAppliedPCC, m_Range, xyzi);
+  if (!pApplyMtx)
+    return false;
 
-  //apply illuminant to observer and calculate XYZ of illuminant
-  icFloatNumber *pObs = observer.entry(0);
-  int i, j;
-  for (i=0; i<3; i++) {
-    xyzi[i] = 0.0;
-    for (j=0; j<illumRange.steps; j++) {
-      *pObs *= illum[j];
-      xyzi[i] += *pObs;
-      pObs++;
-    }
-  }
-
-  //concatenate reflectance range mapping to observer+illuminant
-  CIccMatrixMath *rangeRef = CIccMatrixMath::rangeMap(m_Range, illumRange);
-  CIccMatrixMath *pApplyMtx;
-  if (!rangeRef) 
-    pApplyMtx = &observer;
-  else
-    pApplyMtx = rangeRef->Mult(&observer);
+  int i;
 
   if (m_pApplyCLUT)
     delete m_pApplyCLUT;
@@ -1592,15 +1680,14 @@ bool CIccMpeReflectanceCLUT::Begin(icElemInterp nInterp, CIccTagMultiProcessElem
   m_pApplyCLUT = new CIccCLUT((icUInt8Number)m_nInputChannels, (icUInt16Number)m_nOutputChannels, 4);
 
   if (!m_pApplyCLUT) {
-    if (pApplyMtx!=&observer)
-      delete pApplyMtx;
+    delete pApplyMtx;
     return false;
   }
 
   m_pApplyCLUT->SetClipFunc(NoClip);
   m_pApplyCLUT->Init(m_pCLUT->GridPointArray());
 
-  icFloatNumber *pSrc = m_pCLUT->GetData(0);
+  const icFloatNumber *pSrc = m_pCLUT->GetConstData(0);
   icFloatNumber *pDst = m_pApplyCLUT->GetData(0);
 
   icFloatNumber xyzW[3];
@@ -1637,8 +1724,7 @@ bool CIccMpeReflectanceCLUT::Begin(icElemInterp nInterp, CIccTagMultiProcessElem
     pDst += m_nOutputChannels;
   }
 
-  if (pApplyMtx!=&observer)
-    delete pApplyMtx;
+  delete pApplyMtx;
 
   m_pApplyCLUT->Begin();
 
@@ -1973,6 +2059,40 @@ void CIccMpeSpectralObserver::Apply(CIccApplyMpe * /* pApply */, icFloatNumber *
   }
 }
 
+/**
+ ******************************************************************************
+ * Name: CIccMpeSpectralObserver::ApplyBatch
+ * 
+ * Purpose: 
+ *  Applies the observer to nPixels packed spectral pixels using the blocked
+ *  matrix kernel followed by per pixel scaling.
+ ******************************************************************************/
+void CIccMpeSpectralObserver::ApplyBatch(CIccApplyMpe * /* pApply */, icFloatNumber *dstPixels, const icFloatNumber *srcPixels, icUInt32Number nPixels) const
+{
+  if (!m_pApplyMtx)
+    return;
+
+  m_pApplyMtx->VectorMultBatch(dstPixels, srcPixels, nPixels);
+
+  bool bUseAbsolute = (m_flags & icRelativeSpectralData)!=0;
+  bool bLab = (m_flags & icLabSpectralData) != 0;
+  icFloatNumber xyz[3];
+  icUInt32Number i;
+
+  for (i=0; i<nPixels; i++, dstPixels+=3) {
+    if (!bUseAbsolute) {
+      dstPixels[0] *= m_xyzscale[0];
+      dstPixels[1] *= m_xyzscale[1];
+      dstPixels[2] *= m_xyzscale[2];
+    }
+
+    if (bLab) {
+      memcpy(xyz, dstPixels, 3*sizeof(icFloatNumber));
+      icXYZtoLab(dstPixels, xyz, m_xyzw);
+    }
+  }
+}
+
 /**
  ******************************************************************************
  * Name: CIccMpeSpectralObserver::Validate
@@ -2056,6 +2176,9 @@ bool CIccMpeEmissionObserver::Begin(icElemInterp /* nInterp */, CIccTagMultiProc
   if (!pSVC)
     return false;
 
+  if (m_pApplyMtx)
+    delete m_pApplyMtx;
+
   m_pApplyMtx = new CIccMatrixMath(3, m_Range.steps);
 
   if (!m_pApplyMtx)
@@ -2093,37 +2216,13 @@ bool CIccMpeReflectanceObserver::Begin(icElemInterp /* nInterp */, CIccTagMultiP
   if (!pAppliedPCC)
     return false;
 
-  const CIccTagSpectralViewingConditions *pSVC = pAppliedPCC->getPccViewingConditions();
-  if (!pSVC)
-    return false;
-
-  CIccMatrixMath observer(3, m_Range.steps);
-  icSpectralRange illumRange;
-  const icFloatNumber *illum = pSVC->getIlluminant(illumRange);
+  if (m_pApplyMtx)
+    delete m_pApplyMtx;
 
-  if (!pAppliedPCC->getEmissiveObserver(illumRange, illum, observer.entry(0)))
+  m_pApplyMtx = icGetIlluminatedObserver(pAppliedPCC, m_Range, m_xyzw);
+  if (!m_pApplyMtx)
     return false;
 
-  //
-  //apply illuminant to observer and calculate XYZ of illuminant
-  icFloatNumber *pObs = observer.entry(0);
-  int i, j;
-  for (i=0; i<3; i++) {
-    m_xyzw[i] = 0.0;
-    for (j=0; j<illumRange.steps; j++) {
-      *pObs *= illum[j];
-      m_xyzw[i] += *pObs;
-      pObs++;
-    }
-  }
-
-  //concatenate reflectance range mapping to observer+illuminant
-  CIccMatrixMath *rangeRef = CIccMatrixMath::rangeMap(m_Range, illumRange);
-  if (!rangeRef) 
-    m_pApplyMtx = new CIccMatrixMath(observer);
-  else
-    m_pApplyMtx = rangeRef->Mult(&observer);
-
   icFloatNumber xyzm[3];
 
   m_pApplyMtx->VectorMult(xyzm, m_pWhite);
@@ -154,6 +154,7 @@ public:
 
   virtual bool Begin(icElemInterp nInterp, CIccTagMultiProcessElement *pMPE);
   virtual void Apply(CIccApplyMpe *pApply, icFloatNumber *dstPixel, const icFloatNumber *srcPixel) const;
+  virtual void ApplyBatch(CIccApplyMpe *pApply, icFloatNumber *dstPixels, const icFloatNumber *srcPixels, icUInt32Number nPixels) const;
 
 protected:
   virtual const char *GetDescribeName() const { return "ELEM_OBS_EMIS_MATRIX"; }
@@ -344,6 +345,7 @@ public:
 
   virtual bool Begin(icElemInterp nInterp, CIccTagMultiProcessElement *pMPE) = 0;
   virtual void Apply(CIccApplyMpe *pApply, icFloatNumber *dstPixel, const icFloatNumber *srcPixel) const;
+  virtual void ApplyBatch(CIccApplyMpe *pApply, icFloatNumber *dstPixels, const icFloatNumber *srcPixels, icUInt32Number nPixels) const;
 
   virtual icValidateStatus Validate(std::string sigPath, std::string &sReport, const CIccTagMultiProcessElement* pMPE=NULL, const CIccProfile* pProfile = NULL) const;
 
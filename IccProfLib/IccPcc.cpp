@@ -172,25 +172,23 @@ icFloatNumber IIccProfileConnectionConditions::getObserverIlluminantScaleFactor(
   const icFloatNumber *obs = pView->getObserver(obsRange);
 
   int i, n = illumRange.steps;
-  CIccMatrixMath *mapRange=CIccMatrixMath::rangeMap(obsRange, illumRange);
   icFloatNumber rv=0;
 
-  if (mapRange) {
-    icFloatNumber *Ycmf = new icFloatNumber[illumRange.steps];
-    mapRange->VectorMult(Ycmf, &obs[obsRange.steps]);
-    delete mapRange;
+  std::vector<icFloatNumber> cmf;
+  const icFloatNumber *Ycmf = &obs[obsRange.steps];
 
-    for (i=0; i<n; i++) {
-      rv += Ycmf[i]*illum[i];
+  if (!icSameSpectralRange(obsRange, illumRange)) {
+    cmf.resize(3*n);
+    if (!CIccSpectralObserverCache::GetGlobal()->GetObserver(&cmf[0], obs, obsRange, illumRange)) {
+      CIccMatrixMath *mapRange=CIccMatrixMath::rangeMap(obsRange, illumRange);
+      mapRange->VectorMult(&cmf[n], &obs[obsRange.steps]);
+      delete mapRange;
     }
-    delete [] Ycmf;
+    Ycmf = &cmf[n];
   }
-  else {
-   const icFloatNumber *Ycmf = &obs[obsRange.steps];
 
-    for (i=0; i<n; i++) {
-      rv += Ycmf[i]*illum[i];
-    }
+  for (i=0; i<n; i++) {
+    rv += Ycmf[i]*illum[i];
   }
   return rv;
 }
@@ -205,25 +203,23 @@ icFloatNumber IIccProfileConnectionConditions::getObserverWhiteScaleFactor(const
   const icFloatNumber *obs = pView->getObserver(obsRange);
 
   int i, n = whiteRange.steps;
-  CIccMatrixMath *mapRange=CIccMatrixMath::rangeMap(obsRange, whiteRange);
   icFloatNumber rv=0;
 
-  if (mapRange) {
-    icFloatNumber *Ycmf = new icFloatNumber[whiteRange.steps];
-    mapRange->VectorMult(Ycmf, &obs[obsRange.steps]);
-    delete mapRange;
+  std::vector<icFloatNumber> cmf;
+  const icFloatNumber *Ycmf = &obs[obsRange.steps];
 
-    for (i=0; i<n; i++) {
-      rv += Ycmf[i]*pWhite[i];
+  if (!icSameSpectralRange(obsRange, whiteRange)) {
+    cmf.resize(3*n);
+    if (!CIccSpectralObserverCache::GetGlobal()->GetObserver(&cmf[0], obs, obsRange, whiteRange)) {
+      CIccMatrixMath *mapRange=CIccMatrixMath::rangeMap(obsRange, whiteRange);
+      mapRange->VectorMult(&cmf[n], &obs[obsRange.steps]);
+      delete mapRange;
     }
-    delete [] Ycmf;
+    Ycmf = &cmf[n];
   }
-  else {
-    const icFloatNumber *Ycmf = &obs[obsRange.steps];
 
-    for (i=0; i<n; i++) {
-      rv += Ycmf[i]*pWhite[i];
-    }
+  for (i=0; i<n; i++) {
+    rv += Ycmf[i]*pWhite[i];
   }
   return rv;
 }
@@ -245,21 +241,23 @@ icFloatNumber *IIccProfileConnectionConditions::getEmissiveObserver(const icSpec
     obs = (icFloatNumber*)malloc(size*sizeof(icFloatNumber));
 
   if (obs) {
-    CIccMatrixMath *mapRange=CIccMatrixMath::rangeMap(observerRange, range);
-
     //Copy observer while adjusting to range
-    if (mapRange) {
+    if (!observer || !CIccSpectralObserverCache::GetGlobal()->GetObserver(obs, observer, observerRange, range)) {
+      CIccMatrixMath *mapRange=CIccMatrixMath::rangeMap(observerRange, range);
+
+      if (mapRange) {
         fptr = &observer[0];
         tptr = obs;
         for (i = 0; i < 3; i++) {
-            mapRange->VectorMult(tptr, fptr);
-            fptr += observerRange.steps;
-            tptr += range.steps;
+          mapRange->VectorMult(tptr, fptr);
+          fptr += observerRange.steps;
+          tptr += range.steps;
         }
         delete mapRange;
-    }
-    else {
-      memcpy(obs, observer, size*sizeof(icFloatNumber));
+      }
+      else {
+        memcpy(obs, observer, size*sizeof(icFloatNumber));
+      }
     }
 
     //Calculate scale constant 
@@ -273,12 +271,6 @@ icFloatNumber *IIccProfileConnectionConditions::getEmissiveObserver(const icSpec
     for (i=0; i<size; i++) {
       obs[i] = obs[i] / k;
     }
-
-    CIccMatrixMath observerMtx(3,range.steps);
-    memcpy(observerMtx.entry(0), obs, size*sizeof(icFloatNumber));
-
-    icFloatNumber xyz[3];
-    observerMtx.VectorMult(xyz, pWhite);
   }
 
   return obs;
@@ -292,6 +284,24 @@ CIccMatrixMath *IIccProfileConnectionConditions::getReflectanceObserver(const ic
   icSpectralRange illumRange;
   const icFloatNumber *illum = pView->getIlluminant(illumRange);
 
+  icSpectralRange obsRange;
+  const icFloatNumber *obs = pView->getObserver(obsRange);
+
+  CIccSpectralObserverCache *pCache = CIccSpectralObserverCache::GetGlobal();
+  icUInt32Number nSize = 3*rangeRef.steps;
+  std::string key("R");
+
+  if (obs && illum) {
+    CIccSpectralObserverCache::AppendKey(key, obsRange, obs, 3);
+    CIccSpectralObserverCache::AppendKey(key, illumRange, illum);
+    CIccSpectralObserverCache::AppendKey(key, rangeRef);
+
+    pMtx = new CIccMatrixMath(3, rangeRef.steps);
+    if (pCache->Find(key, pMtx->entry(0), nSize))
+      return pMtx;
+    delete pMtx;
+  }
+
   pMtx = CIccMatrixMath::rangeMap(rangeRef, illumRange);
   if (pMtx)
     pAdjust = pMtx;
@@ -299,7 +309,9 @@ CIccMatrixMath *IIccProfileConnectionConditions::getReflectanceObserver(const ic
   pMtx = pView->getObserverMatrix(illumRange);
 
   if (pAdjust) {
-    pMtx = pAdjust->Mult(pMtx);
+    CIccMatrixMath *pObs = pMtx;
+    pMtx = pAdjust->Mult(pObs);
+    delete pObs;
     delete pAdjust;
   }
   pAdjust = pMtx;
@@ -307,6 +319,9 @@ CIccMatrixMath *IIccProfileConnectionConditions::getReflectanceObserver(const ic
   pAdjust->VectorScale(illum);
   pAdjust->Scale(1.0f / pAdjust->RowSum(1));
 
+  if (obs && illum && pAdjust->GetRows()==3 && pAdjust->GetCols()==rangeRef.steps)
+    pCache->Add(key, pAdjust->entry(0), nSize);
+
   return pAdjust;
 }
 
@@ -396,3 +411,143 @@ bool CIccCombinedConnectionConditions::getMediaWhiteXYZ(icFloatNumber *pXYZ)
   }
   return false;
 }
+
+
+//////////////////////////////////////////////////////////////////////
+// CIccSpectralObserverCache
+//////////////////////////////////////////////////////////////////////
+
+CIccSpectralObserverCache::CIccSpectralObserverCache(icUInt32Number nMaxEntries/*=ICC_OBSERVER_CACHE_SIZE*/)
+{
+  m_nMaxEntries = nMaxEntries ? nMaxEntries : 1;
+}
+
+/**
+**************************************************************************
+* Name: CIccSpectralObserverCache::AppendKey
+* 
+* Purpose:
+*  Appends a spectral range and nVectors vectors of spectral data sampled
+*  with that range to a cache key.
+**************************************************************************
+*/
+void CIccSpectralObserverCache::AppendKey(std::string &key, const icSpectralRange &range, const icFloatNumber *pData/*=NULL*/,
+                                          icUInt32Number nVectors/*=1*/)
+{
+  key.append((const char*)&range, sizeof(range));
+  if (pData)
+    key.append((const char*)pData, (size_t)range.steps*nVectors*sizeof(icFloatNumber));
+}
+
+/**
+**************************************************************************
+* Name: CIccSpectralObserverCache::Find
+* 
+* Purpose:
+*  Copies nSize values cached with key to pData.
+**************************************************************************
+*/
+bool CIccSpectralObserverCache::Find(const std::string &key, icFloatNumber *pData, icUInt32Number nSize)
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+
+  auto i = m_Index.find(key);
+  if (i==m_Index.end())
+    return false;
+
+  IccObserverList::iterator e = i->second;
+  if (e->data.size()!=nSize)
+    return false;
+
+  memcpy(pData, e->data.data(), nSize*sizeof(icFloatNumber));
+
+  m_Entries.splice(m_Entries.begin(), m_Entries, e);
+
+  return true;
+}
+
+void CIccSpectralObserverCache::Add(const std::string &key, const icFloatNumber *pData, icUInt32Number nSize)
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+
+  // another thread may have calculated it meanwhile
+  if (m_Index.find(key)!=m_Index.end())
+    return;
+
+  IccObserverEntry entry;
+  entry.key = key;
+  entry.data.assign(pData, pData+nSize);
+
+  m_Entries.push_front(entry);
+  m_Index[key] = m_Entries.begin();
+
+  while (m_Entries.size() > m_nMaxEntries) {
+    m_Index.erase(m_Entries.back().key);
+    m_Entries.pop_back();
+  }
+}
+
+void CIccSpectralObserverCache::Clear()
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+
+  m_Index.clear();
+  m_Entries.clear();
+}
+
+size_t CIccSpectralObserverCache::GetCount()
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+
+  return m_Entries.size();
+}
+
+/**
+**************************************************************************
+* Name: CIccSpectralObserverCache::GetObserver
+* 
+* Purpose:
+*  Gets the three color matching functions of observer resampled from
+*  observerRange to range.  pObs must hold 3*range.steps values.
+* 
+* Return: 
+*  false if observerRange cannot be resampled to range.
+**************************************************************************
+*/
+bool CIccSpectralObserverCache::GetObserver(icFloatNumber *pObs, const icFloatNumber *observer,
+                                            const icSpectralRange &observerRange, const icSpectralRange &range)
+{
+  icUInt32Number nSize = 3*range.steps;
+
+  if (icSameSpectralRange(observerRange, range)) {
+    memcpy(pObs, observer, nSize*sizeof(icFloatNumber));
+    return true;
+  }
+
+  std::string key("O");
+  AppendKey(key, observerRange, observer, 3);
+  AppendKey(key, range);
+
+  if (Find(key, pObs, nSize))
+    return true;
+
+  CIccMatrixMath mapRange(range.steps, observerRange.steps);
+  if (!mapRange.SetRange(observerRange, range))
+    return false;
+
+  int i;
+  for (i=0; i<3; i++)
+    mapRange.VectorMult(&pObs[i*range.steps], &observer[i*observerRange.steps]);
+
+  Add(key, pObs, nSize);
+
+  return true;
+}
+
+// returns the process wide cache used by transforms
+CIccSpectralObserverCache *CIccSpectralObserverCache::GetGlobal()
+{
+  static CIccSpectralObserverCache cache;
+
+  return &cache;
+}
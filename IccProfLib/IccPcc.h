@@ -68,6 +68,11 @@
 #define _ICCPCC_H
 
 #include "IccDefs.h"
+#include <list>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <mutex>
 
 #ifdef USEICCDEVNAMESPACE
 namespace iccDEV {
@@ -152,6 +157,51 @@ protected:
 };
 
 
+/**
+ **************************************************************************
+ * Type: Class
+ * 
+ * Purpose: Least recently used cache of observer and illuminant derived
+ *  data shared by all transforms.  Entries are keyed by the observer and
+ *  illuminant spectral data and the spectral ranges they were resampled
+ *  to so that transforms built with the same viewing conditions reuse
+ *  them.  Access is thread safe.
+ **************************************************************************
+*/
+#define ICC_OBSERVER_CACHE_SIZE 64
+class ICCPROFLIB_API CIccSpectralObserverCache
+{
+public:
+  CIccSpectralObserverCache(icUInt32Number nMaxEntries=ICC_OBSERVER_CACHE_SIZE);
+
+  bool Find(const std::string &key, icFloatNumber *pData, icUInt32Number nSize);
+  void Add(const std::string &key, const icFloatNumber *pData, icUInt32Number nSize);
+
+  void Clear();
+  size_t GetCount();
+
+  bool GetObserver(icFloatNumber *pObs, const icFloatNumber *observer, const icSpectralRange &observerRange,
+                   const icSpectralRange &range);
+
+  static void AppendKey(std::string &key, const icSpectralRange &range, const icFloatNumber *pData=NULL, icUInt32Number nVectors=1);
+  static CIccSpectralObserverCache *GetGlobal();
+
+protected:
+  struct IccObserverEntry {
+    std::string key;
+    std::vector<icFloatNumber> data;
+  };
+  typedef std::list<IccObserverEntry> IccObserverList;
+
+  //Entries in most recently used order
+  IccObserverList m_Entries;
+  std::unordered_map<std::string, IccObserverList::iterator> m_Index;
+
+  icUInt32Number m_nMaxEntries;
+  std::mutex m_Mutex;
+};
+
+
 #ifdef USEICCDEVNAMESPACE
 } //namespace iccDEV
 #endif
@@ -62,7 +62,10 @@ Copyright:  (c) see ICC Software License
 */
 
 #include "IccPrmg.h"
+#include "IccEval.h"
 #include "IccUtil.h"
+#include <thread>
+#include <vector>
 
 #ifdef USEICCDEVNAMESPACE
 namespace iccDEV {
@@ -133,6 +136,7 @@ CIccPRMG::CIccPRMG()
 {
   m_nTotal = m_nDE1 = m_nDE2 = m_nDE3 = m_nDE5 = m_nDE10 = 0;
   m_bPrmgImplied = false;
+  m_nThreads = 1;
 }
 
 icFloatNumber CIccPRMG::GetChroma(icFloatNumber L, icFloatNumber h)
@@ -200,6 +204,45 @@ bool CIccPRMG::InGamut(icFloatNumber *Lab)
   return InGamut(Lch[0], Lch[1], Lch[2]);
 }
 
+/**
+**************************************************************************
+* Name: CIccPRMG::AddDeltaE
+* 
+* Purpose: 
+*  Adds the round trip error of one in gamut sample to the totals.
+**************************************************************************
+*/
+void CIccPRMG::AddDeltaE(icFloatNumber dE)
+{
+  m_nTotal++;
+
+  if (dE<=1.0) {
+    m_nDE1++;
+    m_nDE2++;
+    m_nDE3++;
+    m_nDE5++;
+    m_nDE10++;
+  }
+  else if (dE<=2.0) {
+    m_nDE2++;
+    m_nDE3++;
+    m_nDE5++;
+    m_nDE10++;
+  }
+  else if (dE<=3.0) {
+    m_nDE3++;
+    m_nDE5++;
+    m_nDE10++;
+  }
+  else if (dE<=5.0) {
+    m_nDE5++;
+    m_nDE10++;
+  }
+  else if (dE<=10.0) {
+    m_nDE10++;
+  }
+}
+
 icStatusCMM CIccPRMG::EvaluateProfile(CIccProfile *pProfile, icRenderingIntent nIntent/* =icUnknownIntent */,
                                       icXformInterp nInterp/* =icInterpLinear */, bool buseMpeTags/* =true */)
 {
@@ -245,52 +288,90 @@ icStatusCMM CIccPRMG::EvaluateProfile(CIccProfile *pProfile, icRenderingIntent n
   if (result != icCmmStatOk) {
     return result;
   }
-  icFloatNumber pcs[3], Lab1[3], Lab2[3], dE;
+  // each thread round trips its share of a block with its own apply object
+  std::vector<CIccApplyCmm*> applies;
+  icUInt32Number t;
+
+  for (t=0; t<m_nThreads; t++) {
+    CIccApplyCmm *pApply = Lab2Dev2Lab.GetNewApplyCmm(result);
+    if (!pApply)
+      break;
+    applies.push_back(pApply);
+  }
+
+  if (applies.empty())
+    return result;
+
+  const icUInt32Number nApply = (icUInt32Number)applies.size();
+  const icUInt32Number nBlock = nApply * ICC_EVAL_BLOCK_PIXELS;
+  std::vector<icFloatNumber> pcsBlock((size_t)nBlock*3), lab1Block((size_t)nBlock*3), lab2Block((size_t)nBlock*3);
+  icUInt32Number nPixels = 0;
 
   m_nTotal = m_nDE1 = m_nDE2 = m_nDE3 = m_nDE5 = m_nDE10 = 0;
 
+  auto roundTripBlock = [&]() {
+    icUInt32Number nRun = (nPixels + nApply - 1) / nApply;
+    std::vector<std::thread> pool;
+
+    for (icUInt32Number i=0; i*nRun<nPixels; i++) {
+      icUInt32Number nFirst = i*nRun;
+      icUInt32Number nCount = nPixels - nFirst < nRun ? nPixels - nFirst : nRun;
+      CIccApplyCmm *pApply = applies[i];
+      const icFloatNumber *pSrc = &pcsBlock[(size_t)nFirst*3];
+      icFloatNumber *pDst = &lab2Block[(size_t)nFirst*3];
+
+      auto roundTrip = [=]() { pApply->Apply(pDst, pSrc, nCount); };
+
+      if (!i) {
+        roundTrip();
+        continue;
+      }
+
+      try {
+        pool.push_back(std::thread(roundTrip));
+      }
+      catch (...) {
+        roundTrip();
+      }
+    }
+
+    for (size_t i=0; i<pool.size(); i++)
+      pool[i].join();
+
+    for (icUInt32Number k=0; k<nPixels; k++) {
+      icFloatNumber *Lab2 = &lab2Block[(size_t)k*3];
+
+      icLabFromPcs(Lab2);
+      AddDeltaE(icDeltaE(&lab1Block[(size_t)k*3], Lab2));
+    }
+
+    nPixels = 0;
+  };
+
+  icFloatNumber pcs[3], Lab1[3];
+
   for (pcs[0]=0.0; pcs[0]<=1.0; pcs[0] += (icFloatNumber)0.01) {
     for (pcs[1]=0.0; pcs[1]<=1.0; pcs[1] += (icFloatNumber)0.01) {
       for (pcs[2]=0.0; pcs[2]<=1.0; pcs[2] += (icFloatNumber)0.01) {
         memcpy(Lab1, pcs, 3*sizeof(icFloatNumber));
         icLabFromPcs(Lab1);
         if (InGamut(Lab1)) {
-          Lab2Dev2Lab.Apply(Lab2, pcs);
-          icLabFromPcs(Lab2);
-
-          dE = icDeltaE(Lab1, Lab2);
-          m_nTotal++;
-
-          if (dE<=1.0) {
-            m_nDE1++;
-            m_nDE2++;
-            m_nDE3++;
-            m_nDE5++;
-            m_nDE10++;
-          }
-          else if (dE<=2.0) {
-            m_nDE2++;
-            m_nDE3++;
-            m_nDE5++;
-            m_nDE10++;
-          }
-          else if (dE<=3.0) {
-            m_nDE3++;
-            m_nDE5++;
-            m_nDE10++;
-          }
-          else if (dE<=5.0) {
-            m_nDE5++;
-            m_nDE10++;
-          }
-          else if (dE<=10.0) {
-            m_nDE10++;
-          }
+          memcpy(&pcsBlock[(size_t)nPixels*3], pcs, 3*sizeof(icFloatNumber));
+          memcpy(&lab1Block[(size_t)nPixels*3], Lab1, 3*sizeof(icFloatNumber));
+
+          if (++nPixels==nBlock)
+            roundTripBlock();
         }
       }
     }
   }
 
+  if (nPixels)
+    roundTripBlock();
+
+  for (t=0; t<nApply; t++)
+    delete applies[t];
+
   return icCmmStatOk;
 }
 
@@ -89,9 +89,18 @@ public:
   icStatusCMM EvaluateProfile(const icChar *szProfilePath, icRenderingIntent nIntent=icUnknownIntent, 
                               icXformInterp nInterp=icInterpLinear, bool buseMpeTags=true);
 
+  //Number of threads used to round trip gamut samples (default 1)
+  void SetThreads(icUInt32Number nThreads) { m_nThreads = nThreads ? nThreads : 1; }
+  icUInt32Number GetThreads() const { return m_nThreads; }
+
   icUInt32Number m_nDE1, m_nDE2, m_nDE3, m_nDE5, m_nDE10, m_nTotal;
 
   bool m_bPrmgImplied;
+
+protected:
+  void AddDeltaE(icFloatNumber dE);
+
+  icUInt32Number m_nThreads;
 };
 
 #ifdef USEICCDEVNAMESPACE
@@ -74,6 +74,12 @@
 #include <ctime>
 #include <cstring>
 #include <cmath>
+#include <vector>
+#include <set>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <sys/stat.h>
 #include "IccProfile.h"
 #include "IccTag.h"
 #include "IccArrayBasic.h"
@@ -81,6 +87,10 @@
 #include "IccUtil.h"
 #include "IccMatrixMath.h"
 #include "IccMD5.h"
+#include "IccTagFactory.h"
+#include "IccMpeFactory.h"
+#include "IccStructFactory.h"
+#include "IccArrayFactory.h"
 
 
 #ifdef USEICCDEVNAMESPACE
@@ -160,6 +170,11 @@ CIccProfile::CIccProfile(const CIccProfile &Profile)
       m_Tags.push_back(entry);
     }
   }
+  IndexTags();
+  CopyProfileIDMemo(Profile);
+
+  m_nReadThreads = Profile.m_nReadThreads;
+  UseArena(Profile.UsesArena());
 
   m_pAttachIO = NULL;  
 }
@@ -187,6 +202,8 @@ CIccProfile &CIccProfile::operator=(const CIccProfile &Profile)
 
   memcpy(&m_Header, &Profile.m_Header, sizeof(m_Header));
   m_parentColorSpace = Profile.m_parentColorSpace;
+  m_nReadThreads = Profile.m_nReadThreads;
+  UseArena(Profile.UsesArena());
 
   if (!Profile.m_TagVals.empty()) {
     TagPtrList::const_iterator i;
@@ -220,6 +237,8 @@ CIccProfile &CIccProfile::operator=(const CIccProfile &Profile)
       m_Tags.push_back(entry);
     }
   }
+  IndexTags();
+  CopyProfileIDMemo(Profile);
 
   m_pAttachIO = NULL;
 
@@ -237,6 +256,37 @@ CIccProfile &CIccProfile::operator=(const CIccProfile &Profile)
 CIccProfile::~CIccProfile()
 {
   Cleanup();
+
+  if (m_pArena)
+    m_pArena->Release();
+}
+
+/**
+ **************************************************************************
+ * Name: CIccProfile::UseArena
+ * 
+ * Purpose: 
+ *  Selects whether tag objects created by subsequent reads are allocated
+ *  from a per-profile arena (see CIccMemArena) rather than individually
+ *  from the heap.  Deleting the profile then returns the storage of all its
+ *  tags to the heap in a few large blocks.  Tags already read are
+ *  unaffected, and tags detached from the profile (such as elements taken
+ *  with CIccTagArray::DetachTag()) remain valid after the profile is
+ *  deleted.
+ * 
+ * Args:
+ *  bUseArena - true to allocate tags from an arena
+ **************************************************************************
+ */
+void CIccProfile::UseArena(bool bUseArena/*=true*/)
+{
+  if (bUseArena && !m_pArena) {
+    m_pArena = new CIccMemArena();
+  }
+  else if (!bUseArena && m_pArena) {
+    m_pArena->Release();
+    m_pArena = NULL;
+  }
 }
 
 /**
@@ -252,18 +302,33 @@ void CIccProfile::Cleanup()
     delete m_pAttachIO;
   }
   m_pAttachIO = nullptr;
+  m_AttachTags.clear();
 
   TagPtrList::iterator i;
 
+  //The arena blocks are released as a whole so deleted tags are not recycled
+  if (m_pArena)
+    m_pArena->BeginTeardown();
+
   for (i=m_TagVals.begin(); i!=m_TagVals.end(); i++) {
     if (i->ptr != nullptr) {
       delete i->ptr;
     }
   }
   m_Tags.clear();
+  m_TagIndex.clear();
+  m_nTagsRevision++;
   m_TagVals.clear();
+  InvalidatePccMemo();
+  InvalidateProfileIDMemo();
   memset(&m_Header, 0, sizeof(m_Header));
   m_parentColorSpace = icSigNoColorData;
+
+  //Recycle the arena blocks unless detached tags still live in them
+  if (m_pArena && !m_pArena->Reset()) {
+    m_pArena->Release();
+    m_pArena = new CIccMemArena();
+  }
 }
 
 /**
@@ -279,8 +344,34 @@ void CIccProfile::Cleanup()
  *  Pointer to desired tag directory entry, or NULL if not found.
  *****************************************************************************
  */
+static bool icTagEntryLess(const IccTagEntry *a, const IccTagEntry *b)
+{
+  return (icUInt32Number)a->TagInfo.sig < (icUInt32Number)b->TagInfo.sig;
+}
+
+static bool icTagEntrySigLess(const IccTagEntry *pEntry, icUInt32Number sig)
+{
+  return (icUInt32Number)pEntry->TagInfo.sig < sig;
+}
+
+static bool icSigTagEntryLess(icUInt32Number sig, const IccTagEntry *pEntry)
+{
+  return sig < (icUInt32Number)pEntry->TagInfo.sig;
+}
+
 IccTagEntry* CIccProfile::GetTag(icSignature sig) const
 {
+  //Use the index unless m_Tags was changed without reindexing
+  if (m_TagIndex.size()==m_Tags.size()) {
+    TagEntryIndex::const_iterator e = std::lower_bound(m_TagIndex.begin(), m_TagIndex.end(),
+                                                       (icUInt32Number)sig, icTagEntrySigLess);
+
+    if (e!=m_TagIndex.end() && (*e)->TagInfo.sig==(icTagSignature)sig)
+      return *e;
+
+    return NULL;
+  }
+
   TagEntryList::const_iterator i;
 
   for (i=m_Tags.begin(); i!=m_Tags.end(); i++) {
@@ -292,6 +383,31 @@ IccTagEntry* CIccProfile::GetTag(icSignature sig) const
 }
 
 
+/**
+ ****************************************************************************
+ * Name: CIccProfile::IndexTags
+ *
+ * Purpose: Rebuilds the signature index of the tag directory.  Must be
+ *  called after entries are added to or removed from m_Tags.
+ *****************************************************************************
+ */
+void CIccProfile::IndexTags()
+{
+  TagEntryList::iterator i;
+
+  m_TagIndex.clear();
+  m_TagIndex.reserve(m_Tags.size());
+
+  for (i=m_Tags.begin(); i!=m_Tags.end(); i++)
+    m_TagIndex.push_back(&(*i));
+
+  std::stable_sort(m_TagIndex.begin(), m_TagIndex.end(), icTagEntryLess);
+  m_nTagsRevision++;
+
+  InvalidatePccMemo();
+}
+
+
 /**
  ****************************************************************************
  * Name: CIccProfile::GetTag
@@ -308,12 +424,10 @@ IccTagEntry* CIccProfile::GetTag(icSignature sig) const
  */
 IccTagEntry* CIccProfile::GetTag(icSignature sig, const CIccProfile *pParentProfile) const
 {
-  TagEntryList::const_iterator i;
+  IccTagEntry *pEntry = GetTag(sig);
 
-  for (i = m_Tags.begin(); i != m_Tags.end(); i++) {
-    if (i->TagInfo.sig == (icTagSignature)sig)
-      return (IccTagEntry*)&(i->TagInfo);
-  }
+  if (pEntry)
+    return pEntry;
 
   if (pParentProfile)
     return pParentProfile->GetTag(sig);
@@ -399,8 +513,14 @@ CIccTag* CIccProfile::FindTag(icSignature sig)
   IccTagEntry *pEntry = GetTag(sig);
 
   if (pEntry) {
-    if (!pEntry->pTag && m_pAttachIO)
-      LoadTag(pEntry, m_pAttachIO);
+    if (m_pAttachIO) {
+      //Deferred loading can be triggered from several threads and profiles
+      //sharing the IO
+      std::lock_guard<std::mutex> lock(m_pAttachIO->GetReadMutex());
+
+      if (!pEntry->pTag)
+        LoadTag(pEntry, m_pAttachIO);
+    }
     return pEntry->pTag;
   }
 
@@ -486,6 +606,7 @@ CIccMemIO* CIccProfile::GetTagIO(icSignature sig)
   IccTagEntry *pEntry = GetTag(sig);
 
   if (pEntry && m_pAttachIO) {
+    std::lock_guard<std::mutex> lock(m_pAttachIO->GetReadMutex());
     CIccMemIO *pIO = new CIccMemIO;
 
     if (!pIO)
@@ -547,6 +668,17 @@ bool CIccProfile::AttachTag(icSignature sig, CIccTag *pTag)
 
   m_Tags.push_back(Entry);
 
+  //New entry goes after any others with the same signature
+  IccTagEntry *pNewEntry = &m_Tags.back();
+  if (m_TagIndex.size()+1==m_Tags.size())
+  {
+    m_TagIndex.insert(std::upper_bound(m_TagIndex.begin(), m_TagIndex.end(), (icUInt32Number)sig, icSigTagEntryLess), pNewEntry);
+    m_nTagsRevision++;
+    InvalidatePccMemo();
+  }
+  else
+    IndexTags();
+
   TagPtrList::iterator i;
 
   for (i=m_TagVals.begin(); i!=m_TagVals.end(); i++)
@@ -589,6 +721,7 @@ bool CIccProfile::DeleteTag(icSignature sig)
   if (i!=m_Tags.end()) {
     CIccTag *pTag = i->pTag;
     m_Tags.erase(i);
+    IndexTags();
 
     if (pTag && !GetTag(pTag)) {
       DetachTag(pTag);
@@ -684,6 +817,7 @@ bool CIccProfile::Attach(CIccIO *pIO, bool bUseSubProfile/*=false*/)
   }
 
   m_pAttachIO = pIO;
+  SetAttachState();
 
   return true;
 }
@@ -751,6 +885,16 @@ void CIccProfile::CopyAttach(CIccProfile* pProfile, bool bSharedIO)
   else {
     m_pAttachIO = pProfile->m_pAttachIO;
     m_bSharedIO = bSharedIO;
+
+    //The attached data only describes this profile if it is an unchanged copy
+    if (pProfile->IsAsAttached()) {
+      m_AttachHeader = pProfile->m_AttachHeader;
+      m_AttachTags = pProfile->m_AttachTags;
+    }
+    else {
+      memset(&m_AttachHeader, 0, sizeof(m_AttachHeader));
+      m_AttachTags.clear();
+    }
   }
 }
 
@@ -787,6 +931,7 @@ bool CIccProfile::ReadTags(CIccProfile* pProfile)
 		return true;
 	}
 
+	std::lock_guard<std::mutex> lock(pIO->GetReadMutex());
 	size_t pos = pIO->Tell();
 
 	for (i=m_Tags.begin(); i!=m_Tags.end(); i++) {
@@ -801,6 +946,9 @@ bool CIccProfile::ReadTags(CIccProfile* pProfile)
 	return true;
 }
 
+//Profiles smaller than this are always read by the calling thread
+#define ICC_PARALLEL_READ_MIN 262144
+
 /**
  ******************************************************************************
  * Name: CIccProfile::Read
@@ -843,6 +991,14 @@ bool CIccProfile::Read(CIccIO *pIO, bool bUseSubProfile/*=false*/)
     }
   }
 
+  if (m_nReadThreads>1 && m_Tags.size()>1 && pIO->GetLength()>=ICC_PARALLEL_READ_MIN) {
+    if (!LoadTagsParallel(pIO)) {
+      Cleanup();
+      return false;
+    }
+    return true;
+  }
+
   TagEntryList::iterator i;
 
   for (i=m_Tags.begin(); i!=m_Tags.end(); i++) {
@@ -959,8 +1115,29 @@ icValidateStatus CIccProfile::ReadValidate(CIccIO *pIO, std::string &sReport)
  *  true - success, false - failure
  *******************************************************************************
  */
+#define ICC_PROFILE_WRITE_BUFSIZE 65536
 bool CIccProfile::Write(CIccIO *pIO, icProfileIDSaveMethod nWriteId)
 {
+  //Profiles are serialized into memory so that the tag directory, size and
+  //profile ID are patched there and other IO objects see a single write.
+  if (!dynamic_cast<CIccMemIO*>(pIO)) {
+    CIccMemIO memIO;
+
+    if (!memIO.Alloc(ICC_PROFILE_WRITE_BUFSIZE, true))
+      return false;
+    memIO.SetGrowable();
+
+    if (!Write(&memIO, nWriteId))
+      return false;
+
+    size_t nSize = memIO.GetLength();
+
+    if (pIO->Seek(0, icSeekSet)<0)
+      return false;
+
+    return pIO->Write8(memIO.GetData(), nSize)==nSize;
+  }
+
   //Write Header
   pIO->Seek(0, icSeekSet);
 
@@ -1095,6 +1272,7 @@ bool CIccProfile::ReadProfileID(icProfileID &profileID)
     return false;
   }
 
+  std::lock_guard<std::mutex> lock(m_pAttachIO->GetReadMutex());
   CalcProfileID(m_pAttachIO, &profileID);
 
   return true;
@@ -1240,6 +1418,7 @@ bool CIccProfile::ReadBasic(CIccIO *pIO)
     m_Tags.push_back(TagEntry);
   }
 
+  IndexTags();
 
   return true;
 }
@@ -1270,47 +1449,79 @@ bool CIccProfile::LoadTag(IccTagEntry *pTagEntry, CIccIO *pIO, bool bReadAll/*=f
   if (pTagEntry->pTag)
     return pTagEntry->pTag->ReadAll();
 
+  CIccTag *pTag = ReadTagData(pTagEntry, pIO, bReadAll);
+
+  if (!pTag)
+    return false;
+
+  SetTagEntry(pTagEntry, pTag);
+
+  return true;
+}
+
+
+/**
+ ******************************************************************************
+ * Name: CIccProfile::ReadTagData
+ * 
+ * Purpose: This will create and read the tag object for a tag directory
+ *  entry from the indicated IO object.  The profile's tag directory is not
+ *  modified so this can be called for different entries concurrently as
+ *  long as each caller uses its own IO object.
+ * 
+ * Args: 
+ *  pTagEntry - pointer to tag directory entry,
+ *  pIO - pointer to IO object to read tag object data from
+ *  bReadAll - also read all sub data of the tag
+ * 
+ * Return: 
+ *  Pointer to the new tag object, or NULL on failure
+ *******************************************************************************
+ */
+CIccTag* CIccProfile::ReadTagData(const IccTagEntry *pTagEntry, CIccIO *pIO, bool bReadAll/*=false*/)
+{
   // if the tag claims to be inside the header, or zero length, return an error
   if (pTagEntry->TagInfo.offset<sizeof(m_Header) ||
     !pTagEntry->TagInfo.size) {
-    return false;
+    return NULL;
   }
   
   // if the tag claims to be longer than the actual file, return an error
-  // NOTE - ccox - it would be nice to cache the file length instead of calculating it per tag
   if ( (pTagEntry->TagInfo.offset + pTagEntry->TagInfo.size) > pIO->GetLength())
-    return false;
+    return NULL;
 
   icTagTypeSignature sigType;
 
   //First we need to get the tag type to create the right kind of tag
   if (pIO->Seek(pTagEntry->TagInfo.offset, icSeekSet)!= pTagEntry->TagInfo.offset)
-    return false;
+    return NULL;
 
   if (!pIO->Read32(&sigType))
-    return false;
+    return NULL;
+
+  CIccMemArenaScope arenaScope(m_pArena);
 
   CIccTag *pTag = CIccTag::Create(sigType);
 
   if (!pTag)
-    return false;
+    return NULL;
 
   //Now seek back to where the tag starts so the created tag object can read
   //in its data.
   if (pIO->Seek(pTagEntry->TagInfo.offset, icSeekSet)!= pTagEntry->TagInfo.offset) {
     delete pTag;
-    return false;
+    return NULL;
   }
 
   if (!pTag->Read(pTagEntry->TagInfo.size, pIO, this)) {
     delete pTag;
-    return false;
+    return NULL;
   }
 
   if (bReadAll) {
     if (!pTag->ReadAll()) {
       delete pTag;
-      return false;
+      return NULL;
     }
   }
 
@@ -1352,6 +1563,24 @@ bool CIccProfile::LoadTag(IccTagEntry *pTagEntry, CIccIO *pIO, bool bReadAll/*=f
     break;
   }
 
+  return pTag;
+}
+
+
+/**
+ ******************************************************************************
+ * Name: CIccProfile::SetTagEntry
+ * 
+ * Purpose: Associates a newly read tag object with a tag directory entry
+ *  and with all other entries that share the same offset.
+ * 
+ * Args: 
+ *  pTagEntry - pointer to tag directory entry,
+ *  pTag - tag object read for the entry
+ *******************************************************************************
+ */
+void CIccProfile::SetTagEntry(IccTagEntry *pTagEntry, CIccTag *pTag)
+{
   pTagEntry->pTag = pTag;
 
   IccTagPtr TagPtr = {};
@@ -1367,7 +1596,125 @@ bool CIccProfile::LoadTag(IccTagEntry *pTagEntry, CIccIO *pIO, bool bReadAll/*=f
         i->pTag != pTag)
       i->pTag = pTag; 
   }
-  
+}
+
+
+/**
+ ******************************************************************************
+ * Name: CIccProfile::LoadTagsParallel
+ * 
+ * Purpose: Reads all tags in the tag directory using m_nReadThreads worker
+ *  threads.  Each worker decodes tags through its own memory IO view of the
+ *  profile data.  Entries that share an offset are decoded once and then
+ *  associated with a single tag object.
+ * 
+ * Args: 
+ *  pIO - pointer to IO object to read ICC profile from
+ * 
+ * Return: 
+ *  true - all tags were read, false - failure
+ *******************************************************************************
+ */
+bool CIccProfile::LoadTagsParallel(CIccIO *pIO)
+{
+  std::vector<IccTagEntry*> entries;
+  std::set<icUInt32Number> offsets;
+  TagEntryList::iterator i;
+
+  for (i=m_Tags.begin(); i!=m_Tags.end(); i++) {
+    if (!i->pTag && offsets.insert(i->TagInfo.offset).second)
+      entries.push_back(&(*i));
+  }
+
+  if (entries.empty())
+    return true;
+
+  //Workers share the profile data in memory
+  icUInt8Number *pData = NULL;
+  size_t nLength = 0;
+  bool bFreeData = false;
+  CIccMemIO *pMemIO = dynamic_cast<CIccMemIO*>(pIO);
+
+  if (pMemIO && pMemIO->GetData()) {
+    pData = pMemIO->GetData();
+    nLength = pMemIO->GetLength();
+  }
+  else {
+    nLength = pIO->GetLength();
+    if (!nLength)
+      return false;
+
+    pData = (icUInt8Number*)malloc(nLength);
+    if (!pData)
+      return false;
+    bFreeData = true;
+
+    if (pIO->Seek(0, icSeekSet)!=0 || pIO->Read8(pData, nLength)!=nLength) {
+      free(pData);
+      return false;
+    }
+  }
+
+  //Make sure the lazily created factories exist before workers use them
+  CIccTagCreator::GetTagSigName(icSigUnknownTag);
+  std::string elemName;
+  CIccMpeCreator::GetElementSigName(elemName, icSigUnknownElemType);
+  CIccStructCreator::GetStructSig("");
+  CIccArrayCreator::GetArraySig("");
+
+  std::vector<CIccTag*> tags(entries.size(), NULL);
+  std::atomic<size_t> nNext(0);
+  std::atomic<bool> bFailed(false);
+
+  auto worker = [&]() {
+    CIccMemIO io;
+    size_t n;
+
+    if (!io.Attach(pData, nLength)) {
+      bFailed = true;
+      return;
+    }
+
+    while (!bFailed && (n = nNext++) < entries.size()) {
+      tags[n] = ReadTagData(entries[n], &io);
+      if (!tags[n])
+        bFailed = true;
+    }
+  };
+
+  size_t nThreads = m_nReadThreads;
+  if (nThreads > entries.size())
+    nThreads = entries.size();
+
+  std::vector<std::thread> pool;
+  for (size_t t=1; t<nThreads; t++) {
+    try {
+      pool.push_back(std::thread(worker));
+    }
+    catch (...) {
+      break;
+    }
+  }
+  worker();
+
+  for (size_t t=0; t<pool.size(); t++)
+    pool[t].join();
+
+  if (bFreeData)
+    free(pData);
+
+  size_t n;
+  if (bFailed) {
+    for (n=0; n<tags.size(); n++) {
+      if (tags[n])
+        delete tags[n];
+    }
+    return false;
+  }
+
+  for (n=0; n<tags.size(); n++)
+    SetTagEntry(entries[n], tags[n]);
+
   return true;
 }
 
@@ -1415,6 +1762,8 @@ bool CIccProfile::DetachTag(CIccTag *pTag)
     else
       j++;
   }
+  IndexTags();
+
   return true;
 }
 
@@ -3193,6 +3542,219 @@ bool CIccProfile::getMediaWhiteXYZ(icFloatNumber *pXYZ)
   }
 }
 
+/**
+ ****************************************************************************
+ * Name: CIccProfile::IsProfileIDValid
+ * 
+ * Purpose: Checks whether m_Header.profileID matches the MD5 fingerprint of
+ *  the profile.  Profiles without an ID, or changed since their ID was set,
+ *  are not valid.  An attached profile that is unchanged since it was
+ *  attached is checked against the attached data.  Otherwise a copy of the
+ *  profile is written to memory, which costs about as much as writing it to
+ *  a file, so the result is retained until the header or tag directory
+ *  changes or InvalidateProfileIDMemo() is called.  The profile itself is
+ *  never changed.
+ *****************************************************************************
+ */
+bool CIccProfile::IsProfileIDValid() const
+{
+  icHeader header;
+  icUInt32Number nRevision;
+
+  {
+    std::lock_guard<std::mutex> lock(m_IdMemoMutex);
+
+    if (m_bMemoId && m_nMemoIdRevision==m_nTagsRevision &&
+        !memcmp(&m_memoIdHeader, &m_Header, sizeof(m_Header)))
+      return m_bMemoIdValid;
+
+    memcpy(&header, &m_Header, sizeof(header));
+    nRevision = m_nTagsRevision;
+  }
+
+  icProfileID id;
+  int i;
+
+  for (i=0; i<16 && !header.profileID.ID8[i]; i++);
+
+  bool bValid = false;
+
+  if (i<16) {
+    if (m_pAttachIO) {
+      //Tags not yet loaded are only available from the attached data
+      if (IsAsAttached()) {
+        std::lock_guard<std::mutex> lock(m_pAttachIO->GetReadMutex());
+
+        CalcProfileID(m_pAttachIO, &id);
+        bValid = !memcmp(&id, &header.profileID, sizeof(id));
+      }
+    }
+    else {
+      //Write() updates the header and tag directory so a copy is written
+      CIccProfile *pCopy = new CIccProfile(*this);
+      CIccMemIO memIO;
+
+      if (memIO.Alloc(ICC_PROFILE_WRITE_BUFSIZE, true)) {
+        memIO.SetGrowable();
+
+        if (pCopy->Write(&memIO, icNeverWriteID)) {
+          CalcProfileID(memIO.GetData(), memIO.GetLength(), &id);
+          bValid = !memcmp(&id, &header.profileID, sizeof(id));
+        }
+      }
+      delete pCopy;
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(m_IdMemoMutex);
+
+  m_bMemoId = true;
+  m_bMemoIdValid = bValid;
+  m_nMemoIdRevision = nRevision;
+  memcpy(&m_memoIdHeader, &header, sizeof(header));
+
+  return bValid;
+}
+
+/**
+ ****************************************************************************
+ * Name: CIccProfile::SetAttachState
+ * 
+ * Purpose: Records the header and tag directory as read from m_pAttachIO.
+ *****************************************************************************
+ */
+void CIccProfile::SetAttachState()
+{
+  TagEntryList::const_iterator i;
+
+  memcpy(&m_AttachHeader, &m_Header, sizeof(m_Header));
+
+  m_AttachTags.clear();
+  m_AttachTags.reserve(m_Tags.size());
+  for (i=m_Tags.begin(); i!=m_Tags.end(); i++)
+    m_AttachTags.push_back(i->TagInfo);
+}
+
+/**
+ ****************************************************************************
+ * Name: CIccProfile::IsAsAttached
+ * 
+ * Purpose: Checks whether the header and tag directory are still as read
+ *  from m_pAttachIO, in which case the attached data is the profile.
+ *****************************************************************************
+ */
+bool CIccProfile::IsAsAttached() const
+{
+  if (!m_pAttachIO || m_AttachTags.size()!=m_Tags.size() ||
+      memcmp(&m_AttachHeader, &m_Header, sizeof(m_Header)))
+    return false;
+
+  TagEntryList::const_iterator i;
+  TagInfoList::const_iterator j;
+
+  for (i=m_Tags.begin(), j=m_AttachTags.begin(); i!=m_Tags.end(); i++, j++) {
+    if (memcmp(&i->TagInfo, &*j, sizeof(icTag)))
+      return false;
+  }
+
+  return true;
+}
+
+/**
+ ****************************************************************************
+ * Name: CIccProfile::CopyProfileIDMemo
+ * 
+ * Purpose: Carries a current IsProfileIDValid() result of Profile over to
+ *  this copy of it, so that copies handed to CMMs are not checked again.
+ *****************************************************************************
+ */
+void CIccProfile::CopyProfileIDMemo(const CIccProfile &Profile)
+{
+  CIccProfile *pSrc = (CIccProfile*)&Profile;
+  std::lock_guard<std::mutex> lockSrc(pSrc->m_IdMemoMutex);
+
+  if (pSrc->m_bMemoId && pSrc->m_nMemoIdRevision==pSrc->m_nTagsRevision &&
+      !memcmp(&pSrc->m_memoIdHeader, &pSrc->m_Header, sizeof(m_Header))) {
+    std::lock_guard<std::mutex> lock(m_IdMemoMutex);
+
+    m_bMemoId = true;
+    m_bMemoIdValid = pSrc->m_bMemoIdValid;
+    m_nMemoIdRevision = m_nTagsRevision;
+    memcpy(&m_memoIdHeader, &m_Header, sizeof(m_Header));
+  }
+}
+
+/**
+ ****************************************************************************
+ * Name: CIccProfile::InvalidateProfileIDMemo
+ * 
+ * Purpose: Discards the result retained by IsProfileIDValid().  Must be
+ *  called by users that change tag data in place.
+ *****************************************************************************
+ */
+void CIccProfile::InvalidateProfileIDMemo()
+{
+  std::lock_guard<std::mutex> lock(m_IdMemoMutex);
+
+  m_bMemoId = false;
+}
+
+/**
+ ****************************************************************************
+ * Name: CIccProfile::InvalidatePccMemo
+ * 
+ * Purpose: Discards the illuminant and media white point values retained
+ *  by the calc functions.  Called whenever the tag directory changes, and
+ *  must be called by users that change a viewing conditions, spectral white
+ *  point or spectral data info tag in place.
+ *****************************************************************************
+ */
+void CIccProfile::InvalidatePccMemo()
+{
+  std::lock_guard<std::mutex> lock(m_PccMemoMutex);
+
+  m_pMemoCond = NULL;
+  m_bMemoNormIllum = false;
+  m_bMemoLumIllum = false;
+  m_MediaWhiteMemo.clear();
+}
+
+/**
+ ****************************************************************************
+ * Name: CIccProfile::CheckPccMemo
+ * 
+ * Purpose: Discards the retained illuminant values if they were calculated
+ *  for a different viewing conditions tag.  m_PccMemoMutex must be held.
+ *****************************************************************************
+ */
+void CIccProfile::CheckPccMemo(const CIccTagSpectralViewingConditions *pCond)
+{
+  if (pCond!=m_pMemoCond) {
+    m_pMemoCond = pCond;
+    m_bMemoNormIllum = false;
+    m_bMemoLumIllum = false;
+  }
+}
+
+/**
+ ****************************************************************************
+ * Name: CIccProfile::MemoMediaWhite
+ * 
+ * Purpose: Retains a media white point calculated for the observing viewing
+ *  conditions identified by key.  m_PccMemoMutex must be held.
+ *****************************************************************************
+ */
+void CIccProfile::MemoMediaWhite(const std::string &key, const icFloatNumber *pXYZ)
+{
+  if (m_MediaWhiteMemo.size()>=ICC_PCC_MEMO_SIZE)
+    m_MediaWhiteMemo.clear();
+
+  icFloatXYZNumber &xyz = m_MediaWhiteMemo[key];
+  xyz.X = pXYZ[0];
+  xyz.Y = pXYZ[1];
+  xyz.Z = pXYZ[2];
+}
+
 /**
  ****************************************************************************
  * Name: CIccProfile::calcNormIlluminantXYZ
@@ -3210,6 +3772,14 @@ bool CIccProfile::calcLumIlluminantXYZ(icFloatNumber *pXYZ, IIccProfileConnectio
   const CIccTagSpectralViewingConditions *pCond = getPccViewingConditions();
 
   if (pCond) {
+    std::lock_guard<std::mutex> lock(m_PccMemoMutex);
+
+    CheckPccMemo(pCond);
+    if (m_bMemoLumIllum) {
+      memcpy(pXYZ, m_memoLumIllumXYZ, sizeof(m_memoLumIllumXYZ));
+      return true;
+    }
+
     icSpectralRange illuminantRange;
     const icFloatNumber *illuminant = pCond->getIlluminant(illuminantRange);
 
@@ -3231,6 +3801,9 @@ bool CIccProfile::calcLumIlluminantXYZ(icFloatNumber *pXYZ, IIccProfileConnectio
 
     delete obs;
 
+    memcpy(m_memoLumIllumXYZ, pXYZ, sizeof(m_memoLumIllumXYZ));
+    m_bMemoLumIllum = true;
+
     return true;
   }
   else {
@@ -3256,6 +3829,14 @@ bool CIccProfile::calcNormIlluminantXYZ(icFloatNumber *pXYZ, IIccProfileConnecti
   const CIccTagSpectralViewingConditions *pCond = getPccViewingConditions();
 
   if (pCond) {
+    std::lock_guard<std::mutex> lock(m_PccMemoMutex);
+
+    CheckPccMemo(pCond);
+    if (m_bMemoNormIllum) {
+      memcpy(pXYZ, m_memoNormIllumXYZ, sizeof(m_memoNormIllumXYZ));
+      return true;
+    }
+
     icSpectralRange illuminantRange;
     const icFloatNumber *illuminant = pCond->getIlluminant(illuminantRange);
 
@@ -3278,6 +3859,9 @@ bool CIccProfile::calcNormIlluminantXYZ(icFloatNumber *pXYZ, IIccProfileConnecti
 
     delete obs;
 
+    memcpy(m_memoNormIllumXYZ, pXYZ, sizeof(m_memoNormIllumXYZ));
+    m_bMemoNormIllum = true;
+
     return true;
   }
   else {
@@ -3342,13 +3926,29 @@ getmediaXYZ:
       }
     }
 
+    std::string key;
+    pView->getConditionsKey(key);
+    key.append((const char*)&sig, sizeof(sig));
+    key.append((const char*)&range, sizeof(range));
+    key.append((const char*)&birange, sizeof(birange));
+
+    std::lock_guard<std::mutex> lock(m_PccMemoMutex);
+
+    IccPccWhiteMemo::const_iterator memo = m_MediaWhiteMemo.find(key);
+    if (memo!=m_MediaWhiteMemo.end()) {
+      pXYZ[0] = memo->second.X;
+      pXYZ[1] = memo->second.Y;
+      pXYZ[2] = memo->second.Z;
+      return true;
+    }
+
     icUInt32Number samples = icGetSpaceSamples((icColorSpaceSignature)sig);
     icFloatNumber *pWhite;
 
     if (samples && pNumTag->GetNumValues()>=samples) {
       pWhite=new icFloatNumber[samples];
       if (pWhite) {
-        pNumTag->GetValues(pWhite);
+        pNumTag->GetValues(pWhite, 0, samples);
       }
       else {
         goto getmediaXYZ;
@@ -3365,6 +3965,8 @@ getmediaXYZ:
       delete pMtx;
       delete [] pWhite;
 
+      MemoMediaWhite(key, pXYZ);
+
       return true;
     }
     else if (icIsSameColorSpaceType(sig, icSigRadiantSpectralData)) {
@@ -3374,6 +3976,8 @@ getmediaXYZ:
       obs.VectorMult(pXYZ, pWhite);
       delete [] pWhite;
 
+      MemoMediaWhite(key, pXYZ);
+
       return true;
     }
     else {
@@ -3392,6 +3996,64 @@ getmediaXYZ:
 //  Function Definitions
 //////////////////////////////////////////////////////////////////////
 
+/**
+ *****************************************************************************
+ * Name: icOpenProfileIO
+ * 
+ * Purpose: Opens a profile file for reading.  When bMapFile is set a read
+ *  only memory mapping of the file is used when available with a fall back
+ *  to stdio file access.
+ * 
+ * Args: 
+ *  szFilename - zero terminated string with filename of ICC profile to open
+ *  bMapFile - use a memory mapping (see CIccMmapIO for the hazards)
+ *
+ * Return: 
+ *  Pointer to IO object, or NULL on failure
+ ******************************************************************************
+ */
+static CIccIO *icOpenProfileIO(const icChar *szFilename, bool bMapFile)
+{
+  if (bMapFile) {
+    CIccMmapIO *pMmapIO = new CIccMmapIO;
+
+    if (pMmapIO->Open(szFilename))
+      return pMmapIO;
+    delete pMmapIO;
+  }
+
+  CIccFileIO *pFileIO = new CIccFileIO;
+
+  if (!pFileIO->Open(szFilename, "rb")) {
+    delete pFileIO;
+    return NULL;
+  }
+
+  return pFileIO;
+}
+
+#ifdef WIN32
+static CIccIO *icOpenProfileIO(const icWChar *szFilename, bool bMapFile)
+{
+  if (bMapFile) {
+    CIccMmapIO *pMmapIO = new CIccMmapIO;
+
+    if (pMmapIO->Open(szFilename))
+      return pMmapIO;
+    delete pMmapIO;
+  }
+
+  CIccFileIO *pFileIO = new CIccFileIO;
+
+  if (!pFileIO->Open(szFilename, L"rb")) {
+    delete pFileIO;
+    return NULL;
+  }
+
+  return pFileIO;
+}
+#endif
+
 /**
  *****************************************************************************
  * Name: ReadIccProfile
@@ -3408,12 +4070,10 @@ getmediaXYZ:
  */
 CIccProfile* ReadIccProfile(const icChar *szFilename, bool bUseSubProfile/*=false*/)
 {
-  CIccFileIO *pFileIO = new CIccFileIO;
+  CIccIO *pFileIO = icOpenProfileIO(szFilename, true);
 
-  if (!pFileIO->Open(szFilename, "rb")) {
-    delete pFileIO;
+  if (!pFileIO)
     return NULL;
-  }
 
   CIccProfile *pIcc = new CIccProfile;
 
@@ -3445,12 +4105,10 @@ CIccProfile* ReadIccProfile(const icChar *szFilename, bool bUseSubProfile/*=fals
 */
 CIccProfile* ReadIccProfile(const icWChar *szFilename, bool bUseSubProfile/*=false*/)
 {
-  CIccFileIO *pFileIO = new CIccFileIO;
+  CIccIO *pFileIO = icOpenProfileIO(szFilename, true);
 
-  if (!pFileIO->Open(szFilename, L"rb")) {
-    delete pFileIO;
+  if (!pFileIO)
     return NULL;
-  }
 
   CIccProfile *pIcc = new CIccProfile;
 
@@ -3514,19 +4172,20 @@ CIccProfile* ReadIccProfile(const icUInt8Number *pMem, icUInt32Number nSize, boo
  * Args: 
  *  szFilename - zero terminated string with filename of ICC profile to read
  *  bUseSubProfile - will attempt to open a subprofile if present
+ *  bMapFile - read tags through a memory mapping of the file.  The file
+ *   must not be truncated while the profile is open since reading a tag
+ *   from the missing part raises SIGBUS (an exception on Windows).
  * 
  * Return: 
  *  Pointer to icc profile object, or NULL on failure
  *******************************************************************************
  */
-CIccProfile* OpenIccProfile(const icChar *szFilename, bool bUseSubProfile/*=false*/)
+CIccProfile* OpenIccProfile(const icChar *szFilename, bool bUseSubProfile/*=false*/, bool bMapFile/*=false*/)
 {
-  CIccFileIO *pFileIO = new CIccFileIO;
+  CIccIO *pFileIO = icOpenProfileIO(szFilename, bMapFile);
 
-  if (!pFileIO->Open(szFilename, "rb")) {
-    delete pFileIO;
+  if (!pFileIO)
     return NULL;
-  }
 
   CIccProfile *pIcc = new CIccProfile;
 
@@ -3551,19 +4210,19 @@ CIccProfile* OpenIccProfile(const icChar *szFilename, bool bUseSubProfile/*=fals
 * Args: 
 *  szFilename - zero terminated string with filename of ICC profile to read 
 *  bUseSubProfile - will attempt to open a subprofile if present
+*  bMapFile - read tags through a memory mapping of the file.  The file
+*   must not be truncated while the profile is open.
 *
 * Return: 
 *  Pointer to icc profile object, or NULL on failure
 *******************************************************************************
 */
-CIccProfile* OpenIccProfile(const icWChar *szFilename, bool bUseSubProfile/*=false*/)
+CIccProfile* OpenIccProfile(const icWChar *szFilename, bool bUseSubProfile/*=false*/, bool bMapFile/*=false*/)
 {
-  CIccFileIO *pFileIO = new CIccFileIO;
+  CIccIO *pFileIO = icOpenProfileIO(szFilename, bMapFile);
 
-  if (!pFileIO->Open(szFilename, L"rb")) {
-    delete pFileIO;
+  if (!pFileIO)
     return NULL;
-  }
 
   CIccProfile *pIcc = new CIccProfile;
 
@@ -3897,11 +4556,56 @@ bool SaveIccProfile(const icWChar *szFilename, CIccProfile *pIcc, icProfileIDSav
 }
 #endif
 
+/**
+ ****************************************************************************
+ * Name: CalcProfileID
+ * 
+ * Purpose: Calculate the Profile ID using MD5 Fingerprinting method for a
+ *  profile held in memory.  The header fields excluded from the ID are
+ *  zeroed in a local copy of the header so the data is hashed in place.
+ * 
+ * Args: 
+ *  pData = the profile bytes,
+ *  nSize = number of bytes in the profile,
+ *  pProfileID = array where the profileID will be stored
+ ****************************************************************************
+ */
+void CalcProfileID(const icUInt8Number *pData, size_t nSize, icProfileID *pProfileID)
+{
+  MD5_CTX context;
+  icUInt8Number header[sizeof(icHeader)] = {0};
+  size_t nHeader = nSize < sizeof(header) ? nSize : sizeof(header);
+
+  icMD5Init(&context);
+
+  // Zero out 3 header contents in Profile ID calculation
+  memcpy(header, pData, nHeader);
+  memset(header+44, 0, 4); //Profile flags
+  memset(header+64, 0, 4);  //Rendering Intent
+  memset(header+84, 0, 16); //Profile Id
+  icMD5Update(&context, header, (unsigned int)nHeader);
+
+  pData += nHeader;
+  nSize -= nHeader;
+
+  //icMD5Update takes a 32 bit length
+  while (nSize) {
+    unsigned int num = nSize > 0x40000000 ? 0x40000000 : (unsigned int)nSize;
+    icMD5Update(&context, (unsigned char*)pData, num);
+    pData += num;
+    nSize -= num;
+  }
+
+  icMD5Final(&pProfileID->ID8[0],&context);
+}
+
 /**
  ****************************************************************************
  * Name: CalcProfileID
  * 
  * Purpose: Calculate the Profile ID using MD5 Fingerprinting method. 
+ *  Memory based IO objects (including memory mapped files) are hashed in
+ *  place, otherwise the profile is read in large blocks.
  * 
  * Args: 
  *  pIO = The CIccIO object,
@@ -3909,11 +4613,21 @@ bool SaveIccProfile(const icWChar *szFilename, CIccProfile *pIcc, icProfileIDSav
  *
  ****************************************************************************
  */
+#define ICC_PROFILEID_BUFSIZE 65536
 void CalcProfileID(CIccIO *pIO, icProfileID *pProfileID)
 {
+  CIccMemIO *pMemIO = dynamic_cast<CIccMemIO*>(pIO);
+
+  if (pMemIO && pMemIO->GetData()) {
+    CalcProfileID(pMemIO->GetData(), pMemIO->GetLength(), pProfileID);
+    return;
+  }
+
   icUInt32Number nBlock;
   MD5_CTX context;
-  icUInt8Number buffer[1024] = {0};
+  icUInt8Number *buffer = new icUInt8Number[ICC_PROFILEID_BUFSIZE];
+
+  memset(buffer, 0, ICC_PROFILEID_BUFSIZE);
 
   //remember where we are
   size_t pos = pIO->Tell();
@@ -3926,7 +4640,7 @@ void CalcProfileID(CIccIO *pIO, icProfileID *pProfileID)
   icMD5Init(&context);
   nBlock = 0;
   while(len) {
-    size_t num = pIO->Read8(&buffer[0],1024);
+    size_t num = pIO->Read8(&buffer[0], ICC_PROFILEID_BUFSIZE);
     if (num == 0)
         break;              // can't give a useful error here, but we need to break the infinite loop
     if (!nBlock) {  // Zero out 3 header contents in Profile ID calculation
@@ -3940,6 +4654,8 @@ void CalcProfileID(CIccIO *pIO, icProfileID *pProfileID)
   }
   icMD5Final(&pProfileID->ID8[0],&context);
 
+  delete [] buffer;
+
   //go back where we were
   pIO->Seek(pos, icSeekSet);
 }
@@ -3957,17 +4673,190 @@ void CalcProfileID(CIccIO *pIO, icProfileID *pProfileID)
  */
 bool CalcProfileID(const icChar *szFilename, icProfileID *pProfileID)
 {
-  CIccFileIO FileIO;
+  CIccIO *pFileIO = icOpenProfileIO(szFilename, true);
 
-  if (!FileIO.Open(szFilename, "rb")) {
+  if (!pFileIO) {
     memset(pProfileID, 0, sizeof(icProfileID));
     return false;
   }
 
-  CalcProfileID(&FileIO, pProfileID);
+  CalcProfileID(pFileIO, pProfileID);
+  delete pFileIO;
+
   return true;
 }
 
+/**
+ ****************************************************************************
+ * Name: CIccProfileIdCache::CIccProfileIdCache
+ * 
+ * Purpose: Constructor
+ * 
+ * Args: 
+ *  nMaxEntries = number of profile IDs retained before the least recently
+ *   used ones are discarded
+ *****************************************************************************
+ */
+CIccProfileIdCache::CIccProfileIdCache(icUInt32Number nMaxEntries/*=ICC_PROFILEID_CACHE_SIZE*/)
+{
+  m_nMaxEntries = nMaxEntries ? nMaxEntries : 1;
+}
+
+/**
+ ****************************************************************************
+ * Name: CIccProfileIdCache::GetProfileID
+ * 
+ * Purpose: Get the Profile ID of a profile file, calculating it only if the
+ *  file is not in the cache or its size or modification time has changed.
+ * 
+ * Args: 
+ *  szFileName = name of the profile file,
+ *  pProfileID = array where the profileID will be stored
+ * 
+ * Return:
+ *  true if the profile ID was found or calculated, false if the file
+ *  could not be opened.
+ *****************************************************************************
+ */
+bool CIccProfileIdCache::GetProfileID(const icChar *szFilename, icProfileID *pProfileID)
+{
+#ifdef WIN32
+  struct __stat64 st;
+  if (_stat64(szFilename, &st)) {
+#else
+  struct stat st;
+  if (stat(szFilename, &st)) {
+#endif
+    memset(pProfileID, 0, sizeof(icProfileID));
+    return false;
+  }
+
+  std::string path(szFilename);
+  icUInt64Number nSize = (icUInt64Number)st.st_size;
+  icUInt64Number nModTime = (icUInt64Number)st.st_mtime * 1000000000;
+#if defined(__APPLE__)
+  nModTime += (icUInt64Number)st.st_mtimespec.tv_nsec;
+#elif !defined(WIN32)
+  nModTime += (icUInt64Number)st.st_mtim.tv_nsec;
+#endif
+
+  {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    auto i = m_Index.find(path);
+    if (i!=m_Index.end()) {
+      IccProfileIdList::iterator e = i->second;
+      if (e->nSize==nSize && e->nModTime==nModTime) {
+        memcpy(pProfileID, &e->id, sizeof(icProfileID));
+        m_Entries.splice(m_Entries.begin(), m_Entries, e);
+        return true;
+      }
+      m_Entries.erase(e);
+      m_Index.erase(i);
+    }
+  }
+
+  //Calculate outside the lock so other files can be looked up meanwhile
+  IccProfileIdEntry entry;
+  if (!CalcProfileID(szFilename, &entry.id)) {
+    memset(pProfileID, 0, sizeof(icProfileID));
+    return false;
+  }
+  entry.path = path;
+  entry.nSize = nSize;
+  entry.nModTime = nModTime;
+
+  memcpy(pProfileID, &entry.id, sizeof(icProfileID));
+
+  std::lock_guard<std::mutex> lock(m_Mutex);
+
+  if (m_Index.find(path)==m_Index.end()) {
+    m_Entries.push_front(entry);
+    m_Index[path] = m_Entries.begin();
+
+    while (m_Entries.size() > m_nMaxEntries) {
+      m_Index.erase(m_Entries.back().path);
+      m_Entries.pop_back();
+    }
+  }
+
+  return true;
+}
+
+/**
+ ****************************************************************************
+ * Name: CIccProfileIdCache::SetMaxEntries
+ * 
+ * Purpose: Sets the number of profile IDs retained, discarding the least
+ *  recently used ones if the cache is now over the limit.
+ *****************************************************************************
+ */
+void CIccProfileIdCache::SetMaxEntries(icUInt32Number nMaxEntries)
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+
+  m_nMaxEntries = nMaxEntries ? nMaxEntries : 1;
+
+  while (m_Entries.size() > m_nMaxEntries) {
+    m_Index.erase(m_Entries.back().path);
+    m_Entries.pop_back();
+  }
+}
+
+/**
+ ****************************************************************************
+ * Name: CIccProfileIdCache::Clear
+ * 
+ * Purpose: Discard all cached profile IDs
+ *****************************************************************************
+ */
+void CIccProfileIdCache::Clear()
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+
+  m_Index.clear();
+  m_Entries.clear();
+}
+
+size_t CIccProfileIdCache::GetCount()
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+
+  return m_Entries.size();
+}
+
+/**
+ ****************************************************************************
+ * Name: GetProfileIdCache
+ * 
+ * Purpose: Returns the process wide CIccProfileIdCache used by
+ *  CalcCachedProfileID() so that its size can be configured.
+ *****************************************************************************
+ */
+CIccProfileIdCache &GetProfileIdCache()
+{
+  static CIccProfileIdCache cache;
+
+  return cache;
+}
+
+/**
+ ****************************************************************************
+ * Name: CalcCachedProfileID
+ * 
+ * Purpose: Get the Profile ID of a profile file using the process wide
+ *  CIccProfileIdCache.
+ * 
+ * Args: 
+ *  szFileName = name of the profile file,
+ *  pProfileID = array where the profileID will be stored
+ *****************************************************************************
+ */
+bool CalcCachedProfileID(const icChar *szFilename, icProfileID *pProfileID)
+{
+  return GetProfileIdCache().GetProfileID(szFilename, pProfileID);
+}
+
 #ifdef WIN32
 /**
 ****************************************************************************
@@ -3982,14 +4871,16 @@ bool CalcProfileID(const icChar *szFilename, icProfileID *pProfileID)
 */
 bool CalcProfileID(const icWChar *szFilename, icProfileID *pProfileID)
 {
-  CIccFileIO FileIO;
+  CIccIO *pFileIO = icOpenProfileIO(szFilename, true);
 
-  if (!FileIO.Open(szFilename, L"rb")) {
+  if (!pFileIO) {
     memset(pProfileID, 0, sizeof(icProfileID));
     return false;
   }
 
-  CalcProfileID(&FileIO, pProfileID);
+  CalcProfileID(pFileIO, pProfileID);
+  delete pFileIO;
+
   return true;
 }
 #endif
@@ -70,7 +70,12 @@
 #include "IccDefs.h"
 #include "IccPcc.h"
 #include <list>
+#include <vector>
 #include <string>
+#include <utility>
+#include <unordered_map>
+#include <mutex>
+#include <ctime>
 
 #if defined(__cplusplus) && defined(USEICCDEVNAMESPACE)
 namespace iccDEV {
@@ -81,6 +86,7 @@ namespace iccDEV {
 class ICCPROFLIB_API CIccTag;
 class ICCPROFLIB_API CIccIO;
 class ICCPROFLIB_API CIccMemIO;
+class ICCPROFLIB_API CIccMemArena;
 
 /**
  **************************************************************************
@@ -127,6 +133,38 @@ typedef struct {CIccTag *ptr;} IccTagPtr;
  */
 typedef std::list<IccTagPtr> TagPtrList;
 
+/**
+ **************************************************************************
+ * Type: Vector
+ * 
+ * Purpose: Tag entries ordered by signature for indexed lookup.  Entries
+ *  with the same signature keep their tag directory order.
+ *  
+ **************************************************************************
+ */
+typedef std::vector<IccTagEntry*> TagEntryIndex;
+
+/**
+ **************************************************************************
+ * Type: Vector
+ * 
+ * Purpose: Copy of a tag directory in directory order.
+ *  
+ **************************************************************************
+ */
+typedef std::vector<icTag> TagInfoList;
+
+/**
+ **************************************************************************
+ * Type: Map
+ * 
+ * Purpose: Media white points calculated for observing viewing conditions,
+ *  keyed by CIccTagSpectralViewingConditions::getConditionsKey()
+ **************************************************************************
+ */
+#define ICC_PCC_MEMO_SIZE 16
+typedef std::unordered_map<std::string, icFloatXYZNumber> IccPccWhiteMemo;
+
 typedef enum {
   icVersionBasedID,
   icAlwaysWriteID,
@@ -170,6 +208,10 @@ public:
   void CopyAttach(CIccProfile* pProfile, bool bSharedIO=false);
 
   bool Read(CIccIO *pIO, bool bUseSubProfile=false);
+  void SetReadThreads(icUInt32Number nThreads) { m_nReadThreads = nThreads ? nThreads : 1; }
+  icUInt32Number GetReadThreads() const { return m_nReadThreads; }
+  void UseArena(bool bUseArena=true);
+  bool UsesArena() const { return m_pArena != NULL; }
   icValidateStatus ReadValidate(CIccIO *pIO, std::string &sReport);
   bool Write(CIccIO *pIO, icProfileIDSaveMethod nWriteId=icVersionBasedID);
 
@@ -210,6 +252,18 @@ public:
   bool calcLumIlluminantXYZ(icFloatNumber *pXYZ, IIccProfileConnectionConditions *pObservingPCC);
   bool calcMediaWhiteXYZ(icFloatNumber *pXYZ, IIccProfileConnectionConditions *pObservingPCC);
 
+  //Must be called if tags used by the calc functions above are changed in place
+  void InvalidatePccMemo();
+
+  //Must be called after entries are added to or removed from m_Tags directly
+  void IndexTags();
+
+  //Checks m_Header.profileID against an ID calculated from the profile contents.
+  //The result is retained while the header and tag directory are unchanged.
+  bool IsProfileIDValid() const;
+  //Must be called if tag data is changed in place after IsProfileIDValid()
+  void InvalidateProfileIDMemo();
+
 protected:
 
   void Cleanup();
@@ -218,7 +272,15 @@ protected:
   IccTagEntry* GetTag(CIccTag *pTag) const;
   bool ReadBasic(CIccIO *pIO);
   bool LoadTag(IccTagEntry *pTagEntry, CIccIO *pIO, bool bReadAll=false);
+  CIccTag* ReadTagData(const IccTagEntry *pTagEntry, CIccIO *pIO, bool bReadAll=false);
+  void SetTagEntry(IccTagEntry *pTagEntry, CIccTag *pTag);
+  bool LoadTagsParallel(CIccIO *pIO);
   bool DetachTag(CIccTag *pTag);
+  void CheckPccMemo(const CIccTagSpectralViewingConditions *pCond);
+  void CopyProfileIDMemo(const CIccProfile &Profile);
+  void SetAttachState();
+  bool IsAsAttached() const;
+  void MemoMediaWhite(const std::string &key, const icFloatNumber *pXYZ);
 
   CIccIO* ConnectSubProfile(CIccIO *pIO, bool bOwnIO) const;
 
@@ -243,14 +305,46 @@ protected:
   CIccIO *m_pAttachIO;
   bool m_bSharedIO = false;
 
+  //Number of worker threads used by Read() to decode tags
+  icUInt32Number m_nReadThreads = 1;
+
+  //Arena that tag objects are allocated from while being read (NULL for heap)
+  CIccMemArena *m_pArena = NULL;
+
+  //Header and tag directory as read from m_pAttachIO
+  icHeader m_AttachHeader;
+  TagInfoList m_AttachTags;
+
   TagPtrList m_TagVals;
 
+  //Signature index of m_Tags, only used while it has an entry for each tag
+  TagEntryIndex m_TagIndex;
+
+  //Counts changes to the tag directory made through CIccProfile
+  icUInt32Number m_nTagsRevision = 0;
+
   icColorSpaceSignature m_parentColorSpace = icSigNoColorData;
+
+  //Results of the calc functions retained for the viewing conditions in m_pMemoCond
+  std::mutex m_PccMemoMutex;
+  const CIccTagSpectralViewingConditions *m_pMemoCond = NULL;
+  bool m_bMemoNormIllum = false;
+  bool m_bMemoLumIllum = false;
+  icFloatNumber m_memoNormIllumXYZ[3];
+  icFloatNumber m_memoLumIllumXYZ[3];
+  IccPccWhiteMemo m_MediaWhiteMemo;
+
+  //Result of IsProfileIDValid() for m_memoIdHeader and m_nMemoIdRevision
+  mutable std::mutex m_IdMemoMutex;
+  mutable bool m_bMemoId = false;
+  mutable bool m_bMemoIdValid = false;
+  mutable icUInt32Number m_nMemoIdRevision = 0;
+  mutable icHeader m_memoIdHeader;
 };
 
 CIccProfile ICCPROFLIB_API *ReadIccProfile(const icChar *szFilename, bool bUseSubProfile=false);
 CIccProfile ICCPROFLIB_API *ReadIccProfile(const icUInt8Number *pMem, icUInt32Number nSize, bool bUseSubProfile=false);
-CIccProfile ICCPROFLIB_API *OpenIccProfile(const icChar *szFilename, bool bUseSubProfile=false);
+CIccProfile ICCPROFLIB_API *OpenIccProfile(const icChar *szFilename, bool bUseSubProfile=false, bool bMapFile=false);
 CIccProfile ICCPROFLIB_API *OpenIccProfile(const icUInt8Number *pMem, icUInt32Number nSize, bool bUseSubProfile=false);  //pMem must be available for entire life of returned CIccProfile Object
 
 CIccProfile ICCPROFLIB_API *ValidateIccProfile(CIccIO *pIO, std::string &sReport, icValidateStatus &nStatus);
@@ -261,11 +355,63 @@ bool ICCPROFLIB_API SaveIccProfile(const icChar *szFilename, CIccProfile *pIcc,
 bool ICCPROFLIB_API SaveIccProfile(FILE *f, CIccProfile *pIcc, icProfileIDSaveMethod nWriteId = icVersionBasedID);
 
 void ICCPROFLIB_API CalcProfileID(CIccIO *pIO, icProfileID *profileID);
+void ICCPROFLIB_API CalcProfileID(const icUInt8Number *pData, size_t nSize, icProfileID *profileID);
 bool ICCPROFLIB_API CalcProfileID(const icChar *szFilename, icProfileID *profileID);
 
+/**
+ **************************************************************************
+ * Type: Class
+ * 
+ * Purpose: 
+ *  Least recently used cache of profile IDs calculated from profile files.
+ *  Entries are keyed by file path, size and modification time so that a
+ *  file that changes is fingerprinted again.  Access is thread safe.
+ *
+ *  Modification times are compared in nanoseconds where the platform
+ *  provides them.  On Windows they only have one second resolution, so a
+ *  file rewritten with the same size within the same second as it was
+ *  cached is not detected.
+ **************************************************************************
+ */
+#ifndef ICC_PROFILEID_CACHE_SIZE
+#define ICC_PROFILEID_CACHE_SIZE 65536
+#endif
+class ICCPROFLIB_API CIccProfileIdCache
+{
+public:
+  CIccProfileIdCache(icUInt32Number nMaxEntries=ICC_PROFILEID_CACHE_SIZE);
+
+  bool GetProfileID(const icChar *szFilename, icProfileID *pProfileID);
+
+  void SetMaxEntries(icUInt32Number nMaxEntries);
+  icUInt32Number GetMaxEntries() const { return m_nMaxEntries; }
+
+  void Clear();
+  size_t GetCount();
+
+protected:
+  struct IccProfileIdEntry {
+    std::string path;
+    icUInt64Number nSize;
+    icUInt64Number nModTime;  //nanoseconds where available
+    icProfileID id;
+  };
+  typedef std::list<IccProfileIdEntry> IccProfileIdList;
+
+  //Entries in most recently used order
+  IccProfileIdList m_Entries;
+  std::unordered_map<std::string, IccProfileIdList::iterator> m_Index;
+
+  icUInt32Number m_nMaxEntries;
+  std::mutex m_Mutex;
+};
+
+CIccProfileIdCache ICCPROFLIB_API &GetProfileIdCache();
+bool ICCPROFLIB_API CalcCachedProfileID(const icChar *szFilename, icProfileID *profileID);
+
 #ifdef WIN32
 CIccProfile ICCPROFLIB_API *ReadIccProfile(const icWChar *szFilename, bool bUseSubProfile=false);
-CIccProfile ICCPROFLIB_API *OpenIccProfile(const icWChar *szFilename, bool bUseSubProfile=false);
+CIccProfile ICCPROFLIB_API *OpenIccProfile(const icWChar *szFilename, bool bUseSubProfile=false, bool bMapFile=false);
 CIccProfile ICCPROFLIB_API *ValidateIccProfile(const icWChar *szFilename, std::string &sReport, icValidateStatus &nStatus);
 bool ICCPROFLIB_API SaveIccProfile(const icWChar *szFilename, CIccProfile *pIcc, icProfileIDSaveMethod nWriteId=icVersionBasedID);
 bool ICCPROFLIB_API CalcProfileID(const icWChar *szFilename, icProfileID *profileID);
@@ -68,6 +68,7 @@
 #define _ICCSEARCH_H
 
 #include <cmath>
+#include <algorithm>
 #include <stdexcept>
 #include <vector>
 #include "IccDefs.h"
@@ -78,59 +79,62 @@ namespace iccDEV {
 
   typedef std::vector<icFloatNumber> icFloatVector;
 
+  //Largest number of dimensions that can be searched
+#define ICC_SEARCHVEC_MAXSIZE 16
+
+  //Fixed capacity vector so that search arithmetic never touches the heap
   class CIccSearchVec {
   public:
-    CIccSearchVec() {}
-    CIccSearchVec(unsigned int n) : n(n) {
-      val.resize(n, 0);
+    CIccSearchVec() : n(0) {}
+    CIccSearchVec(unsigned int n) : n(checkSize(n)) {
+      std::fill(val, val + n, (icFloatNumber)0);
     }
     CIccSearchVec(std::initializer_list<icFloatNumber> c) {
-      n = (unsigned int)c.size();
-      val.resize(n);
-      std::copy(c.begin(), c.end(), val.begin());
+      n = checkSize((unsigned int)c.size());
+      std::copy(c.begin(), c.end(), val);
     }
     CIccSearchVec(const CIccSearchVec& lhs) {
-      val = lhs.val;
       n = lhs.n;
+      std::copy(lhs.val, lhs.val + n, val);
     }
     CIccSearchVec(const icFloatVector& lhs) {
-      val = lhs;
-      n = (unsigned int)lhs.size();
+      n = checkSize((unsigned int)lhs.size());
+      std::copy(lhs.begin(), lhs.end(), val);
+    }
+    CIccSearchVec(const icFloatNumber* lhs, unsigned int _n) {
+      n = checkSize(_n);
+      std::copy(lhs, lhs + n, val);
     }
     icFloatNumber operator()(unsigned int idx) const {
-      if (idx >= n) {
-        throw std::range_error("Element access out of range");
-      }
       return val[idx];
     }
     icFloatNumber& operator()(unsigned int idx) {
-      if (idx >= n) {
-        throw std::range_error("Element access out of range");
-      }
       return val[idx];
     }
 
-    CIccSearchVec operator=(const CIccSearchVec& rhs) {
-      val = rhs.val;
+    CIccSearchVec& operator=(const CIccSearchVec& rhs) {
       n = rhs.n;
+      std::copy(rhs.val, rhs.val + n, val);
       return *this;
     }
 
-    CIccSearchVec operator=(const icFloatVector& rhs) {
-      val = rhs;
-      n = (unsigned int)rhs.size();
+    CIccSearchVec& operator=(const icFloatVector& rhs) {
+      n = checkSize((unsigned int)rhs.size());
+      std::copy(rhs.begin(), rhs.end(), val);
       return *this;
     }
 
     CIccSearchVec operator+(const CIccSearchVec& rhs) const {
-      CIccSearchVec lhs(n);
+      CIccSearchVec lhs;
+      lhs.n = n;
       for (unsigned int i = 0; i < n; i++) {
         lhs.val[i] = val[i] + rhs.val[i];
       }
       return lhs;
     }
     CIccSearchVec operator-(const CIccSearchVec& rhs) const {
-      CIccSearchVec lhs(n);
+      CIccSearchVec lhs;
+      lhs.n = n;
       for (unsigned int i = 0; i < n; i++) {
         lhs.val[i] = val[i] - rhs.val[i];
       }
@@ -138,16 +142,14 @@ namespace iccDEV {
     }
 
     CIccSearchVec operator/(icFloatNumber rhs) const {
-      CIccSearchVec lhs(n);
+      CIccSearchVec lhs;
+      lhs.n = n;
       for (unsigned int i = 0; i < n; i++) {
         lhs.val[i] = val[i] / rhs;
       }
       return lhs;
     }
     CIccSearchVec& operator+=(const CIccSearchVec& rhs) {
-      if (n != rhs.n)
-        throw std::invalid_argument(
-          "The two vectors must have the same length");
       for (unsigned int i = 0; i < n; i++) {
         val[i] += rhs.val[i];
       }
@@ -155,9 +157,6 @@ namespace iccDEV {
     }
 
     CIccSearchVec& operator-=(const CIccSearchVec& rhs) {
-      if (n != rhs.n)
-        throw std::invalid_argument(
-          "The two vectors must have the same length");
       for (unsigned int i = 0; i < n; i++) {
         val[i] -= rhs.val[i];
       }
@@ -181,7 +180,9 @@ namespace iccDEV {
       return n;
     }
     unsigned int resize(unsigned int _n) {
-      val.resize(_n);
+      checkSize(_n);
+      if (_n > n)
+        std::fill(val + n, val + _n, (icFloatNumber)0);
       n = _n;
       return n;
     }
@@ -192,12 +193,19 @@ namespace iccDEV {
       }
       return std::sqrt(ans);
     }
-    icFloatVector& vec() {
+    icFloatVector vec() const {
+      return icFloatVector(val, val + n);
+    }
+    icFloatNumber* data() {
+      return val;
+    }
+    const icFloatNumber* data() const {
       return val;
     }
     friend CIccSearchVec operator*(icFloatNumber a, const CIccSearchVec& b) {
-      CIccSearchVec c(b.size());
-      for (unsigned int i = 0; i < b.size(); i++) {
+      CIccSearchVec c;
+      c.n = b.n;
+      for (unsigned int i = 0; i < b.n; i++) {
         c.val[i] = a * b.val[i];
       }
       return c;
@@ -206,7 +214,13 @@ namespace iccDEV {
     icFloatNumber index(size_t i) const { return val[i]; }
 
   private:
-    icFloatVector val;
+    static unsigned int checkSize(unsigned int _n) {
+      if (_n > ICC_SEARCHVEC_MAXSIZE)
+        throw std::length_error("Search vector too large");
+      return _n;
+    }
+
+    icFloatNumber val[ICC_SEARCHVEC_MAXSIZE];
     unsigned int   n;
   };
 
@@ -225,6 +239,34 @@ namespace iccDEV {
     }
 
     icFloatVector findMin(icFloatVector& startingPoint, const std::vector<icFloatVector>& startingSimplex = {}) {
+      //Searches larger than a search vector can hold have no result
+      unsigned int nDimension = (unsigned int)startingPoint.size();
+      if (nDimension <= 0 || nDimension > ICC_SEARCHVEC_MAXSIZE)
+        return icFloatVector();
+
+      CIccSearchVec simplex[ICC_SEARCHVEC_MAXSIZE + 1];
+      const CIccSearchVec* pSimplex = nullptr;
+
+      if (!startingSimplex.empty()) {
+        if (startingSimplex.size() != nDimension + 1)
+          return icFloatVector(nDimension);
+
+        for (unsigned int i = 0; i < startingSimplex.size(); i++) {
+          if (startingSimplex[i].size() != nDimension)
+            return icFloatVector(nDimension);
+          simplex[i] = startingSimplex[i];
+        }
+        pSimplex = simplex;
+      }
+
+      CIccSearchVec result;
+      findMin(result, CIccSearchVec(startingPoint), pSimplex);
+
+      return result.vec();
+    }
+
+    //Allocation free search, pStartingSimplex is either NULL or has startingPoint.size()+1 points
+    bool findMin(CIccSearchVec& result, const CIccSearchVec& startingPoint, const CIccSearchVec* pStartingSimplex = nullptr) {
       unsigned int nFuncCallCount = 0;
       icFloatNumber cost;
       auto  f = [&](CIccSearchVec& p) {
@@ -235,9 +277,11 @@ namespace iccDEV {
       };
 
       // Getting the dimension of function input
-      unsigned int nDimension = (unsigned int)startingPoint.size();
-      if (nDimension <= 0)
-        return icFloatVector();
+      unsigned int nDimension = startingPoint.size();
+      if (nDimension <= 0) {
+        result.resize(0);
+        return false;
+      }
 
       // Setting parameters
       icFloatNumber alpha, beta, gamma, delta;
@@ -256,8 +300,9 @@ namespace iccDEV {
       }
 
       // Generate initial simplex
-      std::vector<CIccSearchVec> simplex(nDimension + 1);
-      if (startingSimplex.empty()) {
+      unsigned int nSimplex = nDimension + 1;
+      CIccSearchVec simplex[ICC_SEARCHVEC_MAXSIZE + 1];
+      if (!pStartingSimplex) {
         simplex[0] = startingPoint;
         for (unsigned int i = 1; i <= nDimension; i++) {
           CIccSearchVec p(startingPoint);
@@ -267,17 +312,14 @@ namespace iccDEV {
         }
       }
       else {
-        if (startingSimplex.size() != nDimension + 1)
-          return icFloatVector(nDimension);
-
-        for (unsigned int i = 0; i < startingSimplex.size(); i++) {
-          simplex[i] = startingSimplex[i];
+        for (unsigned int i = 0; i < nSimplex; i++) {
+          simplex[i] = pStartingSimplex[i];
         }
       }
 
-      std::vector<std::pair<bool, icFloatNumber>> valueCache(nDimension + 1);
-      for (auto& v : valueCache) {
-        v.first = false;
+      std::pair<bool, icFloatNumber> valueCache[ICC_SEARCHVEC_MAXSIZE + 1];
+      for (unsigned int i = 0; i < nSimplex; i++) {
+        valueCache[i].first = false;
       }
       unsigned int idxBiggest = 0;
       unsigned int idxSmallest = 0;
@@ -303,7 +345,7 @@ namespace iccDEV {
         valSecondBiggest = val;
         idxBiggest = 0;
         idxSmallest = 0;
-        for (size_t i = 1; i < simplex.size(); i++) {
+        for (unsigned int i = 1; i < nSimplex; i++) {
           icFloatNumber valLocal;
           if (!valueCache[i].first) {
             valLocal = f(simplex[i]);
@@ -314,11 +356,11 @@ namespace iccDEV {
             valLocal = valueCache[i].second;
           }
           if (valLocal > valBiggest) {
-            idxBiggest = (unsigned int)i;
+            idxBiggest = i;
             valBiggest = valLocal;
           }
           else if (valLocal < valSmallest) {
-            idxSmallest = (unsigned int)i;
+            idxSmallest = i;
             valSmallest = valLocal;
           }
         }
@@ -328,7 +370,7 @@ namespace iccDEV {
         // optimization
         icFloatNumber maxValDiff = 0;
         icFloatNumber maxPointDiff = 0;
-        for (size_t i = 0; i < simplex.size(); i++) {
+        for (unsigned int i = 0; i < nSimplex; i++) {
           icFloatNumber valLocal = valueCache[i].second;
           if (i != idxBiggest && valLocal > valSecondBiggest) {
             valSecondBiggest = valLocal;
@@ -343,15 +385,13 @@ namespace iccDEV {
         }
         if ((maxValDiff <= funcTolerance && maxPointDiff <= valTolerance) ||
           (nFuncCallCount >= maxFuncEvals) || (iterations == 0)) {
-          icFloatVector res = simplex[idxSmallest].vec();
-          return res;
+          result = simplex[idxSmallest];
+          return true;
         }
 
         // Calculate the centroid
         CIccSearchVec xCenter(nDimension);
-        for (unsigned int i = 0; i < nDimension; i++)
-          xCenter(i) = 0;
-        for (size_t i = 0; i < simplex.size(); i++) {
+        for (unsigned int i = 0; i < nSimplex; i++) {
           if (i != idxBiggest)
             xCenter += simplex[i];
         }
@@ -415,8 +455,8 @@ namespace iccDEV {
           valueCache[idxBiggest].second = valReflection;
         }
       }
-      icFloatVector res = simplex[idxSmallest].vec();
-      return res;
+      result = simplex[idxSmallest];
+      return true;
     }
 
     protected:
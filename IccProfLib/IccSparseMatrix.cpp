@@ -8,6 +8,7 @@ CIccSparseMatrix::CIccSparseMatrix(void *pMatrix, size_t nSize, icSparseMatrixTy
   m_nRawSize = nSize;
   m_nType = nType;
   m_Data = NULL;
+  m_pDecoded = NULL;
 
   if (bInitFromData) {
     icUInt16Number nRows = *((icUInt16Number*)pMatrix);
@@ -28,28 +29,11 @@ CIccSparseMatrix::CIccSparseMatrix(const CIccSparseMatrix &mtx)
   m_pMatrix = mtx.m_pMatrix;
   m_nRawSize = mtx.m_nRawSize;
   m_nType = mtx.m_nType;
+  m_Data = NULL;
+  m_pDecoded = NULL;
 
-  if (mtx.m_Data) {
-    switch (m_nType) {
-    case icSparseMatrixUInt8:
-      m_Data = new CIccSparseMatrixUInt8();
-      break;
-    case icSparseMatrixUInt16:
-      m_Data = new CIccSparseMatrixUInt16();
-      break;
-    case icSparseMatrixFloat16:
-      m_Data = new CIccSparseMatrixFloat16();
-      break;
-    case icSparseMatrixFloat32:
-      m_Data = new CIccSparseMatrixFloat32();
-      break;
-    case icSparseMatrixFloatNum:
-      m_Data = new CIccSparseMatrixFloatNum();
-      break;    // without this, we have a memory leak!
-    default:
-      m_Data = NULL;
-    }
-  }
+  if (mtx.m_Data)
+    NewEntries();
 
   if (m_Data) {
     Init(mtx.m_nRows, mtx.m_nCols);  
@@ -65,21 +49,42 @@ CIccSparseMatrix::CIccSparseMatrix(const CIccSparseMatrix &mtx)
 
 CIccSparseMatrix::~CIccSparseMatrix(void)
 {
-  if (m_Data)
-    delete m_Data;
+  FreeEntries();
+
+  FreeDecodedData();
 }
 
 CIccSparseMatrix &CIccSparseMatrix::operator=(const CIccSparseMatrix &mtx)
 {
+  FreeDecodedData();
+
   m_pMatrix = mtx.m_pMatrix;
   m_nRawSize = mtx.m_nRawSize;
   m_nType = mtx.m_nType;
 
-  if (mtx.m_Data) {
-    if (m_Data)
-      delete m_Data;
+  if (mtx.m_Data)
+    NewEntries();
 
-    switch (m_nType) {
+  if (m_Data) {
+    Init(mtx.m_nRows, mtx.m_nCols);  
+  }
+  else {
+    m_nRows = 0;
+    m_nCols = 0;
+    m_nMaxEntries = 0;
+  }
+
+  return *this;
+}
+
+//Sets m_Data to an entry accessor for m_nType.  Native icFloatNumber entries
+//use the embedded accessor so that matrix views can be made without a heap
+//allocation.
+bool CIccSparseMatrix::NewEntries()
+{
+  FreeEntries();
+
+  switch (m_nType) {
     case icSparseMatrixUInt8:
       m_Data = new CIccSparseMatrixUInt8();
       break;
@@ -93,34 +98,31 @@ CIccSparseMatrix &CIccSparseMatrix::operator=(const CIccSparseMatrix &mtx)
       m_Data = new CIccSparseMatrixFloat32();
       break;
     case icSparseMatrixFloatNum:
-      m_Data = new CIccSparseMatrixFloatNum();
-      break;    // without this, we have a memory leak!
+      m_Data = &m_FloatNumData;
+      break;
     default:
       m_Data = NULL;
-    }
   }
 
-  if (m_Data) {
-    Init(mtx.m_nRows, mtx.m_nCols);  
-  }
-  else {
-    m_nRows = 0;
-    m_nCols = 0;
-    m_nMaxEntries = 0;
-  }
+  return m_Data != NULL;
+}
 
-  return *this;
+void CIccSparseMatrix::FreeEntries()
+{
+  if (m_Data && m_Data != &m_FloatNumData)
+    delete m_Data;
+
+  m_Data = NULL;
 }
 
 void CIccSparseMatrix::Reset(void *pMatrix, size_t nSize, icSparseMatrixType nType, bool bInitFromData/*=true*/)
 {
-  if (m_Data)
-    delete m_Data;
+  FreeEntries();
+  FreeDecodedData();
 
   m_pMatrix = (unsigned char*)pMatrix;
   m_nRawSize = nSize;
   m_nType = nType;
-  m_Data = NULL;
 
   if (bInitFromData) {
     icUInt16Number nRows = *((icUInt16Number*)pMatrix);
@@ -144,37 +146,19 @@ bool CIccSparseMatrix::Init(icUInt16Number nRows, icUInt16Number nCols, bool bSe
 
   icUInt16Number *Dim = (icUInt16Number*)m_pMatrix;
 
-  if (m_Data)
-    delete m_Data;
+  FreeDecodedData();
 
-  switch (m_nType) {
-    case icSparseMatrixUInt8:
-      m_Data = new CIccSparseMatrixUInt8();
-      break;
-    case icSparseMatrixUInt16:
-      m_Data = new CIccSparseMatrixUInt16();
-      break;
-    case icSparseMatrixFloat16:
-      m_Data = new CIccSparseMatrixFloat16();
-      break;
-    case icSparseMatrixFloat32:
-      m_Data = new CIccSparseMatrixFloat32();
-      break;
-    case icSparseMatrixFloatNum:
-      m_Data = new CIccSparseMatrixFloatNum();
-      break;
-    default:
-      m_nRows = 0;
-      m_nCols = 0;
-      if (bSetData) {
-        Dim[0] = 0;
-        Dim[1] = 0;
-      }
-      m_Data = NULL;
-      m_RowStart = NULL;
-      m_ColumnIndices = NULL;
-      m_nMaxEntries = 0;
-      return false;
+  if (!NewEntries()) {
+    m_nRows = 0;
+    m_nCols = 0;
+    if (bSetData) {
+      Dim[0] = 0;
+      Dim[1] = 0;
+    }
+    m_RowStart = NULL;
+    m_ColumnIndices = NULL;
+    m_nMaxEntries = 0;
+    return false;
   }
   m_nRows = nRows;
   m_nCols = nCols;
@@ -193,7 +177,7 @@ bool CIccSparseMatrix::Init(icUInt16Number nRows, icUInt16Number nCols, bool bSe
       Dim[0] = 0;
       Dim[1] = 0;
     }
-    m_Data = NULL;
+    FreeEntries();
     m_RowStart = NULL;
     m_ColumnIndices = NULL;
     m_nMaxEntries = 0;
@@ -264,28 +248,134 @@ bool CIccSparseMatrix::FillFromFullMatrix(icFloatNumber *pData)
   return true;
 }
 
+//Entry decoders used to specialize the multiply kernel by entry type
+struct CIccSparseDecodeUInt8 {
+  static icFloatNumber get(icUInt8Number v) { return (icFloatNumber)v/255.0f; }
+};
+
+struct CIccSparseDecodeUInt16 {
+  static icFloatNumber get(icUInt16Number v) { return (icFloatNumber)v/65535.0f; }
+};
+
+struct CIccSparseDecodeFloat16 {
+  static icFloatNumber get(icFloat16Number v) { return icF16toF(v); }
+};
+
+struct CIccSparseDecodeFloat32 {
+  static icFloatNumber get(icFloat32Number v) { return (icFloatNumber)v; }
+};
+
+struct CIccSparseDecodeFloatNum {
+  static icFloatNumber get(icFloatNumber v) { return v; }
+};
+
+/**
+ * Row compressed sparse matrix times vector kernel.  Each of the nVectors
+ * source vectors has nCols entries and each result vector has nRows entries.
+ */
+template <class T, class D>
+static void icSparseMultiply(icFloatNumber *pResult, const icFloatNumber *pVector, icUInt32Number nVectors,
+                             const T *pData, const icUInt16Number *pRowStart, const icUInt16Number *pColumns,
+                             icUInt16Number nRows, icUInt16Number nCols)
+{
+  icUInt32Number n, e, le;
+  int r;
+
+  for (n=0; n<nVectors; n++, pResult+=nRows, pVector+=nCols) {
+    for (r=0, e=0; r<(int)nRows; r++) {
+      icFloatNumber v=0.0f;
+
+      le = pRowStart[r+1];
+
+      for (; e<le; e++) {
+        v += D::get(pData[e])*pVector[pColumns[e]];
+      }
+      pResult[r]=v;
+    }
+  }
+}
+
 bool CIccSparseMatrix::MultiplyVector(icFloatNumber *pResult, const icFloatNumber *pVector) const
+{
+  return MultiplyVectors(pResult, pVector, 1);
+}
+
+bool CIccSparseMatrix::MultiplyVectors(icFloatNumber *pResult, const icFloatNumber *pVectors, icUInt32Number nVectors) const
 {
   if (!m_Data)
     return false;
 
-  int r;
-  icUInt32Number e, le;
-  icUInt16Number *ci=m_ColumnIndices;
+  if (m_pDecoded) {
+    icSparseMultiply<icFloatNumber, CIccSparseDecodeFloatNum>(pResult, pVectors, nVectors, m_pDecoded,
+                                                            m_RowStart, m_ColumnIndices, m_nRows, m_nCols);
+    return true;
+  }
 
-  for (r=0, e=0; r<(int)m_nRows; r++) {
-    icFloatNumber v=0.0f;
+  void *pData = m_Data->getPtr(0);
 
-    le = m_RowStart[r+1];
+  switch (m_nType) {
+    case icSparseMatrixUInt8:
+      icSparseMultiply<icUInt8Number, CIccSparseDecodeUInt8>(pResult, pVectors, nVectors, (icUInt8Number*)pData,
+                                                             m_RowStart, m_ColumnIndices, m_nRows, m_nCols);
+      break;
+    case icSparseMatrixUInt16:
+      icSparseMultiply<icUInt16Number, CIccSparseDecodeUInt16>(pResult, pVectors, nVectors, (icUInt16Number*)pData,
+                                                               m_RowStart, m_ColumnIndices, m_nRows, m_nCols);
+      break;
+    case icSparseMatrixFloat16:
+      icSparseMultiply<icFloat16Number, CIccSparseDecodeFloat16>(pResult, pVectors, nVectors, (icFloat16Number*)pData,
+                                                                 m_RowStart, m_ColumnIndices, m_nRows, m_nCols);
+      break;
+    case icSparseMatrixFloat32:
+      icSparseMultiply<icFloat32Number, CIccSparseDecodeFloat32>(pResult, pVectors, nVectors, (icFloat32Number*)pData,
+                                                                 m_RowStart, m_ColumnIndices, m_nRows, m_nCols);
+      break;
+    case icSparseMatrixFloatNum:
+      icSparseMultiply<icFloatNumber, CIccSparseDecodeFloatNum>(pResult, pVectors, nVectors, (icFloatNumber*)pData,
+                                                                m_RowStart, m_ColumnIndices, m_nRows, m_nCols);
+      break;
+    default:
+      return false;
+  }
 
-    for (; e<le; e++, ci++) {
-      v += m_Data->get(e)*pVector[*ci];
-    }
-    pResult[r]=v;
+  return true;
+}
+
+bool CIccSparseMatrix::DecodeData()
+{
+  if (!m_Data || !m_RowStart)
+    return false;
+
+  FreeDecodedData();
+
+  //Native icFloatNumber entries are multiplied in place
+  if (m_nType==icSparseMatrixFloatNum)
+    return true;
+
+  icUInt32Number nEntries = m_RowStart[m_nRows];
+  if (nEntries > m_nMaxEntries)
+    return false;
+
+  m_pDecoded = new icFloatNumber[nEntries ? nEntries : 1];
+  if (!m_pDecoded)
+    return false;
+
+  icUInt32Number i;
+  for (i=0; i<nEntries; i++) {
+    m_pDecoded[i] = m_Data->get(i);
   }
+
   return true;
 }
 
+void CIccSparseMatrix::FreeDecodedData()
+{
+  if (m_pDecoded) {
+    delete [] m_pDecoded;
+    m_pDecoded = NULL;
+  }
+}
+
 
 bool CIccSparseMatrix::Interp(icFloatNumber d1, const CIccSparseMatrix &mtx1, icFloatNumber d2, const CIccSparseMatrix &mtx2)
 {
@@ -115,7 +115,7 @@ public:
   CIccSparseMatrixUInt16() {}
 
   virtual icFloatNumber get(int index) const {return (icFloatNumber)m_pData[index]/65535.0f;}
-  virtual void set(int index, icFloatNumber value) {m_pData[index] = value<0.0 ? 0 : (value > 1.0 ? 65535 : (icUInt8Number)(value*65535.0f+0.5f));}
+  virtual void set(int index, icFloatNumber value) {m_pData[index] = value<0.0 ? 0 : (value > 1.0 ? 65535 : (icUInt16Number)(value*65535.0f+0.5f));}
 
 };
 
@@ -166,6 +166,13 @@ public:
   bool FillFromFullMatrix(icFloatNumber *pData);
 
   bool MultiplyVector(icFloatNumber *pResult, const icFloatNumber *pVector) const;
+  bool MultiplyVectors(icFloatNumber *pResult, const icFloatNumber *pVectors, icUInt32Number nVectors) const;
+
+  //Decoded float entries are a snapshot used by Multiply functions until Init(), Reset() or FreeDecodedData()
+  //icSparseMatrixFloatNum entries need no decoding and are always used in place
+  bool DecodeData();
+  void FreeDecodedData();
+  bool HasDecodedData() const { return m_pDecoded != NULL || (m_Data && m_nType==icSparseMatrixFloatNum); }
   bool Interp(icFloatNumber d1, const CIccSparseMatrix &mtx1, icFloatNumber d2, const  CIccSparseMatrix &mtx2);
   bool Union(const CIccSparseMatrix &mtx1, const CIccSparseMatrix &mtx2);
 
@@ -188,6 +195,9 @@ public:
   static icUInt8Number EntrySize(icSparseMatrixType nType);
 
 protected:
+  bool NewEntries();
+  void FreeEntries();
+
   icUInt8Number *m_pMatrix;
   icUInt64Number m_nRawSize;
   icSparseMatrixType m_nType;
@@ -199,8 +209,11 @@ protected:
   icUInt16Number *m_ColumnIndices;
 
   IIccSparseMatrixEntry *m_Data;
+  CIccSparseMatrixFloatNum m_FloatNumData;
 
   icUInt32Number m_nMaxEntries;
+
+  icFloatNumber *m_pDecoded;
 };
 
 
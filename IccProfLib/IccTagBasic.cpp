@@ -76,6 +76,7 @@
 #include <math.h>
 #include <string.h>
 #include <stdlib.h>
+#include <ctype.h>
 #include "IccTag.h"
 #include "IccUtil.h"
 #include "IccProfile.h"
@@ -2731,6 +2732,10 @@ CIccTagNamedColor2::CIccTagNamedColor2(int nSize/*=1*/, int nDeviceCoords/*=0*/)
   m_NamedColor = (SIccNamedColorEntry*)calloc(nSize, m_nColorEntrySize);
 
   m_NamedLab = NULL;
+  m_pNameIndex = NULL;
+  m_pRootIndex = NULL;
+  m_pPcsIndex = NULL;
+  m_pDeviceIndex = NULL;
 }
 
 
@@ -2761,6 +2766,10 @@ CIccTagNamedColor2::CIccTagNamedColor2(const CIccTagNamedColor2 &ITNC)
   memcpy(m_NamedColor, ITNC.m_NamedColor, m_nColorEntrySize*m_nSize);
 
   m_NamedLab = NULL;
+  m_pNameIndex = NULL;
+  m_pRootIndex = NULL;
+  m_pPcsIndex = NULL;
+  m_pDeviceIndex = NULL;
 }
 
 
@@ -2795,7 +2804,7 @@ CIccTagNamedColor2 &CIccTagNamedColor2::operator=(const CIccTagNamedColor2 &Name
   m_NamedColor = (SIccNamedColorEntry*)calloc(m_nSize, m_nColorEntrySize);
   memcpy(m_NamedColor, NamedColor2Tag.m_NamedColor, m_nColorEntrySize*m_nSize);
 
-  m_NamedLab = NULL;
+  ResetPCSCache();
 
   return *this;
 }
@@ -2814,8 +2823,7 @@ CIccTagNamedColor2::~CIccTagNamedColor2()
   if (m_NamedColor)
     free(m_NamedColor);
 
-  if (m_NamedLab)
-    delete [] m_NamedLab;
+  ResetPCSCache();
 }
 
 /**
@@ -3123,6 +3131,26 @@ void CIccTagNamedColor2::SetColorSpaces(icColorSpaceSignature csPCS, icColorSpac
    m_csDevice = csDevice;
 }
 
+//Root names fill a fixed 32 byte field that need not be zero terminated
+static std::string icNamedColorRoot(const SIccNamedColorEntry *pEntry)
+{
+  size_t n;
+
+  for (n=0; n<sizeof(pEntry->rootName) && pEntry->rootName[n]; n++);
+
+  return std::string(pEntry->rootName, n);
+}
+
+static std::string icNamedColorLower(const icChar *szName)
+{
+  std::string rv(szName);
+
+  for (size_t i=0; i<rv.size(); i++)
+    rv[i] = (icChar)tolower((unsigned char)rv[i]);
+
+  return rv;
+}
+
 /**
  ****************************************************************************
  * Name: CIccTagNamedColor2::FindRootColor
@@ -3138,8 +3166,14 @@ void CIccTagNamedColor2::SetColorSpaces(icColorSpaceSignature csPCS, icColorSpac
  */
 icInt32Number CIccTagNamedColor2::FindRootColor(const icChar *szRootColor) const
 {
+  if (m_pRootIndex) {
+    IccNamedColorIndex::const_iterator i = m_pRootIndex->find(icNamedColorLower(szRootColor));
+
+    return i!=m_pRootIndex->end() ? i->second : -1;
+  }
+
   for (icUInt32Number i=0; i<m_nSize; i++) {
-    if (stricmp(m_NamedColor[i].rootName,szRootColor) == 0)
+    if (stricmp(icNamedColorRoot(GetEntry(i)).c_str(),szRootColor) == 0)
       return i;
   }
 
@@ -3161,6 +3195,26 @@ void CIccTagNamedColor2::ResetPCSCache()
     delete [] m_NamedLab;
     m_NamedLab = NULL;
   }
+
+  if (m_pNameIndex) {
+    delete m_pNameIndex;
+    m_pNameIndex = NULL;
+  }
+
+  if (m_pRootIndex) {
+    delete m_pRootIndex;
+    m_pRootIndex = NULL;
+  }
+
+  if (m_pPcsIndex) {
+    delete m_pPcsIndex;
+    m_pPcsIndex = NULL;
+  }
+
+  if (m_pDeviceIndex) {
+    delete m_pDeviceIndex;
+    m_pDeviceIndex = NULL;
+  }
 }
 
 /**
@@ -3175,17 +3229,18 @@ void CIccTagNamedColor2::ResetPCSCache()
 */
 bool CIccTagNamedColor2::InitFindCachedPCSColor()
 {
-  icFloatNumber *pXYZ, *pLab;
+  icFloatNumber pXYZ[3], *pLab;
 
   if (!m_NamedLab) {
     m_NamedLab = new SIccNamedLabEntry[m_nSize];
     if (!m_NamedLab)
       return false;
 
+    //Entries are m_nColorEntrySize apart and must not be modified here
     if (m_csPCS != icSigLabData) {
       for (icUInt32Number i=0; i<m_nSize; i++) {
         pLab = m_NamedLab[i].lab;
-        pXYZ = m_NamedColor[i].pcsCoords;
+        memcpy(pXYZ, GetEntry(i)->pcsCoords, sizeof(pXYZ));
         icXyzFromPcs(pXYZ);
         icXYZtoLab(pLab, pXYZ);
       }
@@ -3193,12 +3248,48 @@ bool CIccTagNamedColor2::InitFindCachedPCSColor()
     else {
       for (icUInt32Number i=0; i<m_nSize; i++) {
         pLab = m_NamedLab[i].lab;
-        Lab2ToLab4(pLab, m_NamedColor[i].pcsCoords);
+        Lab2ToLab4(pLab, GetEntry(i)->pcsCoords);
         icLabFromPcs(pLab);
       }
     }
   }
 
+  if (!m_pNameIndex) {
+    m_pNameIndex = new IccNamedColorIndex;
+    m_pRootIndex = new IccNamedColorIndex;
+
+    m_pNameIndex->reserve(m_nSize);
+    m_pRootIndex->reserve(m_nSize);
+
+    //emplace keeps the first entry when names are repeated
+    for (icUInt32Number i=0; i<m_nSize; i++) {
+      std::string sRoot = icNamedColorRoot(GetEntry(i));
+
+      m_pRootIndex->emplace(icNamedColorLower(sRoot.c_str()), (icInt32Number)i);
+      m_pNameIndex->emplace(sRoot, (icInt32Number)i);
+    }
+  }
+
+  if (!m_pPcsIndex) {
+    m_pPcsIndex = new CIccNearestIndex;
+    if (!m_pPcsIndex->Build(m_NamedLab[0].lab, m_nSize, 3))
+      return false;
+  }
+
+  if (!m_pDeviceIndex && m_nDeviceCoords) {
+    icFloatNumber *pDev = new icFloatNumber[(size_t)m_nSize*m_nDeviceCoords];
+
+    for (icUInt32Number i=0; i<m_nSize; i++)
+      memcpy(pDev + (size_t)i*m_nDeviceCoords, GetEntry(i)->deviceCoords, m_nDeviceCoords*sizeof(icFloatNumber));
+
+    m_pDeviceIndex = new CIccNearestIndex;
+    bool bOk = m_pDeviceIndex->Build(pDev, m_nSize, m_nDeviceCoords);
+    delete [] pDev;
+
+    if (!bOk)
+      return false;
+  }
+
   return true;
 }
 
@@ -3235,6 +3326,13 @@ icInt32Number CIccTagNamedColor2::FindCachedPCSColor(icFloatNumber *pPCS, icFloa
   if (!m_NamedLab)
     return -1;
 
+  //Nearest entry if within dMinDE, otherwise the first entry
+  if (m_pPcsIndex && m_pPcsIndex->GetSize()==m_nSize) {
+    icInt32Number nearest = m_pPcsIndex->FindNearest(pLabIn, &dCalcDE);
+
+    return (nearest>=0 && dCalcDE<dMinDE) ? nearest : (m_nSize ? 0 : -1);
+  }
+
   for (icUInt32Number i=0; i<m_nSize; i++) {
     pLab = m_NamedLab[i].lab;
 
@@ -3293,29 +3391,33 @@ icInt32Number CIccTagNamedColor2::FindPCSColor(icFloatNumber *pPCS, icFloatNumbe
  */
 icInt32Number CIccTagNamedColor2::FindColor(const icChar *szColor) const
 {
-  std::string sColorName;
-  icInt32Number i, j;
+  size_t nPrefix = strlen(m_szPrefix);
+  size_t nSufix = strlen(m_szSufix);
+  size_t nColor = strlen(szColor);
+
+  if (nColor < nPrefix + nSufix)
+    return -1;
 
-  j = (icInt32Number)strlen(m_szPrefix);
-  if (j != 0) {  
-    if (strncmp(szColor, m_szPrefix, j))
+  if (nPrefix != 0) {
+    if (strncmp(szColor, m_szPrefix, nPrefix))
       return -1;
   }
 
-  j = (icInt32Number)strlen(m_szSufix);
-  i = (icInt32Number)strlen(szColor);
-  if (j != 0) {
-    if (strncmp(szColor+(i-j), m_szSufix, j))
+  if (nSufix != 0) {
+    if (strncmp(szColor+(nColor-nSufix), m_szSufix, nSufix))
       return -1;    
   }
 
+  std::string sRoot(szColor+nPrefix, nColor-nPrefix-nSufix);
 
-  for ( i=0; i<(icInt32Number)m_nSize; i++) {
-    sColorName = m_szPrefix;
-    sColorName += m_NamedColor[i].rootName;
-    sColorName += m_szSufix;
+  if (m_pNameIndex) {
+    IccNamedColorIndex::const_iterator i = m_pNameIndex->find(sRoot);
 
-    if (strcmp(sColorName.c_str(),szColor) == 0)
+    return i!=m_pNameIndex->end() ? i->second : -1;
+  }
+
+  for (icUInt32Number i=0; i<m_nSize; i++) {
+    if (icNamedColorRoot(GetEntry(i)) == sRoot)
       return i;
   }
 
@@ -3340,13 +3442,16 @@ icInt32Number CIccTagNamedColor2::FindDeviceColor(icFloatNumber *pDevColor) cons
   if (!m_nDeviceCoords)
     return -1;
   
+  if (m_pDeviceIndex)
+    return m_pDeviceIndex->FindNearest(pDevColor);
+
   icFloatNumber dCalcDiff=0.0, dLeastDiff=0.0;
   icFloatNumber *pDevOut;
   icInt32Number leastDiffindex = -1;
 
 
   for (icUInt32Number i=0; i<m_nSize; i++) {
-    pDevOut = m_NamedColor[i].deviceCoords;
+    pDevOut = GetEntry(i)->deviceCoords;
 
     for (icUInt32Number j=0; j<m_nDeviceCoords; j++) {
       dCalcDiff += (pDevColor[j]-pDevOut[j])*(pDevColor[j]-pDevOut[j]);
@@ -5480,12 +5585,12 @@ bool CIccTagFixedNum<T, Tsig>::GetValues(icFloatNumber *DstVector, icUInt32Numbe
 
   switch (Tsig) {
     case icSigS15Fixed16ArrayType:
-      for (i=0; i<m_nSize; i++) {
+      for (i=0; i<nVectorSize; i++) {
         DstVector[i] = (icFloatNumber)icFtoD(m_Num[i+nStart]);
       }
       break;
     case icSigU16Fixed16ArrayType:
-      for (i=0; i<m_nSize; i++) {
+      for (i=0; i<nVectorSize; i++) {
         DstVector[i] = (icFloatNumber)icUFtoD(m_Num[i+nStart]);
       }
       break;
@@ -6043,12 +6148,12 @@ bool CIccTagNum<T, Tsig>::GetValues(icFloatNumber *DstVector, icUInt32Number nSt
   
   switch (Tsig) {
     case icSigUInt8ArrayType:
-      for (i=0; i<m_nSize; i++) {
+      for (i=0; i<nVectorSize; i++) {
         DstVector[i] = icU8toF((icUInt8Number)(m_Num[i+nStart]));
       }
       break;
     case icSigUInt16ArrayType:
-      for (i=0; i<m_nSize; i++) {
+      for (i=0; i<nVectorSize; i++) {
         DstVector[i] = icU16toF((icUInt16Number)(m_Num[i+nStart]));
       }
       break;
@@ -6608,12 +6713,12 @@ bool  CIccTagFloatNum<T, Tsig>::SetSize(icUInt32Number nSize, bool bZeroNew/*=tr
 template <class T, icTagTypeSignature Tsig>
 bool CIccTagFloatNum<T, Tsig>::GetValues(icFloatNumber *DstVector, icUInt32Number nStart, icUInt32Number nVectorSize) const
 {
-  if (nVectorSize >m_nSize)
+  if (nVectorSize+nStart >m_nSize)
     return false;
 
   icUInt32Number i;
 
-  for (i=0; i<m_nSize; i++) {
+  for (i=0; i<nVectorSize; i++) {
     DstVector[i] = (icFloatNumber)m_Num[i+nStart];
   }
   return true;
@@ -7037,8 +7142,9 @@ icValidateStatus CIccTagMeasurement::Validate(std::string sigPath, std::string &
  */
 CIccLocalizedUnicode::CIccLocalizedUnicode()
 {
-  m_pBuf = (icUInt16Number*)malloc(1*sizeof(icUInt16Number));
-  *m_pBuf = 0;
+  m_pBuf = (icUInt16Number*)CIccMemArena::AllocBuffer(2*sizeof(icUInt16Number));
+  m_pBuf[0] = 0;
+  m_pBuf[1] = 0;
   m_nLength = 0;
 }
 
@@ -7056,7 +7162,7 @@ CIccLocalizedUnicode::CIccLocalizedUnicode()
 CIccLocalizedUnicode::CIccLocalizedUnicode(const CIccLocalizedUnicode& ILU)
 {
   m_nLength = ILU.GetLength();
-  m_pBuf = (icUInt16Number*)malloc((m_nLength+2) * sizeof(icUInt16Number));
+  m_pBuf = (icUInt16Number*)CIccMemArena::AllocBuffer((m_nLength+2) * sizeof(icUInt16Number));
   if (m_nLength)
     memcpy(m_pBuf, ILU.GetBuf(), m_nLength*sizeof(icUInt16Number));
   m_pBuf[m_nLength] = 0;    // safety against malformed unicode
@@ -7102,7 +7208,7 @@ CIccLocalizedUnicode &CIccLocalizedUnicode::operator=(const CIccLocalizedUnicode
 CIccLocalizedUnicode::~CIccLocalizedUnicode()
 {
   if (m_pBuf)
-    free(m_pBuf);
+    CIccMemArena::FreeObject(m_pBuf);
 }
 
 /**
@@ -7233,12 +7339,15 @@ bool CIccLocalizedUnicode::SetSize(icUInt32Number nSize)
   if (nSize == m_nLength)
     return true;
 
-  m_pBuf = (icUInt16Number*)icRealloc(m_pBuf, (nSize+2)*sizeof(icUInt16Number));
+  icUInt16Number *pBuf = (icUInt16Number*)CIccMemArena::ReallocBuffer(m_pBuf, (nSize+2)*sizeof(icUInt16Number));
 
-  if (!m_pBuf) {
+  if (!pBuf) {
+    CIccMemArena::FreeObject(m_pBuf);
+    m_pBuf = NULL;
     m_nLength = 0;
     return false;
   }
+  m_pBuf = pBuf;
 
   m_nLength = nSize;
 
@@ -10927,6 +11036,7 @@ CIccTagSpectralViewingConditions::CIccTagSpectralViewingConditions()
   m_observerRange.start = 0;
   m_observerRange.end = 0;
   m_observerRange.steps = 0;
+  m_reserved2 = 0;
   m_observer = NULL;
 
   m_stdIlluminant = icIlluminantD50;
@@ -10935,6 +11045,7 @@ CIccTagSpectralViewingConditions::CIccTagSpectralViewingConditions()
   m_illuminantRange.start = 0;
   m_illuminantRange.end = 0;
   m_illuminantRange.steps = 0;
+  m_reserved3 = 0;
 
   m_illuminant = 0;
 
@@ -10962,6 +11073,7 @@ CIccTagSpectralViewingConditions::CIccTagSpectralViewingConditions(const CIccTag
 {
   m_stdObserver = SVCT.m_stdObserver;
   m_observerRange = SVCT.m_observerRange;
+  m_reserved2 = SVCT.m_reserved2;
 
   if (SVCT.m_observer && SVCT.m_observerRange.steps) {
     m_observer = new icFloat32Number[SVCT.m_observerRange.steps*3];
@@ -10989,6 +11101,7 @@ CIccTagSpectralViewingConditions::CIccTagSpectralViewingConditions(const CIccTag
   m_illuminantXYZ = SVCT.m_illuminantXYZ;
   m_surroundXYZ = SVCT.m_surroundXYZ;
   m_illuminantRange = SVCT.m_illuminantRange;
+  m_reserved3 = SVCT.m_reserved3;
 }
 
 
@@ -11006,6 +11119,7 @@ CIccTagSpectralViewingConditions &CIccTagSpectralViewingConditions::operator=(co
 {
   m_stdObserver = SVCT.m_stdObserver;
   m_observerRange = SVCT.m_observerRange;
+  m_reserved2 = SVCT.m_reserved2;
 
   if (SVCT.m_observer && SVCT.m_observerRange.steps) {
     m_observer = new icFloat32Number[SVCT.m_observerRange.steps*3];
@@ -11033,6 +11147,7 @@ CIccTagSpectralViewingConditions &CIccTagSpectralViewingConditions::operator=(co
   m_illuminantXYZ = SVCT.m_illuminantXYZ;
   m_surroundXYZ = SVCT.m_surroundXYZ;
   m_illuminantRange = SVCT.m_illuminantRange;
+  m_reserved3 = SVCT.m_reserved3;
 
   return *this;
 }
@@ -11385,6 +11500,9 @@ icFloatNumber *CIccTagSpectralViewingConditions::applyRangeToObserver(const icSp
   int n = newRange.steps*3;
   icFloatNumber *rv = (icFloatNumber*)malloc(n*sizeof(icFloatNumber));
 
+  if (m_observer && CIccSpectralObserverCache::GetGlobal()->GetObserver(rv, m_observer, m_observerRange, newRange))
+    return rv;
+
   CIccMatrixMath *range = CIccMatrixMath::rangeMap(m_observerRange, newRange);
   if (range) {
     range->VectorMult(rv, m_observer);
@@ -11403,6 +11521,9 @@ CIccMatrixMath *CIccTagSpectralViewingConditions::getObserverMatrix(const icSpec
 {
   CIccMatrixMath *pMtx=new CIccMatrixMath(3, newRange.steps);
 
+  if (m_observer && CIccSpectralObserverCache::GetGlobal()->GetObserver(pMtx->entry(0), m_observer, m_observerRange, newRange))
+    return pMtx;
+
   CIccMatrixMath *range = CIccPcsXform::rangeMap(m_observerRange, newRange);
   if (range) {
     range->VectorMult(pMtx->entry(0), m_observer);
@@ -11692,6 +11813,37 @@ bool CIccTagSpectralViewingConditions::setObserver(icStandardObserver observerId
 }
 
 
+/**
+****************************************************************************
+* Name: CIccTagSpectralViewingConditions::getConditionsKey
+* 
+* Purpose: Builds a key from the observer, illuminant and colorimetry of the
+*  viewing conditions.  Viewing conditions with equal keys give the same
+*  results for calculations based on their observer and illuminant.
+*****************************************************************************
+*/
+void CIccTagSpectralViewingConditions::getConditionsKey(std::string &key) const
+{
+  icSpectralRange observerRange, illumRange;
+  const icFloatNumber *observer = getObserver(observerRange);
+  const icFloatNumber *illum = getIlluminant(illumRange);
+
+  key.assign((const char*)&m_stdObserver, sizeof(m_stdObserver));
+  key.append((const char*)&observerRange, sizeof(observerRange));
+  if (observer)
+    key.append((const char*)observer, (size_t)observerRange.steps*3*sizeof(icFloatNumber));
+
+  key.append((const char*)&m_stdIlluminant, sizeof(m_stdIlluminant));
+  key.append((const char*)&m_colorTemperature, sizeof(m_colorTemperature));
+  key.append((const char*)&illumRange, sizeof(illumRange));
+  if (illum)
+    key.append((const char*)illum, (size_t)illumRange.steps*sizeof(icFloatNumber));
+
+  key.append((const char*)&m_illuminantXYZ, sizeof(m_illuminantXYZ));
+  key.append((const char*)&m_surroundXYZ, sizeof(m_surroundXYZ));
+}
+
+
 bool icGetTagText(const CIccTag *pTag, std::string &text)
 {
   if (!pTag) {
@@ -70,7 +70,9 @@
 
 #include <list>
 #include <string>
+#include <unordered_map>
 #include "IccDefs.h"
+#include "IccUtil.h"
 
 #ifdef USEICCDEVNAMESPACE
 namespace iccDEV {
@@ -118,6 +120,10 @@ public:
 
   virtual ~CIccTag();
 
+  /** Tag storage comes from the parsing arena when one is current (see CIccMemArena) */
+  static void *operator new(size_t nSize) { return CIccMemArena::AllocObject(nSize); }
+  static void operator delete(void *pTag) { CIccMemArena::FreeObject(pTag); }
+
   /**
   * Function: GetType() 
   * 
@@ -567,6 +573,9 @@ typedef struct {
   icFloatNumber lab[3];
 } SIccNamedLabEntry;
 
+/** Maps a named color root name to the index of its first entry */
+typedef std::unordered_map<std::string, icInt32Number> IccNamedColorIndex;
+
 /**
 ****************************************************************************
 * Class: CIccTagNamedColor2
@@ -609,6 +618,8 @@ public:
   icInt32Number FindDeviceColor(icFloatNumber *pDevColor) const;
   icInt32Number FindPCSColor(icFloatNumber *pPCS, icFloatNumber dMinDE=1000.0);
 
+  //Also builds the name indexes used by FindColor() and FindRootColor() and
+  //the nearest neighbour indexes used by FindCachedPCSColor() and FindDeviceColor()
   bool InitFindCachedPCSColor();
   //FindPCSColor returns the zero based index of the color or -1 to indicate that the color was not found.
   //InitFindPCSColor must be called before FindPCSColor
@@ -643,6 +654,10 @@ protected:
   
   SIccNamedColorEntry *m_NamedColor;
   SIccNamedLabEntry *m_NamedLab; ///For quick response of repeated FindPCSColor
+  IccNamedColorIndex *m_pNameIndex; ///Root names for FindColor
+  IccNamedColorIndex *m_pRootIndex; ///Lower case root names for FindRootColor
+  CIccNearestIndex *m_pPcsIndex; ///Lab values for FindCachedPCSColor
+  CIccNearestIndex *m_pDeviceIndex; ///Device values for FindDeviceColor
   icUInt32Number m_nColorEntrySize;
 
   icUInt32Number m_nVendorFlags;
@@ -1719,6 +1734,9 @@ public:
   bool isStandardPcc() const {
     return m_stdObserver == icStdObs1931TwoDegrees || m_stdIlluminant == icIlluminantD50;
   }
+
+  //Key that is equal for viewing conditions with the same observer, illuminant and colorimetry
+  void getConditionsKey(std::string &key) const;
     
   icFloatXYZNumber m_illuminantXYZ;
   icFloatXYZNumber m_surroundXYZ;
@@ -97,6 +97,10 @@ public: //member functions
   CIccDictEntry &operator=(const CIccDictEntry &IDE);
   virtual ~CIccDictEntry();
 
+  /** Entry storage comes from the parsing arena when one is current (see CIccMemArena) */
+  static void *operator new(size_t nSize) { return CIccMemArena::AllocObject(nSize); }
+  static void operator delete(void *pEntry) { CIccMemArena::FreeObject(pEntry); }
+
   void Describe(std::string &sDescription, int nVerboseness);
 
   icUInt32Number PosRecSize();
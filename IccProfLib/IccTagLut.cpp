@@ -78,11 +78,17 @@
 #include <math.h>
 #include <string.h>
 #include <stdlib.h>
+#include <atomic>
+#include <new>
 #include "IccTag.h"
 #include "IccUtil.h"
 #include "IccProfile.h"
 #include "IccMpeBasic.h"
 
+#if defined(__AVX__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
 #ifdef USEICCDEVNAMESPACE
 namespace iccDEV {
 #endif
@@ -1688,6 +1694,50 @@ bool CIccApplyCLUT::Init(icUInt8Number nSrcChannels, icUInt32Number nNodes)
   return true;
 }
 
+//CLUT grid data is kept in a reference counted block so that copies of a
+//CLUT (and of the tags and profiles holding it) share the grid until one of
+//them is modified.  The count lives in a header just before the data.
+#define ICC_CLUT_DATA_HDR 16
+typedef std::atomic<icUInt32Number> icClutDataRefs;
+
+static icClutDataRefs *icClutDataGetRefs(const icFloatNumber *pData)
+{
+  return (icClutDataRefs*)((unsigned char*)pData - ICC_CLUT_DATA_HDR);
+}
+
+static icFloatNumber *icClutDataAlloc(icUInt32Number nNum)
+{
+  unsigned char *pMem = (unsigned char*)malloc(ICC_CLUT_DATA_HDR + (size_t)nNum*sizeof(icFloatNumber));
+
+  if (!pMem)
+    return NULL;
+
+  new (pMem) icClutDataRefs(1);
+
+  return (icFloatNumber*)(pMem + ICC_CLUT_DATA_HDR);
+}
+
+static icFloatNumber *icClutDataShare(icFloatNumber *pData)
+{
+  if (pData)
+    icClutDataGetRefs(pData)->fetch_add(1);
+
+  return pData;
+}
+
+static void icClutDataFree(icFloatNumber *pData)
+{
+  if (!pData)
+    return;
+
+  icClutDataRefs *pRefs = icClutDataGetRefs(pData);
+
+  if (pRefs->fetch_sub(1)==1) {
+    pRefs->~icClutDataRefs();
+    free(pRefs);
+  }
+}
+
 /**
  ****************************************************************************
  * Name: CIccCLUT::CIccCLUT
@@ -1746,9 +1796,7 @@ CIccCLUT::CIccCLUT(const CIccCLUT &ICLUT)
   memcpy(m_GridAdr, ICLUT.m_GridAdr, sizeof(m_GridAdr));
   memcpy(&m_nReserved2, &ICLUT.m_nReserved2, sizeof(m_nReserved2));
 
-  int num = NumPoints()*m_nOutput;
-  m_pData = new icFloatNumber[num];
-  memcpy(m_pData, ICLUT.m_pData, num*sizeof(icFloatNumber));
+  m_pData = icClutDataShare(ICLUT.m_pData);
 
   UnitClip = ICLUT.UnitClip;
 }
@@ -1782,12 +1830,9 @@ CIccCLUT &CIccCLUT::operator=(const CIccCLUT &CLUTTag)
   memcpy(m_GridAdr, CLUTTag.m_GridAdr, sizeof(m_GridAdr));
   memcpy(m_nReserved2, &CLUTTag.m_nReserved2, sizeof(m_nReserved2));
 
-  int num;
-  if (m_pData)
-    delete [] m_pData;
-  num = NumPoints()*m_nOutput;
-  m_pData = new icFloatNumber[num];
-  memcpy(m_pData, CLUTTag.m_pData, num*sizeof(icFloatNumber));
+  icFloatNumber *pData = icClutDataShare(CLUTTag.m_pData);
+  icClutDataFree(m_pData);
+  m_pData = pData;
 
   UnitClip = CLUTTag.UnitClip;
 
@@ -1806,8 +1851,7 @@ CIccCLUT &CIccCLUT::operator=(const CIccCLUT &CLUTTag)
  */
 CIccCLUT::~CIccCLUT()
 {
-  if (m_pData)
-    delete [] m_pData;
+  icClutDataFree(m_pData);
 
   if (m_nOffset)
     delete [] m_nOffset;
@@ -1870,10 +1914,8 @@ bool CIccCLUT::Init(const icUInt8Number *pGridPoints, icUInt32Number nMaxSize, i
       return false;
   }
 
-  if (m_pData) {
-    delete [] m_pData;
-    m_pData = NULL;
-  }
+  icClutDataFree(m_pData);
+  m_pData = NULL;
 
   int i = m_nInput-1;
 
@@ -1899,12 +1941,56 @@ bool CIccCLUT::Init(const icUInt8Number *pGridPoints, icUInt32Number nMaxSize, i
   if (!nSize)
     return false;
 
-  m_pData = new icFloatNumber[nSize];
+  m_pData = icClutDataAlloc(nSize);
 
   return (m_pData != NULL);
 }
 
 
+/**
+ ****************************************************************************
+ * Name: CIccCLUT::IsDataShared
+ * 
+ * Purpose: Indicates whether the grid data is shared with a copy of this CLUT
+ *****************************************************************************
+ */
+bool CIccCLUT::IsDataShared() const
+{
+  return m_pData && icClutDataGetRefs(m_pData)->load() > 1;
+}
+
+
+/**
+ ****************************************************************************
+ * Name: CIccCLUT::MakeDataUnique
+ * 
+ * Purpose: Gives this CLUT its own copy of shared grid data before the
+ *  data is modified.
+ *
+ * Return:
+ *  true = grid data is not shared (or there is no data),
+ *  false = unable to allocate a copy of the shared data
+ *****************************************************************************
+ */
+bool CIccCLUT::MakeDataUnique()
+{
+  if (!IsDataShared())
+    return true;
+
+  icUInt32Number nNum = NumPoints()*m_nOutput;
+  icFloatNumber *pData = icClutDataAlloc(nNum);
+
+  if (!pData)
+    return false;
+
+  memcpy(pData, m_pData, nNum*sizeof(icFloatNumber));
+  icClutDataFree(m_pData);
+  m_pData = pData;
+
+  return true;
+}
+
+
 /**
  ****************************************************************************
  * Name: CIccCLUT::ReadData
@@ -1928,7 +2014,7 @@ bool CIccCLUT::ReadData(icUInt32Number size, CIccIO *pIO, icUInt8Number nPrecisi
   if (nNum * nPrecision > size)
     return false;
 
-  if (m_pData == NULL)
+  if (m_pData == NULL || !MakeDataUnique())
     return false;
 
   if (nPrecision==1) {
@@ -2102,11 +2188,19 @@ void CIccCLUT::Iterate(std::string &sDescription, icUInt8Number nIndex, icUInt32
  * Args: 
  *  pExec = pointer to the IIccCLUTExec object that implements the 
  *          IIccCLUTExec::Apply() function
+ *  bReadOnly = true if pExec does not modify the data, in which case grid
+ *          data shared with copies of this CLUT is left shared
  * 
+ * Return:
+ *  true = iteration completed,
+ *  false = no data or unable to make a copy of shared data to modify
  *****************************************************************************
  */
-void CIccCLUT::Iterate(IIccCLUTExec* pExec)
+bool CIccCLUT::Iterate(IIccCLUTExec* pExec, bool bReadOnly/*=false*/)
 {
+  if (!m_pData || (!bReadOnly && !MakeDataUnique()))
+    return false;
+
   memset(&m_fGridAdr[0], 0, sizeof(m_fGridAdr));
   if (m_nInput==3) {
     int i,j,k;
@@ -2148,6 +2242,8 @@ void CIccCLUT::Iterate(IIccCLUTExec* pExec)
   }
   else
     SubIterate(pExec, 0, 0);
+
+  return true;
 }
 
 
@@ -2480,6 +2576,106 @@ CIccApplyCLUT* CIccCLUT::GetNewApply()
   return rv;
 }
 
+#define ICC_CLUT_WIDE_OUTPUT 8
+
+/**
+******************************************************************************
+* Name: CIccClutBlend
+* 
+* Purpose: Blends the output vectors of nNodes grid nodes using per node
+*  weights that have already been computed for the pixel.  Nodes are walked
+*  for each block of output channels so that the accumulators stay in
+*  registers.  The generic version is used unless icFloatNumber is float, in
+*  which case the contiguous node samples are loaded as AVX/FMA or SSE
+*  vectors when the compiler targets them.
+*
+* Args:
+*  destPixel = location to store nOutput blended values,
+*  p = first output channel of the base grid node,
+*  offsets = offsets from p for each node,
+*  weights = weight of each node,
+*  nNodes = number of nodes to blend,
+*  nOutput = number of output channels
+*******************************************************************************
+*/
+template <class T>
+struct CIccClutBlend
+{
+  static void Blend(T *destPixel, const T *p, const icUInt32Number *offsets, const T *weights,
+                    icUInt32Number nNodes, icUInt32Number nOutput)
+  {
+    icUInt32Number i=0, j;
+
+    for (; i+4<=nOutput; i+=4) {
+      T a0=0, a1=0, a2=0, a3=0;
+      for (j=0; j<nNodes; j++) {
+        const T *n = p + offsets[j] + i;
+        T w = weights[j];
+        a0 += n[0]*w;
+        a1 += n[1]*w;
+        a2 += n[2]*w;
+        a3 += n[3]*w;
+      }
+      destPixel[i] = a0;
+      destPixel[i+1] = a1;
+      destPixel[i+2] = a2;
+      destPixel[i+3] = a3;
+    }
+    for (; i<nOutput; i++) {
+      T pv = 0;
+      for (j=0; j<nNodes; j++)
+        pv += p[offsets[j]+i] * weights[j];
+      destPixel[i] = pv;
+    }
+  }
+};
+
+#if defined(__AVX__) || defined(__SSE2__) || defined(_M_X64)
+template <>
+struct CIccClutBlend<float>
+{
+  static void Blend(float *destPixel, const float *p, const icUInt32Number *offsets, const float *weights,
+                    icUInt32Number nNodes, icUInt32Number nOutput)
+  {
+    icUInt32Number i=0, j;
+
+#if defined(__AVX__)
+    for (; i+8<=nOutput; i+=8) {
+      __m256 acc = _mm256_setzero_ps();
+      for (j=0; j<nNodes; j++) {
+#if defined(__FMA__)
+        acc = _mm256_fmadd_ps(_mm256_set1_ps(weights[j]), _mm256_loadu_ps(p + offsets[j] + i), acc);
+#else
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_set1_ps(weights[j]), _mm256_loadu_ps(p + offsets[j] + i)));
+#endif
+      }
+      _mm256_storeu_ps(destPixel + i, acc);
+    }
+#endif
+    for (; i+4<=nOutput; i+=4) {
+      __m128 acc = _mm_setzero_ps();
+      for (j=0; j<nNodes; j++) {
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(weights[j]), _mm_loadu_ps(p + offsets[j] + i)));
+      }
+      _mm_storeu_ps(destPixel + i, acc);
+    }
+    for (; i<nOutput; i++) {
+      float pv = 0;
+      for (j=0; j<nNodes; j++)
+        pv += p[offsets[j]+i] * weights[j];
+      destPixel[i] = pv;
+    }
+  }
+};
+#endif
+
+static inline void icClutBlendNodes(icFloatNumber *destPixel, const icFloatNumber *p,
+                                    const icUInt32Number *offsets, const icFloatNumber *weights,
+                                    icUInt32Number nNodes, icUInt32Number nOutput)
+{
+  CIccClutBlend<icFloatNumber>::Blend(destPixel, p, offsets, weights, nNodes, nOutput);
+}
+
 /**
 ******************************************************************************
 * Name: CIccCLUT::Interp1d
@@ -2633,6 +2829,45 @@ void CIccCLUT::Interp3dTetra(icFloatNumber *destPixel, const icFloatNumber *srcP
   int i;
   icFloatNumber *p = &m_pData[ix*n001 + iy*n010 + iz*n100];
 
+  if (m_nOutput>=ICC_CLUT_WIDE_OUTPUT) {
+    //Select the tetrahedron and its corner weights once for all output channels
+    icUInt32Number nOff[4];
+    icFloatNumber dF[4];
+
+    nOff[0] = n000;
+    nOff[3] = n111;
+    if (t<u) {
+      if (t>v) {
+        nOff[1] = n010; nOff[2] = n110;
+        dF[0] = 1.0f-u; dF[1] = u-t; dF[2] = t-v; dF[3] = v;
+      }
+      else if (u<v) {
+        nOff[1] = n001; nOff[2] = n011;
+        dF[0] = 1.0f-v; dF[1] = v-u; dF[2] = u-t; dF[3] = t;
+      }
+      else {
+        nOff[1] = n010; nOff[2] = n011;
+        dF[0] = 1.0f-u; dF[1] = u-v; dF[2] = v-t; dF[3] = t;
+      }
+    }
+    else {
+      if (t<v) {
+        nOff[1] = n001; nOff[2] = n101;
+        dF[0] = 1.0f-v; dF[1] = v-t; dF[2] = t-u; dF[3] = u;
+      }
+      else if (u<v) {
+        nOff[1] = n100; nOff[2] = n101;
+        dF[0] = 1.0f-t; dF[1] = t-v; dF[2] = v-u; dF[3] = u;
+      }
+      else {
+        nOff[1] = n100; nOff[2] = n110;
+        dF[0] = 1.0f-t; dF[1] = t-u; dF[2] = u-v; dF[3] = v;
+      }
+    }
+    icClutBlendNodes(destPixel, p, nOff, dF, 4, m_nOutput);
+    return;
+  }
+
   //Normalize grid units
 
   for (i=0; i<m_nOutput; i++, p++) {
@@ -2735,6 +2970,13 @@ void CIccCLUT::Interp3d(icFloatNumber *destPixel, const icFloatNumber *srcPixel)
   dF6 =  s*  t* nu;
   dF7 =  s*  t*  u;
 
+  if (m_nOutput>=ICC_CLUT_WIDE_OUTPUT) {
+    icUInt32Number nOff[8] = { n000, n001, n010, n011, n100, n101, n110, n111 };
+    icFloatNumber dF[8] = { dF0, dF1, dF2, dF3, dF4, dF5, dF6, dF7 };
+    icClutBlendNodes(destPixel, p, nOff, dF, 8, m_nOutput);
+    return;
+  }
+
   for (i=0; i<m_nOutput; i++, p++) {
     pv = p[n000]*dF0 + p[n001]*dF1 + p[n010]*dF2 + p[n011]*dF3 +
          p[n100]*dF4 + p[n101]*dF5 + p[n110]*dF6 + p[n111]*dF7;
@@ -2822,6 +3064,11 @@ void CIccCLUT::Interp4d(icFloatNumber *destPixel, const icFloatNumber *srcPixel)
   dF[14] =  s*  t*  u* nv;
   dF[15] =  s*  t*  u*  v;
 
+  if (m_nOutput>=ICC_CLUT_WIDE_OUTPUT) {
+    icClutBlendNodes(destPixel, p, m_nOffset, dF, 16, m_nOutput);
+    return;
+  }
+
   for (i=0; i<m_nOutput; i++, p++) {
     for (pv=0, j=0; j<16; j++)
       pv += p[m_nOffset[j]] * dF[j];
@@ -2933,6 +3180,11 @@ void CIccCLUT::Interp5d(icFloatNumber *destPixel, const icFloatNumber *srcPixel)
   dF[30] =  s0 *  s1 *  s2 *  s3 * ns4;
   dF[31] =  s0 *  s1 *  s2 *  s3 *  s4;
 
+  if (m_nOutput>=ICC_CLUT_WIDE_OUTPUT) {
+    icClutBlendNodes(destPixel, p, m_nOffset, dF, 32, m_nOutput);
+    return;
+  }
+
   for (i=0; i<m_nOutput; i++, p++) {
     for (pv=0.0, j=0; j<32; j++)
       pv += p[m_nOffset[j]] * dF[j];
@@ -3086,6 +3338,11 @@ void CIccCLUT::Interp6d(icFloatNumber *destPixel, const icFloatNumber *srcPixel)
   dF[62] =  s0 *  s1 *  s2 *  s3 *  s4 * ns5;
   dF[63] =  s0 *  s1 *  s2 *  s3 *  s4 *  s5;
 
+  if (m_nOutput>=ICC_CLUT_WIDE_OUTPUT) {
+    icClutBlendNodes(destPixel, p, m_nOffset, dF, 64, m_nOutput);
+    return;
+  }
+
   for (i=0; i<m_nOutput; i++, p++) {
     for (pv=0, j=0; j<64; j++)
       pv += p[m_nOffset[j]] * dF[j];
@@ -3146,6 +3403,11 @@ void CIccCLUT::InterpND(icFloatNumber *destPixel, const icFloatNumber *srcPixel,
     nFlag = 0;
   }
 
+  if (m_nOutput>=ICC_CLUT_WIDE_OUTPUT) {
+    icClutBlendNodes(destPixel, p, m_nOffset, df, m_nNodes, m_nOutput);
+    return;
+  }
+
   for (i=0; i<m_nOutput; i++, p++) {
     for (pv=0, j=0; j<m_nNodes; j++)
       pv += p[m_nOffset[j]] * df[j];
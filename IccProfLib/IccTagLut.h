@@ -339,8 +339,15 @@ public:
                icColorSpaceSignature csInput, icColorSpaceSignature csOutput,
                int nVerboseness, bool bUseLegacy=false);
 
-  icFloatNumber& operator[](int index) { return m_pData[index]; }
-  icFloatNumber* GetData(int index) { return &m_pData[index]; }
+  //Non-const access is write access: it first gives this CLUT its own copy of
+  //shared grid data, so it must not be used concurrently on the same CLUT.
+  //If the copy cannot be made GetData() returns NULL and operator[] returns a
+  //scratch value so the write is dropped rather than made to the shared data.
+  icFloatNumber& operator[](int index) { if (!MakeDataUnique() || !m_pData) { m_fNoData = 0; return m_fNoData; } return m_pData[index]; }
+  icFloatNumber operator[](int index) const { return m_pData[index]; }
+  icFloatNumber* GetData(int index) { return MakeDataUnique() && m_pData ? &m_pData[index] : NULL; }
+  const icFloatNumber* GetConstData(int index) const { return m_pData ? &m_pData[index] : NULL; }
+  bool IsDataShared() const;
   icUInt32Number NumPoints() const { return m_nNumPoints; }
   icUInt8Number GridPoints() const { return m_GridPoints[0]; }
   icUInt8Number GridPoint(int index) const { return m_GridPoints[index]; }
@@ -369,7 +376,7 @@ public:
   void Interp6d(icFloatNumber *destPixel, const icFloatNumber *srcPixel) const;
   void InterpND(icFloatNumber *destPixel, const icFloatNumber *srcPixel, CIccApplyCLUT *pApply) const;
 
-  void Iterate(IIccCLUTExec* pExec);
+  bool Iterate(IIccCLUTExec* pExec, bool bReadOnly=false);
   icValidateStatus Validate(std::string sigPath, std::string &sReport, const CIccProfile* pProfile=NULL)  const;
 
   void SetClipFunc(icCLUTCLIPFUNC ClipFunc) { UnitClip = ClipFunc; }
@@ -378,6 +385,7 @@ public:
   void SetPrecision(icUInt8Number nPrecision) { m_nPrecision = nPrecision; }
 
 protected:
+  bool MakeDataUnique();
   void Iterate(std::string &sDescription, icUInt8Number nIndex, icUInt32Number nPos, size_t bufSize, bool bUseLegacy=false );
   void SubIterate(IIccCLUTExec* pExec, icUInt8Number nIndex, icUInt32Number nPos);
 
@@ -393,8 +401,13 @@ protected:
   icUInt32Number m_nNumPoints;
 
   icUInt32Number m_DimSize[16];
+
+  //Grid data, shared between copies until one of them is modified
   icFloatNumber *m_pData;
 
+  //Returned by operator[] when there is no unshared data to write to
+  icFloatNumber m_fNoData;
+
   //Iteration temporary variables
   icUInt8Number m_GridAdr[16];
   icFloatNumber m_fGridAdr[16];
@@ -76,6 +76,7 @@
 #include <math.h>
 #include <string.h>
 #include <stdlib.h>
+#include <new>
 #include "IccTagMPE.h"
 #include "IccIO.h"
 #include "IccMpeFactory.h"
@@ -149,6 +150,32 @@ CIccApplyMpe* CIccMultiProcessElement::GetNewApply( CIccApplyTagMpe * /* 'pApply
 }
 
 
+/**
+ ******************************************************************************
+ * Name: CIccMultiProcessElement::ApplyBatch
+ * 
+ * Purpose: 
+ *  Applies the element to nPixels packed pixels.  Elements that can process
+ *  many pixels at once more efficiently override this.
+ * 
+ * Args: 
+ *  pApply = apply storage for the element,
+ *  pDestPixels = nPixels*NumOutputChannels() destination values,
+ *  pSrcPixels = nPixels*NumInputChannels() source values (not overlapping pDestPixels),
+ *  nPixels = number of pixels to apply
+******************************************************************************/
+void CIccMultiProcessElement::ApplyBatch(CIccApplyMpe *pApply, icFloatNumber *pDestPixels, const icFloatNumber *pSrcPixels, icUInt32Number nPixels) const
+{
+  icUInt16Number nSrc = NumInputChannels();
+  icUInt16Number nDst = NumOutputChannels();
+  icUInt32Number i;
+
+  for (i=0; i<nPixels; i++, pDestPixels+=nDst, pSrcPixels+=nSrc) {
+    Apply(pApply, pDestPixels, pSrcPixels);
+  }
+}
+
+
 /**
  ******************************************************************************
  * Name: CIccMpeUnknown::CIccMpeUnknown
@@ -624,6 +651,31 @@ CIccApplyTagMpe::CIccApplyTagMpe(CIccTagMultiProcessElement *pTag)
 {
   m_pTag = pTag;
   m_list = NULL;
+  m_pCmmEnvVarLookup = pTag ? pTag->GetCmmEnvLookup() : NULL;
+  m_pBatchBuf = NULL;
+  m_nBatchBufSize = 0;
+}
+
+
+/**
+******************************************************************************
+* Name: CIccApplyTagMpe::CIccApplyTagMpe
+* 
+* Purpose: 
+*  Makes an apply object whose elements read environment variables from
+*  pCmmEnvVarLookup rather than the lookup the tag was begun with.
+* 
+* Args: 
+*  pTag = tag being applied,
+*  pCmmEnvVarLookup = environment variable lookup (may be NULL)
+******************************************************************************/
+CIccApplyTagMpe::CIccApplyTagMpe(CIccTagMultiProcessElement *pTag, IIccCmmEnvVarLookup *pCmmEnvVarLookup)
+{
+  m_pTag = pTag;
+  m_list = NULL;
+  m_pCmmEnvVarLookup = pCmmEnvVarLookup;
+  m_pBatchBuf = NULL;
+  m_nBatchBufSize = 0;
 }
 
 
@@ -648,6 +700,36 @@ CIccApplyTagMpe::~CIccApplyTagMpe()
 
     delete m_list;
   }
+
+  if (m_pBatchBuf)
+    delete [] m_pBatchBuf;
+}
+
+
+/**
+******************************************************************************
+* Name: CIccApplyTagMpe::GetBatchBuf
+* 
+* Purpose: 
+*  Returns scratch storage for ApplyBatch that is kept for later calls.
+* 
+* Args: 
+*  nSize = number of values needed
+* 
+* Return: 
+*  The buffer, or NULL if it could not be allocated
+******************************************************************************/
+icFloatNumber *CIccApplyTagMpe::GetBatchBuf(size_t nSize)
+{
+  if (nSize > m_nBatchBufSize) {
+    if (m_pBatchBuf)
+      delete [] m_pBatchBuf;
+
+    m_pBatchBuf = new (std::nothrow) icFloatNumber[nSize];
+    m_nBatchBufSize = m_pBatchBuf ? nSize : 0;
+  }
+
+  return m_pBatchBuf;
 }
 
 
@@ -1394,7 +1476,28 @@ CIccMultiProcessElementList::iterator CIccTagMultiProcessElement::GetLastElem()
 ******************************************************************************/
 CIccApplyTagMpe *CIccTagMultiProcessElement::GetNewApply()
 {
-  CIccApplyTagMpe *pApply = new CIccApplyTagMpe(this);
+  return GetNewApply(m_pCmmEnvVarLookup);
+}
+
+
+/**
+******************************************************************************
+* Name: CIccTagMultiProcessElement::GetNewApply
+* 
+* Purpose: 
+*  Makes an apply object that reads environment variables from
+*  pCmmEnvVarLookup.  A begun tag shared by several CMMs is applied with
+*  the lookup of the CMM making the apply object, which must outlive it.
+* 
+* Args: 
+*  pCmmEnvVarLookup = environment variable lookup (may be NULL)
+* 
+* Return: 
+*  The new apply object, or NULL on failure
+******************************************************************************/
+CIccApplyTagMpe *CIccTagMultiProcessElement::GetNewApply(IIccCmmEnvVarLookup *pCmmEnvVarLookup)
+{
+  CIccApplyTagMpe *pApply = new CIccApplyTagMpe(this, pCmmEnvVarLookup);
 
   if (!pApply)
     return NULL;
@@ -1521,6 +1624,88 @@ void CIccTagMultiProcessElement::Apply(CIccApplyTagMpe *pApply, icFloatNumber *p
 }
 
 
+/**
+ ******************************************************************************
+ * Name: CIccTagMultiProcessElement::ApplyBatch
+ * 
+ * Purpose: 
+ *  Applies the processing elements to nPixels packed pixels.  Pixels are
+ *  passed through each element in blocks so that elements can use their
+ *  batch implementations.
+ * 
+ * Args: 
+ *  pApply = apply storage from GetNewApply(),
+ *  pDestPixels = nPixels*NumOutputChannels() destination values,
+ *  pSrcPixels = nPixels*NumInputChannels() source values,
+ *  nPixels = number of pixels to apply
+ ******************************************************************************/
+void CIccTagMultiProcessElement::ApplyBatch(CIccApplyTagMpe *pApply, icFloatNumber *pDestPixels, const icFloatNumber *pSrcPixels, icUInt32Number nPixels) const
+{
+  if (!pApply || !pApply->GetList() || !pApply->GetList()->size()) {
+    if (pDestPixels != pSrcPixels)
+      memmove(pDestPixels, pSrcPixels, (size_t)nPixels*m_nInputChannels*sizeof(icFloatNumber));
+    return;
+  }
+
+  const icUInt32Number nBlock = 64;
+  icUInt32Number nMaxChannels = pApply->GetBuf()->GetMaxChannels();
+  if (nMaxChannels < m_nInputChannels)
+    nMaxChannels = m_nInputChannels;
+  if (nMaxChannels < m_nOutputChannels)
+    nMaxChannels = m_nOutputChannels;
+
+  icFloatNumber *pBuf1 = pApply->GetBatchBuf((size_t)2*nBlock*nMaxChannels);
+
+  icUInt32Number p, nb;
+
+  if (!pBuf1) {
+    for (p=0; p<nPixels; p++)
+      Apply(pApply, pDestPixels + (size_t)p*m_nOutputChannels, pSrcPixels + (size_t)p*m_nInputChannels);
+    return;
+  }
+
+  icFloatNumber *pBuf2 = pBuf1 + (size_t)nBlock*nMaxChannels;
+
+  for (p=0; p<nPixels; p+=nBlock) {
+    nb = nPixels - p;
+    if (nb > nBlock)
+      nb = nBlock;
+
+    const icFloatNumber *pSrc = pSrcPixels + (size_t)p*m_nInputChannels;
+    icFloatNumber *pDst = pDestPixels + (size_t)p*m_nOutputChannels;
+    const icFloatNumber *pCur = pSrc;
+
+    CIccApplyMpeIter i = pApply->begin();
+    CIccApplyMpeIter next = i;
+
+    for (next++; i!=pApply->end(); i++) {
+      bool bFirst = (i==pApply->begin());
+      bool bLast = (next==pApply->end());
+
+      if (!bFirst && !bLast && i->ptr->GetElem()->IsAcs()) {
+        next++;
+        continue;
+      }
+
+      icFloatNumber *pOut;
+      if (bLast && pCur!=pDst)
+        pOut = pDst;
+      else
+        pOut = (pCur==pBuf1 ? pBuf2 : pBuf1);
+
+      i->ptr->ApplyBatch(pOut, pCur, nb);
+      pCur = pOut;
+
+      next++;
+    }
+
+    //Elements rely on destination != source so in place single element results are copied
+    if (pCur != pDst)
+      memcpy(pDst, pCur, (size_t)nb*m_nOutputChannels*sizeof(icFloatNumber));
+  }
+}
+
+
 /**
  ******************************************************************************
  * Name: CIccTagMultiProcessElement::Validate
@@ -144,6 +144,9 @@ public:
   CIccMultiProcessElement() { m_nReserved = 0; m_nInputChannels = 0; m_nOutputChannels = 0; }
 
   virtual ~CIccMultiProcessElement() { }
+
+  static void *operator new(size_t nSize) { return CIccMemArena::AllocObject(nSize); }
+  static void operator delete(void *pElem) { CIccMemArena::FreeObject(pElem); }
   
   static CIccMultiProcessElement* Create(icElemTypeSignature sig);
 
@@ -166,6 +169,7 @@ public:
 
   virtual CIccApplyMpe* GetNewApply(CIccApplyTagMpe *pApplyTag);
   virtual void Apply(CIccApplyMpe *pApply, icFloatNumber *pDestPixel, const icFloatNumber *pSrcPixel) const = 0;
+  virtual void ApplyBatch(CIccApplyMpe *pApply, icFloatNumber *pDestPixels, const icFloatNumber *pSrcPixels, icUInt32Number nPixels) const;
 
   virtual icValidateStatus Validate(std::string sigPath, std::string &sReport, const CIccTagMultiProcessElement* pMPE=NULL, const CIccProfile* pProfile = NULL) const = 0;
 
@@ -207,6 +211,7 @@ public:
   CIccMultiProcessElement *GetElem() const { return m_pElem; }
 
   void Apply(icFloatNumber *pDestPixel, const icFloatNumber *pSrcPixel) { m_pElem->Apply(this, pDestPixel, pSrcPixel); }
+  void ApplyBatch(icFloatNumber *pDestPixels, const icFloatNumber *pSrcPixels, icUInt32Number nPixels) { m_pElem->ApplyBatch(this, pDestPixels, pSrcPixels, nPixels); }
 
 protected:
   CIccApplyTagMpe *m_pApplyTag;
@@ -317,9 +322,11 @@ class CIccApplyTagMpe
 {
 public:
   CIccApplyTagMpe(CIccTagMultiProcessElement *pTag);
+  CIccApplyTagMpe(CIccTagMultiProcessElement *pTag, IIccCmmEnvVarLookup *pCmmEnvVarLookup);
   virtual ~CIccApplyTagMpe();
 
   CIccTagMultiProcessElement *GetTag() { return m_pTag; }
+  IIccCmmEnvVarLookup *GetCmmEnvLookup() { return m_pCmmEnvVarLookup; }
 
   virtual bool AppendElem(CIccMultiProcessElement *pElem);
 
@@ -329,6 +336,8 @@ public:
   CIccApplyMpeIter begin() { return m_list->begin(); }
   CIccApplyMpeIter end() { return m_list->end(); }
 
+  icFloatNumber *GetBatchBuf(size_t nSize);
+
 protected:
   CIccTagMultiProcessElement *m_pTag;
 
@@ -337,6 +346,13 @@ protected:
 
   //Pixel data for Apply 
   CIccDblPixelBuffer m_applyBuf;
+
+  //Environment variables read by elements applied with this object
+  IIccCmmEnvVarLookup *m_pCmmEnvVarLookup;
+
+  //Intermediate pixels of ApplyBatch (allocated on first use)
+  icFloatNumber *m_pBatchBuf;
+  size_t m_nBatchBufSize;
 };
 
 
@@ -381,8 +397,10 @@ public:
                      IIccProfileConnectionConditions *pAppliedPCC = NULL,
                      IIccCmmEnvVarLookup *pCmmEnvVarLookup = NULL);
   virtual CIccApplyTagMpe *GetNewApply();
+  CIccApplyTagMpe *GetNewApply(IIccCmmEnvVarLookup *pCmmEnvVarLookup);
 
   virtual void Apply(CIccApplyTagMpe *pApply, icFloatNumber *pDestPixel, const icFloatNumber *pSrcPixel) const;
+  virtual void ApplyBatch(CIccApplyTagMpe *pApply, icFloatNumber *pDestPixels, const icFloatNumber *pSrcPixels, icUInt32Number nPixels) const;
 
   virtual icValidateStatus Validate(std::string sigPath, std::string &sReport, const CIccProfile* pProfile=NULL) const;
 
@@ -78,9 +78,11 @@
 #include <stdlib.h>
 #include <memory.h>
 #include <ctype.h>
+#include <new>
 #include <math.h>
 #include <string.h>
 #include <time.h>
+#include <algorithm>
 
 #define PI 3.1415926535897932384626433832795
 
@@ -2628,6 +2630,770 @@ CIccPixelBuf::~CIccPixelBuf()
     delete [] m_pixel;
 }
 
+
+#define ICC_ARENA_ALIGN(n) (((n) + 15) & ~((size_t)15))
+#define ICC_ARENA_BLOCKHDR ICC_ARENA_ALIGN(sizeof(CIccMemArena::IccArenaBlock))
+#define ICC_ARENA_OBJHDR ICC_ARENA_ALIGN(sizeof(CIccMemArena::IccArenaObject))
+
+//Number of object references a scope takes from the arena at a time
+#define ICC_ARENA_REFBATCH 64
+
+//Blocks with less room than this are not handed to later scopes
+#define ICC_ARENA_MINSPARE 1024
+
+static thread_local CIccMemArena::IccArenaLane *g_pIccCurLane = NULL;
+
+//Rounds an allocation (including its header) up to its free list size
+static size_t icArenaClassSize(size_t nSize, int &nClass)
+{
+  nSize = ICC_ARENA_ALIGN(nSize);
+
+  if (nSize <= 1024) {
+    nClass = (int)(nSize/16) - 1;
+    return nSize;
+  }
+
+  size_t nClassSize = 2048;
+  for (nClass = 64; nClassSize < nSize; nClass++)
+    nClassSize <<= 1;
+
+  return nClassSize;
+}
+
+static inline CIccMemArena::IccArenaObject *icArenaHeader(const void *pObj)
+{
+  return (CIccMemArena::IccArenaObject*)((unsigned char*)pObj - ICC_ARENA_OBJHDR);
+}
+
+CIccMemArena::CIccMemArena(size_t nBlockSize/*=ICC_ARENA_BLOCKSIZE*/) : m_nFree(0), m_bRecycle(true), m_nRefs(1)
+{
+  m_pBlocks = NULL;
+  m_pSpare = NULL;
+  m_nBlockSize = nBlockSize < 4*ICC_ARENA_MAXOBJECT ? 4*ICC_ARENA_MAXOBJECT : nBlockSize;
+  m_nBlocks = 0;
+  m_nBytesUsed = 0;
+  memset(m_pFree, 0, sizeof(m_pFree));
+}
+
+CIccMemArena::~CIccMemArena()
+{
+  FreeBlocks();
+}
+
+void CIccMemArena::FreeBlocks()
+{
+  IccArenaBlock *pBlock, *pNext;
+
+  for (pBlock = m_pBlocks; pBlock; pBlock = pNext) {
+    pNext = pBlock->pNext;
+    free(pBlock);
+  }
+  m_pBlocks = NULL;
+  m_pSpare = NULL;
+  m_nBlocks = 0;
+  m_nBytesUsed = 0;
+
+  memset(m_pFree, 0, sizeof(m_pFree));
+  m_nFree = 0;
+}
+
+/**
+ ******************************************************************************
+ * Name: CIccMemArena::Release
+ * 
+ * Purpose: 
+ *  Drops the owner's reference.  The arena and its blocks are freed once
+ *  every object allocated from it has also been deleted.
+ ******************************************************************************
+ */
+void CIccMemArena::Release()
+{
+  m_bRecycle = false;
+  Unref();
+}
+
+void CIccMemArena::Unref(size_t nRefs/*=1*/)
+{
+  if (m_nRefs.fetch_sub(nRefs)==nRefs)
+    delete this;
+}
+
+/**
+ ******************************************************************************
+ * Name: CIccMemArena::BeginTeardown
+ * 
+ * Purpose: 
+ *  Called by the owner before it deletes the objects it allocated.  Their
+ *  storage is not put on the free lists since the blocks are about to be
+ *  released or reset as a whole.
+ ******************************************************************************
+ */
+void CIccMemArena::BeginTeardown()
+{
+  m_bRecycle = false;
+}
+
+/**
+ ******************************************************************************
+ * Name: CIccMemArena::Reset
+ * 
+ * Purpose: 
+ *  Returns all blocks to the heap so the arena can be reused.
+ * 
+ * Return: 
+ *  false if objects allocated from the arena are still alive, or a scope
+ *  is using it, in which case nothing is freed.
+ ******************************************************************************
+ */
+bool CIccMemArena::Reset()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  if (m_nRefs.load()!=1)
+    return false;
+
+  FreeBlocks();
+  m_bRecycle = true;
+
+  return true;
+}
+
+/**
+ ******************************************************************************
+ * Name: CIccMemArena::NewBlock
+ * 
+ * Purpose: 
+ *  Allocates a block and adds it to the blocks of the arena.
+ * 
+ * Return: 
+ *  The new block, or NULL if out of memory.
+ ******************************************************************************
+ */
+CIccMemArena::IccArenaBlock *CIccMemArena::NewBlock()
+{
+  IccArenaBlock *pBlock = (IccArenaBlock*)malloc(ICC_ARENA_BLOCKHDR + m_nBlockSize);
+  if (!pBlock)
+    return NULL;
+
+  pBlock->pNextSpare = NULL;
+  pBlock->nSize = m_nBlockSize;
+  pBlock->nUsed = 0;
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  pBlock->pNext = m_pBlocks;
+  m_pBlocks = pBlock;
+  m_nBlocks++;
+
+  return pBlock;
+}
+
+/**
+ ******************************************************************************
+ * Name: CIccMemArena::AttachLane
+ * 
+ * Purpose: 
+ *  Starts a scope's use of the arena.  The scope holds a reference to the
+ *  arena and continues filling a partly used block when one is spare.
+ ******************************************************************************
+ */
+void CIccMemArena::AttachLane(IccArenaLane *pLane)
+{
+  m_nRefs++;
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  pLane->pBlock = m_pSpare;
+  if (m_pSpare)
+    m_pSpare = m_pSpare->pNextSpare;
+}
+
+/**
+ ******************************************************************************
+ * Name: CIccMemArena::DetachLane
+ * 
+ * Purpose: 
+ *  Ends a scope's use of the arena.  The scope's block is kept for later
+ *  scopes, and its unused object references and its own reference are
+ *  returned.
+ ******************************************************************************
+ */
+void CIccMemArena::DetachLane(IccArenaLane *pLane)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    IccArenaBlock *pBlock = pLane->pBlock;
+    if (pBlock && pBlock->nUsed + ICC_ARENA_MINSPARE <= pBlock->nSize) {
+      pBlock->pNextSpare = m_pSpare;
+      m_pSpare = pBlock;
+    }
+    m_nBytesUsed += pLane->nBytesUsed;
+  }
+
+  size_t nRefs = pLane->nRefs + 1;
+
+  pLane->pBlock = NULL;
+  pLane->nRefs = 0;
+  pLane->nBytesUsed = 0;
+
+  Unref(nRefs);
+}
+
+/**
+ ******************************************************************************
+ * Name: CIccMemArena::Alloc
+ * 
+ * Purpose: 
+ *  Allocates nSize bytes (including the object header), reusing freed
+ *  storage of the same size when there is any.  Otherwise the storage is
+ *  carved out of the scope's block.  Only the scope's thread uses its
+ *  block, so no lock is taken unless there is freed storage or a new block
+ *  is needed.
+ ******************************************************************************
+ */
+CIccMemArena::IccArenaObject *CIccMemArena::Alloc(IccArenaLane *pLane, size_t nSize)
+{
+  int nClass;
+  IccArenaObject *pObj = NULL;
+
+  nSize = icArenaClassSize(nSize, nClass);
+
+  if (m_nFree.load(std::memory_order_relaxed)) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    pObj = m_pFree[nClass];
+    if (pObj) {
+      m_pFree[nClass] = *(IccArenaObject**)pObj;
+      m_nFree--;
+    }
+  }
+
+  if (!pObj) {
+    IccArenaBlock *pBlock = pLane->pBlock;
+    if (!pBlock || pBlock->nUsed + nSize > pBlock->nSize) {
+      pBlock = NewBlock();
+      if (!pBlock)
+        return NULL;
+      pLane->pBlock = pBlock;
+    }
+
+    pObj = (IccArenaObject*)((unsigned char*)pBlock + ICC_ARENA_BLOCKHDR + pBlock->nUsed);
+    pBlock->nUsed += nSize;
+    pLane->nBytesUsed += nSize;
+  }
+
+  if (!pLane->nRefs) {
+    m_nRefs.fetch_add(ICC_ARENA_REFBATCH);
+    pLane->nRefs = ICC_ARENA_REFBATCH;
+  }
+  pLane->nRefs--;
+
+  pObj->pArena = this;
+  pObj->nSize = nSize;
+
+  return pObj;
+}
+
+/**
+ ******************************************************************************
+ * Name: CIccMemArena::Recycle
+ * 
+ * Purpose: 
+ *  Puts the storage of a deleted object on its free list, unless the owner
+ *  is tearing down, and drops the object's reference.
+ ******************************************************************************
+ */
+void CIccMemArena::Recycle(IccArenaObject *pObj)
+{
+  if (m_bRecycle.load(std::memory_order_relaxed)) {
+    int nClass;
+    icArenaClassSize(pObj->nSize, nClass);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    *(IccArenaObject**)pObj = m_pFree[nClass];
+    m_pFree[nClass] = pObj;
+    m_nFree++;
+  }
+
+  Unref();
+}
+
+/**
+ ******************************************************************************
+ * Name: CIccMemArena::AllocObject
+ * 
+ * Purpose: 
+ *  Allocates object storage from the arena current on this thread, or from
+ *  the heap when no arena is current.  Throws std::bad_alloc on failure.
+ ******************************************************************************
+ */
+void *CIccMemArena::AllocObject(size_t nSize)
+{
+  void *pMem = AllocBuffer(nSize);
+
+  if (!pMem)
+    throw std::bad_alloc();
+
+  return pMem;
+}
+
+void CIccMemArena::FreeObject(void *pObj)
+{
+  if (!pObj)
+    return;
+
+  IccArenaObject *pHdr = icArenaHeader(pObj);
+
+  if (pHdr->pArena)
+    pHdr->pArena->Recycle(pHdr);
+  else
+    free(pHdr);
+}
+
+/**
+ ******************************************************************************
+ * Name: CIccMemArena::AllocBuffer
+ * 
+ * Purpose: 
+ *  Allocates storage like AllocObject() for owners that check for NULL.
+ *  The storage is released with FreeObject().
+ ******************************************************************************
+ */
+void *CIccMemArena::AllocBuffer(size_t nSize)
+{
+  IccArenaLane *pLane = g_pIccCurLane;
+  IccArenaObject *pHdr;
+
+  if (nSize > ICC_ARENA_MAXOBJECT || !pLane || !pLane->pArena) {
+    pHdr = (IccArenaObject*)malloc(ICC_ARENA_OBJHDR + nSize);
+    if (!pHdr)
+      return NULL;
+
+    pHdr->pArena = NULL;
+    pHdr->nSize = ICC_ARENA_OBJHDR + nSize;
+  }
+  else {
+    pHdr = pLane->pArena->Alloc(pLane, ICC_ARENA_OBJHDR + nSize);
+    if (!pHdr)
+      return NULL;
+  }
+
+  return (unsigned char*)pHdr + ICC_ARENA_OBJHDR;
+}
+
+/**
+ ******************************************************************************
+ * Name: CIccMemArena::ReallocBuffer
+ * 
+ * Purpose: 
+ *  Resizes storage from AllocBuffer().  Heap storage is resized with
+ *  realloc().  Arena storage is copied to nNewSize bytes of new storage
+ *  from the current arena (or heap) and the old storage is freed.
+ * 
+ * Return: 
+ *  The resized storage, or NULL with pBuf left unchanged when out of memory.
+ ******************************************************************************
+ */
+void *CIccMemArena::ReallocBuffer(void *pBuf, size_t nNewSize)
+{
+  if (!pBuf)
+    return AllocBuffer(nNewSize);
+
+  IccArenaObject *pHdr = icArenaHeader(pBuf);
+
+  if (!pHdr->pArena) {
+    pHdr = (IccArenaObject*)realloc(pHdr, ICC_ARENA_OBJHDR + nNewSize);
+    if (!pHdr)
+      return NULL;
+
+    pHdr->nSize = ICC_ARENA_OBJHDR + nNewSize;
+
+    return (unsigned char*)pHdr + ICC_ARENA_OBJHDR;
+  }
+
+  size_t nOldSize = pHdr->nSize - ICC_ARENA_OBJHDR;
+
+  void *pNew = AllocBuffer(nNewSize);
+  if (!pNew)
+    return NULL;
+
+  memcpy(pNew, pBuf, nOldSize < nNewSize ? nOldSize : nNewSize);
+  FreeObject(pBuf);
+
+  return pNew;
+}
+
+bool CIccMemArena::IsArenaObject(const void *pObj)
+{
+  if (!pObj)
+    return false;
+
+  return icArenaHeader(pObj)->pArena != NULL;
+}
+
+CIccMemArena *CIccMemArena::GetCurrent()
+{
+  return g_pIccCurLane ? g_pIccCurLane->pArena : NULL;
+}
+
+/**
+ ******************************************************************************
+ * Name: CIccMemArenaScope::CIccMemArenaScope
+ * 
+ * Purpose: 
+ *  Makes pArena (or the heap when NULL) the source of object storage on the
+ *  calling thread until the scope ends.
+ ******************************************************************************
+ */
+CIccMemArenaScope::CIccMemArenaScope(CIccMemArena *pArena)
+{
+  m_lane.pArena = pArena;
+  m_lane.pBlock = NULL;
+  m_lane.nRefs = 0;
+  m_lane.nBytesUsed = 0;
+  m_lane.pPrev = g_pIccCurLane;
+
+  if (pArena)
+    pArena->AttachLane(&m_lane);
+
+  g_pIccCurLane = &m_lane;
+}
+
+CIccMemArenaScope::~CIccMemArenaScope()
+{
+  g_pIccCurLane = m_lane.pPrev;
+
+  if (m_lane.pArena)
+    m_lane.pArena->DetachLane(&m_lane);
+}
+
+
+
+CIccNearestIndex::CIccNearestIndex()
+{
+  m_nPoints = 0;
+  m_nDim = 0;
+  m_nKeyDim = 0;
+  m_pPoints = NULL;
+  m_pKeys = NULL;
+  m_pMean = NULL;
+  m_pBasis = NULL;
+  m_pOrder = NULL;
+  m_pNodes = NULL;
+  m_nNodes = 0;
+}
+
+CIccNearestIndex::~CIccNearestIndex()
+{
+  Reset();
+}
+
+void CIccNearestIndex::Reset()
+{
+  if (m_pKeys!=m_pPoints)
+    delete [] m_pKeys;
+  delete [] m_pPoints;
+  delete [] m_pMean;
+  delete [] m_pBasis;
+  delete [] m_pOrder;
+  delete [] m_pNodes;
+
+  m_nPoints = 0;
+  m_nDim = 0;
+  m_nKeyDim = 0;
+  m_pPoints = NULL;
+  m_pKeys = NULL;
+  m_pMean = NULL;
+  m_pBasis = NULL;
+  m_pOrder = NULL;
+  m_pNodes = NULL;
+  m_nNodes = 0;
+}
+
+/**
+ ******************************************************************************
+ * Name: CIccNearestIndex::Build
+ * 
+ * Purpose: 
+ *  Copies the points and builds the tree.
+ * 
+ * Args: 
+ *  pPoints - nPoints consecutive points of nDim coordinates each
+ *  nKeyDim - number of principal components to split on, zero (or nDim)
+ *   to split on the coordinates themselves
+ * 
+ * Return: 
+ *  false if memory could not be allocated
+ ******************************************************************************
+ */
+bool CIccNearestIndex::Build(const icFloatNumber *pPoints, icUInt32Number nPoints, icUInt32Number nDim, icUInt32Number nKeyDim/*=0*/)
+{
+  icUInt32Number i;
+
+  Reset();
+
+  if (!nPoints || !nDim)
+    return true;
+
+  if (!nKeyDim || nKeyDim>nDim)
+    nKeyDim = nDim;
+
+  m_nPoints = nPoints;
+  m_nDim = nDim;
+  m_nKeyDim = nKeyDim;
+
+  m_pPoints = new icFloatNumber[(size_t)nPoints*nDim];
+  m_pOrder = new icUInt32Number[nPoints];
+  m_pNodes = new IccNearestNode[2*(size_t)nPoints+1];
+  if (!m_pPoints || !m_pOrder || !m_pNodes) {
+    Reset();
+    return false;
+  }
+
+  memcpy(m_pPoints, pPoints, (size_t)nPoints*nDim*sizeof(icFloatNumber));
+  for (i=0; i<nPoints; i++)
+    m_pOrder[i] = i;
+
+  if (nKeyDim<nDim) {
+    m_pKeys = new icFloatNumber[(size_t)nPoints*nKeyDim];
+    if (!m_pKeys || !MakeBasis()) {
+      Reset();
+      return false;
+    }
+    for (i=0; i<nPoints; i++)
+      GetKey(m_pKeys + (size_t)i*nKeyDim, m_pPoints + (size_t)i*nDim);
+  }
+  else {
+    m_pKeys = m_pPoints;
+  }
+
+  BuildNode(0, nPoints);
+
+  return true;
+}
+
+//Finds the leading principal components of the points by power iteration
+bool CIccNearestIndex::MakeBasis()
+{
+  icUInt32Number i, j, k, n, iter;
+  double *pCov, *pVec, *pNext, dNorm;
+
+  m_pMean = new icFloatNumber[m_nDim];
+  m_pBasis = new icFloatNumber[(size_t)m_nKeyDim*m_nDim];
+  pCov = new double[(size_t)m_nDim*m_nDim + 2*m_nDim];
+  if (!m_pMean || !m_pBasis || !pCov) {
+    delete [] pCov;
+    return false;
+  }
+  pVec = pCov + (size_t)m_nDim*m_nDim;
+  pNext = pVec + m_nDim;
+
+  for (i=0; i<m_nDim; i++) {
+    double dSum = 0;
+    for (n=0; n<m_nPoints; n++)
+      dSum += m_pPoints[(size_t)n*m_nDim + i];
+    m_pMean[i] = (icFloatNumber)(dSum / m_nPoints);
+  }
+
+  memset(pCov, 0, (size_t)m_nDim*m_nDim*sizeof(double));
+  for (n=0; n<m_nPoints; n++) {
+    const icFloatNumber *pPoint = m_pPoints + (size_t)n*m_nDim;
+    for (i=0; i<m_nDim; i++) {
+      double di = pPoint[i] - m_pMean[i];
+      for (j=i; j<m_nDim; j++)
+        pCov[i*m_nDim + j] += di * (pPoint[j] - m_pMean[j]);
+    }
+  }
+  for (i=0; i<m_nDim; i++)
+    for (j=0; j<i; j++)
+      pCov[i*m_nDim + j] = pCov[j*m_nDim + i];
+
+  for (k=0; k<m_nKeyDim; k++) {
+    for (i=0; i<m_nDim; i++)
+      pVec[i] = 1.0 + (i==k ? 1.0 : 0.0);
+
+    for (iter=0; iter<=64; iter++) {
+      //keep the vector orthogonal to the components already found
+      for (j=0; j<k; j++) {
+        const icFloatNumber *pBase = m_pBasis + (size_t)j*m_nDim;
+        double dDot = 0;
+        for (i=0; i<m_nDim; i++)
+          dDot += pVec[i]*pBase[i];
+        for (i=0; i<m_nDim; i++)
+          pVec[i] -= dDot*pBase[i];
+      }
+      dNorm = 0;
+      for (i=0; i<m_nDim; i++)
+        dNorm += pVec[i]*pVec[i];
+      dNorm = sqrt(dNorm);
+
+      if (dNorm<1.0e-12) {
+        //no variance left so any orthogonal direction will do
+        memset(pVec, 0, m_nDim*sizeof(double));
+        pVec[(k+iter)%m_nDim] = 1.0;
+        continue;
+      }
+      for (i=0; i<m_nDim; i++)
+        pVec[i] /= dNorm;
+
+      if (iter==64)
+        break;
+
+      for (i=0; i<m_nDim; i++) {
+        double dSum = 0;
+        for (j=0; j<m_nDim; j++)
+          dSum += pCov[i*m_nDim + j]*pVec[j];
+        pNext[i] = dSum + 1.0e-9*pVec[i];
+      }
+      memcpy(pVec, pNext, m_nDim*sizeof(double));
+    }
+
+    icFloatNumber *pBase = m_pBasis + (size_t)k*m_nDim;
+    for (i=0; i<m_nDim; i++)
+      pBase[i] = (icFloatNumber)pVec[i];
+  }
+
+  delete [] pCov;
+  return true;
+}
+
+void CIccNearestIndex::GetKey(icFloatNumber *pKey, const icFloatNumber *pPoint) const
+{
+  if (!m_pBasis) {
+    memcpy(pKey, pPoint, m_nDim*sizeof(icFloatNumber));
+    return;
+  }
+
+  for (icUInt32Number k=0; k<m_nKeyDim; k++) {
+    const icFloatNumber *pBase = m_pBasis + (size_t)k*m_nDim;
+    double dSum = 0;
+    for (icUInt32Number i=0; i<m_nDim; i++)
+      dSum += pBase[i]*(pPoint[i] - m_pMean[i]);
+    pKey[k] = (icFloatNumber)dSum;
+  }
+}
+
+//Splits at the median of the key coordinate with the widest spread
+icUInt32Number CIccNearestIndex::BuildNode(icUInt32Number nStart, icUInt32Number nEnd)
+{
+  icUInt32Number nNode = m_nNodes++;
+  IccNearestNode &node = m_pNodes[nNode];
+  icUInt32Number i, k;
+
+  node.nStart = nStart;
+  node.nEnd = nEnd;
+  node.nSplitDim = -1;
+  node.fSplit = 0;
+  node.nLeft = node.nRight = 0;
+
+  if (nEnd - nStart <= ICC_NEAREST_LEAFSIZE)
+    return nNode;
+
+  icFloatNumber fSpread = 0;
+  icUInt32Number nDim = 0;
+  for (k=0; k<m_nKeyDim; k++) {
+    icFloatNumber fMin, fMax;
+    fMin = fMax = m_pKeys[(size_t)m_pOrder[nStart]*m_nKeyDim + k];
+    for (i=nStart+1; i<nEnd; i++) {
+      icFloatNumber v = m_pKeys[(size_t)m_pOrder[i]*m_nKeyDim + k];
+      if (v<fMin)
+        fMin = v;
+      else if (v>fMax)
+        fMax = v;
+    }
+    if (fMax - fMin > fSpread) {
+      fSpread = fMax - fMin;
+      nDim = k;
+    }
+  }
+
+  //All keys identical
+  if (fSpread<=0)
+    return nNode;
+
+  const icFloatNumber *pKeys = m_pKeys;
+  icUInt32Number nKeyDim = m_nKeyDim;
+  icUInt32Number nMid = nStart + (nEnd - nStart)/2;
+
+  std::nth_element(m_pOrder + nStart, m_pOrder + nMid, m_pOrder + nEnd,
+                   [pKeys, nKeyDim, nDim](icUInt32Number a, icUInt32Number b) {
+                     return pKeys[(size_t)a*nKeyDim + nDim] < pKeys[(size_t)b*nKeyDim + nDim];
+                   });
+
+  icFloatNumber fSplit = m_pKeys[(size_t)m_pOrder[nMid]*m_nKeyDim + nDim];
+
+  icUInt32Number nLeft = BuildNode(nStart, nMid);
+  icUInt32Number nRight = BuildNode(nMid, nEnd);
+
+  IccNearestNode &parent = m_pNodes[nNode];
+  parent.nSplitDim = (icInt32Number)nDim;
+  parent.fSplit = fSplit;
+  parent.nLeft = nLeft;
+  parent.nRight = nRight;
+
+  return nNode;
+}
+
+void CIccNearestIndex::Search(icUInt32Number nNode, const icFloatNumber *pKey, const icFloatNumber *pPoint,
+                              icInt32Number &nBest, double &dBest) const
+{
+  const IccNearestNode &node = m_pNodes[nNode];
+
+  if (node.nSplitDim<0) {
+    for (icUInt32Number i=node.nStart; i<node.nEnd; i++) {
+      icUInt32Number n = m_pOrder[i];
+      const icFloatNumber *pCand = m_pPoints + (size_t)n*m_nDim;
+      double d = 0;
+
+      for (icUInt32Number j=0; j<m_nDim && d<=dBest; j++)
+        d += ((double)pPoint[j] - pCand[j]) * ((double)pPoint[j] - pCand[j]);
+
+      if (d<dBest || (d==dBest && (icInt32Number)n<nBest)) {
+        dBest = d;
+        nBest = (icInt32Number)n;
+      }
+    }
+    return;
+  }
+
+  double dDiff = (double)pKey[node.nSplitDim] - node.fSplit;
+
+  //points equal to the split value can be on either side
+  if (dDiff<0) {
+    Search(node.nLeft, pKey, pPoint, nBest, dBest);
+    if (dDiff*dDiff <= dBest*(1.0+1.0e-6))
+      Search(node.nRight, pKey, pPoint, nBest, dBest);
+  }
+  else {
+    Search(node.nRight, pKey, pPoint, nBest, dBest);
+    if (dDiff*dDiff <= dBest*(1.0+1.0e-6))
+      Search(node.nLeft, pKey, pPoint, nBest, dBest);
+  }
+}
+
+icInt32Number CIccNearestIndex::FindNearest(const icFloatNumber *pPoint, icFloatNumber *pDist/*=NULL*/) const
+{
+  if (!m_nPoints)
+    return -1;
+
+  icInt32Number nBest = -1;
+  double dBest = std::numeric_limits<double>::max();
+
+  if (m_pBasis) {
+    CIccPixelBuf key(m_nKeyDim);
+    GetKey(key, pPoint);
+    Search(0, key, pPoint, nBest, dBest);
+  }
+  else {
+    Search(0, pPoint, pPoint, nBest, dBest);
+  }
+
+  if (pDist)
+    *pDist = (icFloatNumber)sqrt(dBest);
+
+  return nBest;
+}
+
 #ifdef USEICCDEVNAMESPACE
 } //namespace iccDEV
 #endif
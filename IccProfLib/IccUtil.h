@@ -71,6 +71,8 @@
 #include "IccProfLibConf.h"
 #include <string>
 #include <limits>
+#include <atomic>
+#include <mutex>
 
 #ifdef USEICCDEVNAMESPACE
 namespace iccDEV {
@@ -386,6 +388,185 @@ protected:
 
 
 
+/**
+ **************************************************************************
+ * Type: Class
+ * 
+ * Purpose: 
+ *  Block allocator used to hold the objects created while parsing a
+ *  profile (tags, multi-process elements, curve segments, calculator
+ *  programs and localized strings).  Storage is carved out of large blocks
+ *  that are returned to the heap in one step once the owner has released
+ *  the arena and every object allocated from it has been deleted.  Freed
+ *  storage is kept on per-size free lists and reused until the owner
+ *  starts tearing down (see BeginTeardown()), after which deletes only
+ *  drop a count.
+ *
+ *  Objects opt in by routing their operator new/delete through
+ *  AllocObject()/FreeObject(), which use the arena made current on the
+ *  calling thread by a CIccMemArenaScope, or the heap when there is none.
+ *  Each scope allocates from its own block without locking, so parallel
+ *  readers only synchronize when a block is taken or handed back.  Every
+ *  allocation starts with a small header naming its arena, so FreeObject()
+ *  finds the owner without any lookup.
+ **************************************************************************
+ */
+#define ICC_ARENA_BLOCKSIZE 65536
+//Larger allocations always come from the heap
+#define ICC_ARENA_MAXOBJECT 16384
+//Free lists for 16 byte steps up to 1024 bytes and powers of two above
+#define ICC_ARENA_FREECLASSES 68
+
+class ICCPROFLIB_API CIccMemArena
+{
+  friend class CIccMemArenaScope;
+public:
+  CIccMemArena(size_t nBlockSize=ICC_ARENA_BLOCKSIZE);
+
+  void Release();
+  bool Reset();
+  void BeginTeardown();
+
+  size_t GetBlockCount() const { return m_nBlocks; }
+  size_t GetBytesUsed() const { return m_nBytesUsed; }
+
+  static void *AllocObject(size_t nSize);
+  static void FreeObject(void *pObj);
+
+  //malloc/realloc style versions of AllocObject() that return NULL when out of memory
+  static void *AllocBuffer(size_t nSize);
+  static void *ReallocBuffer(void *pBuf, size_t nNewSize);
+  static bool IsArenaObject(const void *pObj);
+
+  static CIccMemArena *GetCurrent();
+
+  struct IccArenaBlock {
+    IccArenaBlock *pNext;
+    IccArenaBlock *pNextSpare;
+    size_t nSize;
+    size_t nUsed;
+  };
+
+  //Header in front of every allocation (pArena is NULL for heap storage)
+  struct IccArenaObject {
+    CIccMemArena *pArena;
+    size_t nSize;
+  };
+
+  //Allocation state of one CIccMemArenaScope
+  struct IccArenaLane {
+    CIccMemArena *pArena;
+    IccArenaBlock *pBlock;
+    size_t nRefs;        //object references taken from m_nRefs but not yet handed out
+    size_t nBytesUsed;
+    IccArenaLane *pPrev;
+  };
+
+protected:
+  ~CIccMemArena();
+
+  IccArenaObject *Alloc(IccArenaLane *pLane, size_t nSize);
+  IccArenaBlock *NewBlock();
+  void Recycle(IccArenaObject *pObj);
+  void Unref(size_t nRefs=1);
+  void AttachLane(IccArenaLane *pLane);
+  void DetachLane(IccArenaLane *pLane);
+  void FreeBlocks();
+
+  IccArenaBlock *m_pBlocks;
+  IccArenaBlock *m_pSpare;
+  size_t m_nBlockSize;
+  size_t m_nBlocks;
+  size_t m_nBytesUsed;
+
+  IccArenaObject *m_pFree[ICC_ARENA_FREECLASSES];
+  std::atomic<size_t> m_nFree;
+  std::atomic<bool> m_bRecycle;
+
+  std::atomic<size_t> m_nRefs;
+  std::mutex m_mutex;
+};
+
+/**
+ **************************************************************************
+ * Type: Class
+ * 
+ * Purpose: 
+ *  Makes an arena current on the calling thread for the life of the scope
+ **************************************************************************
+ */
+class ICCPROFLIB_API CIccMemArenaScope
+{
+public:
+  CIccMemArenaScope(CIccMemArena *pArena);
+  ~CIccMemArenaScope();
+
+protected:
+  CIccMemArena::IccArenaLane m_lane;
+};
+
+
+/**
+ **************************************************************************
+ * Type: Class
+ *
+ * Purpose:
+ *  Static k-d tree for nearest neighbour searches over a fixed set of
+ *  points.  The tree is split on key coordinates, which are the point
+ *  coordinates themselves or, when nKeyDim is smaller than nDim, the
+ *  projection of each point onto its first nKeyDim principal components.
+ *  Since an orthonormal projection never lengthens a distance the keys are
+ *  only used for pruning and candidates are compared with all of their
+ *  coordinates, so searches are exact.  Ties go to the lowest point index.
+ **************************************************************************
+ */
+#define ICC_NEAREST_LEAFSIZE 8
+class ICCPROFLIB_API CIccNearestIndex
+{
+public:
+  CIccNearestIndex();
+  ~CIccNearestIndex();
+
+  bool Build(const icFloatNumber *pPoints, icUInt32Number nPoints, icUInt32Number nDim, icUInt32Number nKeyDim=0);
+  void Reset();
+
+  ///Returns index of the point closest to pPoint or -1 if empty, pDist gets the Euclidean distance
+  icInt32Number FindNearest(const icFloatNumber *pPoint, icFloatNumber *pDist=NULL) const;
+
+  icUInt32Number GetSize() const { return m_nPoints; }
+  icUInt32Number GetDim() const { return m_nDim; }
+  icUInt32Number GetKeyDim() const { return m_nKeyDim; }
+
+protected:
+  struct IccNearestNode {
+    icUInt32Number nStart, nEnd;  //range in m_pOrder when a leaf
+    icInt32Number nSplitDim;      //-1 for a leaf
+    icFloatNumber fSplit;
+    icUInt32Number nLeft, nRight;
+  };
+
+  icUInt32Number BuildNode(icUInt32Number nStart, icUInt32Number nEnd);
+  void Search(icUInt32Number nNode, const icFloatNumber *pKey, const icFloatNumber *pPoint,
+              icInt32Number &nBest, double &dBest) const;
+  void GetKey(icFloatNumber *pKey, const icFloatNumber *pPoint) const;
+  bool MakeBasis();
+
+  icUInt32Number m_nPoints;
+  icUInt32Number m_nDim;
+  icUInt32Number m_nKeyDim;
+
+  icFloatNumber *m_pPoints;
+  icFloatNumber *m_pKeys;
+  icFloatNumber *m_pMean;   //only used with a projection basis
+  icFloatNumber *m_pBasis;  //nKeyDim rows of nDim values
+  icUInt32Number *m_pOrder;
+
+  IccNearestNode *m_pNodes;
+  icUInt32Number m_nNodes;
+};
+
+
+
 /**
 **************************************************************************
 * Type: Class
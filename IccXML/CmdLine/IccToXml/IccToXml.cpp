@@ -22,6 +22,9 @@ int main(int argc, char* argv[])
   CIccProfileXml profile;
   CIccFileIO srcIO, dstIO;
 
+  //The profile is read once and freed as a whole
+  profile.UseArena();
+
   if (!srcIO.Open(argv[1], "r")) {
     printf("Unable to open '%s'\n", argv[1]);
     return -1;
@@ -527,7 +527,7 @@ bool icCLUTDataToXml(std::string &xml, CIccCLUT *pCLUT, icConvertType nType, std
 
   xml += ">\n";
 
-  pCLUT->Iterate(&dumper);
+  pCLUT->Iterate(&dumper, true);
 
   dumper.Finish();
 
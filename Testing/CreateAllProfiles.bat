@@ -78,6 +78,22 @@ iccFromXml sRgbEncodingOverrides.xml sRgbEncodingOverrides.icc
 @echo off
 :end_Encoding
 
+cd ..\FastPath
+if not "%1"=="clean" goto do_FastPath
+del /F/Q *.icc 2>NUL:
+goto end_FastPath
+:do_FastPath
+@echo on
+iccFromXml CamAbstract.xml CamAbstract.icc
+iccFromXml NamedColor2Lab.xml NamedColor2Lab.icc
+iccFromXml SpectralClut3.xml SpectralClut3.icc
+iccFromXml SpectralClut4.xml SpectralClut4.icc
+iccFromXml SpectralClut5.xml SpectralClut5.icc
+iccFromXml SpectralClut6.xml SpectralClut6.icc
+iccFromXml SpectralClut7.xml SpectralClut7.icc
+@echo off
+:end_FastPath
+
 cd ..\ICS
 if not "%1"=="clean" goto do_ICS
 del /F/Q *.icc 2>NUL:
@@ -119,6 +119,23 @@ then
 	set -
 fi
 
+echo "====================== FastPath =========================="
+
+cd ../FastPath
+find . -iname "*\.icc" -delete
+if [ "$1" != "clean" ]
+then
+	set -x
+	iccFromXml CamAbstract.xml CamAbstract.icc
+	iccFromXml NamedColor2Lab.xml NamedColor2Lab.icc
+	iccFromXml SpectralClut3.xml SpectralClut3.icc
+	iccFromXml SpectralClut4.xml SpectralClut4.icc
+	iccFromXml SpectralClut5.xml SpectralClut5.icc
+	iccFromXml SpectralClut6.xml SpectralClut6.icc
+	iccFromXml SpectralClut7.xml SpectralClut7.icc
+	set -
+fi
+
 echo "====================== ICS =========================="
 
 cd ../ICS
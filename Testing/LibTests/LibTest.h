@@ -0,0 +1,34 @@
+/*
+ * LibTest.h - minimal checks shared by the IccProfLib behavioral tests.
+ *
+ * Each test program is built against the static library by test-lib.sh
+ * and run from the Testing directory.  It prints one line per check and
+ * exits with the number of failed checks.
+ */
+
+#ifndef _LIBTEST_H
+#define _LIBTEST_H
+
+#include <stdio.h>
+
+static int g_nLibTestFailed = 0;
+static int g_nLibTestTotal = 0;
+
+#define LIBTEST_CHECK(cond, desc) \
+  do { \
+    g_nLibTestTotal++; \
+    if (cond) { \
+      printf("  ok   %s\n", desc); \
+    } \
+    else { \
+      printf("  FAIL %s (%s:%d)\n", desc, __FILE__, __LINE__); \
+      g_nLibTestFailed++; \
+    } \
+    fflush(stdout); \
+  } while (0)
+
+#define LIBTEST_RESULT() \
+  (printf("  %d of %d checks passed\n", g_nLibTestTotal - g_nLibTestFailed, g_nLibTestTotal), \
+   g_nLibTestFailed)
+
+#endif //_LIBTEST_H
@@ -0,0 +1,107 @@
+/*
+ * test-arena.cpp - arena allocation of profile objects
+ *
+ *  - profiles read into an arena write the same bytes as heap read ones
+ *  - allocations are only arena objects inside a scope
+ *  - freed storage is reused by later allocations of the same size
+ *  - ReallocBuffer() keeps the contents when a buffer grows
+ *  - objects deleted after the owner released the arena stay valid
+ */
+
+#include <string.h>
+#include "IccProfile.h"
+#include "IccIO.h"
+#include "IccUtil.h"
+#include "LibTest.h"
+
+static bool WriteProfile(const char *szPath, bool bUseArena, CIccMemIO &out)
+{
+  CIccFileIO src;
+  CIccProfile profile;
+
+  if (bUseArena)
+    profile.UseArena();
+
+  if (!src.Open(szPath, "r") || !profile.Read(&src))
+    return false;
+
+  if (!out.Alloc(1024, true))
+    return false;
+  out.SetGrowable();
+
+  return profile.Write(&out, icAlwaysWriteID);
+}
+
+static bool SameProfile(const char *szPath)
+{
+  CIccMemIO heap, arena;
+
+  if (!WriteProfile(szPath, false, heap) || !WriteProfile(szPath, true, arena))
+    return false;
+
+  return heap.GetLength()==arena.GetLength() &&
+         !memcmp(heap.GetData(), arena.GetData(), heap.GetLength());
+}
+
+int main()
+{
+  LIBTEST_CHECK(SameProfile("Display/LCDDisplay.icc"), "LCDDisplay written the same from arena");
+  LIBTEST_CHECK(SameProfile("Calc/srgbCalcTest.icc"), "srgbCalcTest written the same from arena");
+
+  void *pHeap = CIccMemArena::AllocObject(40);
+  LIBTEST_CHECK(pHeap && !CIccMemArena::IsArenaObject(pHeap), "no arena outside a scope");
+  CIccMemArena::FreeObject(pHeap);
+
+  CIccMemArena *pArena = new CIccMemArena();
+  void *pObj, *pBuf, *pReuse, *pKeep;
+
+  {
+    CIccMemArenaScope scope(pArena);
+
+    pObj = CIccMemArena::AllocObject(40);
+    LIBTEST_CHECK(pObj && CIccMemArena::IsArenaObject(pObj), "arena object inside a scope");
+    CIccMemArena::FreeObject(pObj);
+    LIBTEST_CHECK(CIccMemArena::AllocObject(40)==pObj, "freed storage reused");
+
+    void *pBig = CIccMemArena::AllocObject(ICC_ARENA_MAXOBJECT+1);
+    LIBTEST_CHECK(pBig && !CIccMemArena::IsArenaObject(pBig), "large object taken from heap");
+    CIccMemArena::FreeObject(pBig);
+
+    pBuf = CIccMemArena::AllocBuffer(64);
+    memset(pBuf, 0x5a, 64);
+    void *pOld = pBuf;
+    pBuf = CIccMemArena::ReallocBuffer(pBuf, 512);
+
+    bool bKept = pBuf!=NULL;
+    for (int i=0; bKept && i<64; i++) {
+      if (((unsigned char*)pBuf)[i]!=0x5a)
+        bKept = false;
+    }
+    LIBTEST_CHECK(bKept, "ReallocBuffer keeps contents");
+    pReuse = CIccMemArena::AllocBuffer(64);
+    LIBTEST_CHECK(pReuse==pOld, "ReallocBuffer frees old buffer");
+
+    pKeep = CIccMemArena::AllocObject(128);
+    memset(pKeep, 0xa5, 128);
+  }
+
+  size_t nBlocks = pArena->GetBlockCount();
+  LIBTEST_CHECK(nBlocks==1, "allocations share one block");
+
+  //The owner lets go before the last object is deleted
+  pArena->Release();
+
+  bool bValid = true;
+  for (int i=0; i<128; i++) {
+    if (((unsigned char*)pKeep)[i]!=0xa5)
+      bValid = false;
+  }
+  LIBTEST_CHECK(bValid, "object outlives Release");
+
+  CIccMemArena::FreeObject(pKeep);
+  CIccMemArena::FreeObject(pBuf);
+  CIccMemArena::FreeObject(pReuse);
+  CIccMemArena::FreeObject(pObj);
+
+  return LIBTEST_RESULT();
+}
@@ -0,0 +1,120 @@
+/*
+ * test-bpc-cache.cpp - black point cache and profile ID checks
+ *
+ *  - CIccProfile::IsProfileIDValid() leaves the profile unchanged, both for
+ *    lazily loaded and fully read profiles
+ *  - profiles whose ID does not match their contents are not valid
+ *  - black points of profiles with a valid ID are calculated once and shared
+ *    between CMMs, other profiles are not cached
+ */
+
+#include "IccProfile.h"
+#include "IccTag.h"
+#include "IccCmm.h"
+#include "IccApplyBPC.h"
+#include "LibTest.h"
+#include <string.h>
+#include <math.h>
+#include <vector>
+
+static const char *szProfile = "Display/LCDDisplay.icc";
+
+static std::vector<icTag> GetDirectory(const CIccProfile *pProfile)
+{
+  std::vector<icTag> dir;
+  TagEntryList::const_iterator i;
+
+  for (i=pProfile->m_Tags.begin(); i!=pProfile->m_Tags.end(); i++)
+    dir.push_back(i->TagInfo);
+
+  return dir;
+}
+
+static bool SameDirectory(const std::vector<icTag> &a, const std::vector<icTag> &b)
+{
+  return a.size()==b.size() && (a.empty() || !memcmp(&a[0], &b[0], a.size()*sizeof(icTag)));
+}
+
+//Black point compensated relative colorimetric transform of RGB black to Lab
+static bool ApplyBPC(CIccProfile *pProfile, icFloatNumber *pLab)
+{
+  CIccCmm cmm(icSigUnknownData, icSigLabData);
+  CIccCreateXformHintManager hint;
+  icFloatNumber rgb[3] = {0, 0, 0};
+
+  hint.AddHint(new CIccApplyBPCHint());
+
+  if (cmm.AddXform(pProfile, icRelativeColorimetric, icInterpLinear, NULL,
+                   icXformLutColor, true, &hint)!=icCmmStatOk)
+    return false;
+
+  return cmm.Begin()==icCmmStatOk && cmm.Apply(pLab, rgb)==icCmmStatOk;
+}
+
+int main()
+{
+  //Lazily loaded profile with some of its tags loaded
+  CIccProfile *pOpen = OpenIccProfile(szProfile);
+  LIBTEST_CHECK(pOpen!=NULL, "open profile");
+  if (!pOpen)
+    return LIBTEST_RESULT();
+
+  TagEntryList::iterator i;
+  int n = 0;
+  for (i=pOpen->m_Tags.begin(); i!=pOpen->m_Tags.end(); i++, n++) {
+    if (n & 1)
+      pOpen->FindTag(i->TagInfo.sig);
+  }
+
+  std::vector<icTag> dir = GetDirectory(pOpen);
+  icHeader header = pOpen->m_Header;
+
+  LIBTEST_CHECK(pOpen->IsProfileIDValid(), "ID of lazily loaded profile is valid");
+  LIBTEST_CHECK(SameDirectory(dir, GetDirectory(pOpen)), "tag directory unchanged");
+  LIBTEST_CHECK(!memcmp(&header, &pOpen->m_Header, sizeof(header)), "header unchanged");
+
+  bool bLoaded = true;
+  for (i=pOpen->m_Tags.begin(); i!=pOpen->m_Tags.end(); i++) {
+    if (!pOpen->FindTag(i->TagInfo.sig))
+      bLoaded = false;
+  }
+  LIBTEST_CHECK(bLoaded, "remaining tags load after the check");
+  delete pOpen;
+
+  //Fully read profile
+  CIccProfile *pRead = ReadIccProfile(szProfile);
+  LIBTEST_CHECK(pRead!=NULL, "read profile");
+  if (!pRead)
+    return LIBTEST_RESULT();
+
+  dir = GetDirectory(pRead);
+  LIBTEST_CHECK(pRead->IsProfileIDValid(), "ID of read profile is valid");
+  LIBTEST_CHECK(SameDirectory(dir, GetDirectory(pRead)), "tag directory unchanged");
+
+  pRead->m_Header.model ^= 1;
+  LIBTEST_CHECK(!pRead->IsProfileIDValid(), "ID of changed profile is not valid");
+  pRead->m_Header.model ^= 1;
+  LIBTEST_CHECK(pRead->IsProfileIDValid(), "ID valid again after undoing the change");
+
+  //Black point cache
+  CIccBlackPointCache *pCache = CIccBlackPointCache::GetGlobal();
+  icFloatNumber lab1[3], lab2[3], lab3[3];
+
+  pCache->Clear();
+  LIBTEST_CHECK(ApplyBPC(pRead, lab1), "first BPC transform");
+  LIBTEST_CHECK(pCache->GetCount()==1, "black point cached");
+
+  LIBTEST_CHECK(ApplyBPC(OpenIccProfile(szProfile), lab2), "second BPC transform");
+  LIBTEST_CHECK(pCache->GetCount()==1, "cached black point reused");
+  LIBTEST_CHECK(fabs(lab1[0]-lab2[0])<1e-6 && fabs(lab1[1]-lab2[1])<1e-6 &&
+                fabs(lab1[2]-lab2[2])<1e-6, "same result with cached black point");
+
+  CIccProfile *pBad = ReadIccProfile(szProfile);
+  if (pBad)
+    pBad->m_Header.model ^= 1;
+  LIBTEST_CHECK(ApplyBPC(pBad, lab3), "BPC transform of profile with bad ID");
+  LIBTEST_CHECK(pCache->GetCount()==1, "black point of profile with bad ID not cached");
+  LIBTEST_CHECK(fabs(lab1[0]-lab3[0])<1e-6, "same result without cache");
+
+  return LIBTEST_RESULT();
+}
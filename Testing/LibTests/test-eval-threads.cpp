@@ -0,0 +1,72 @@
+/*
+ * test-eval-threads.cpp - threaded profile evaluation
+ *
+ *  - CIccEvalCompare passes the same values to Compare in the same grid
+ *    order with one and with several threads, across several blocks
+ *  - CIccPRMG counts the same delta E statistics with one and with
+ *    several threads
+ */
+
+#include "IccEval.h"
+#include "IccPrmg.h"
+#include "LibTest.h"
+#include <vector>
+
+static const char *szProfile = "Display/LCDDisplay.icc";
+
+#define NUM_THREADS 4
+#define EVAL_GRAN 21  /* 21^3 grid points span more than one block */
+
+class CTestEvalCompare : public CIccEvalCompare
+{
+public:
+  virtual void Compare(icFloatNumber *pPixel, icFloatNumber *deviceLab, icFloatNumber *destLab1, icFloatNumber *destLab2)
+  {
+    m_values.insert(m_values.end(), pPixel, pPixel+3);
+    m_values.insert(m_values.end(), deviceLab, deviceLab+3);
+    m_values.insert(m_values.end(), destLab1, destLab1+3);
+    m_values.insert(m_values.end(), destLab2, destLab2+3);
+  }
+
+  std::vector<icFloatNumber> m_values;
+};
+
+static bool EvalCompare(icUInt32Number nThreads, std::vector<icFloatNumber> &values)
+{
+  CTestEvalCompare eval;
+
+  eval.SetThreads(nThreads);
+  if (eval.EvaluateProfile(szProfile, EVAL_GRAN, icPerceptual)!=icCmmStatOk)
+    return false;
+
+  values = eval.m_values;
+  return !values.empty();
+}
+
+static bool SamePrmg(icUInt32Number nThreads)
+{
+  CIccPRMG serial, threaded;
+
+  threaded.SetThreads(nThreads);
+  if (serial.EvaluateProfile(szProfile, icPerceptual)!=icCmmStatOk ||
+      threaded.EvaluateProfile(szProfile, icPerceptual)!=icCmmStatOk)
+    return false;
+
+  return serial.m_nTotal>0 && serial.m_nTotal==threaded.m_nTotal &&
+         serial.m_nDE1==threaded.m_nDE1 && serial.m_nDE2==threaded.m_nDE2 &&
+         serial.m_nDE3==threaded.m_nDE3 && serial.m_nDE5==threaded.m_nDE5 &&
+         serial.m_nDE10==threaded.m_nDE10 && serial.m_bPrmgImplied==threaded.m_bPrmgImplied;
+}
+
+int main()
+{
+  std::vector<icFloatNumber> serial, threaded;
+
+  LIBTEST_CHECK(EvalCompare(1, serial), "evaluate with one thread");
+  LIBTEST_CHECK(serial.size()==(size_t)EVAL_GRAN*EVAL_GRAN*EVAL_GRAN*12, "every grid point compared");
+  LIBTEST_CHECK(EvalCompare(NUM_THREADS, threaded) && serial==threaded, "same comparisons with several threads");
+
+  LIBTEST_CHECK(SamePrmg(NUM_THREADS), "same PRMG statistics with several threads");
+
+  return LIBTEST_RESULT();
+}
@@ -0,0 +1,184 @@
+/*
+ * test-late-binding.cpp - late binding MPE cache
+ *
+ *  - xforms of CMMs with the same environment variable values share one
+ *    begun MPE in the late binding cache
+ *  - each CMM reads environment variables through its own lookup, also
+ *    after the CMM whose xform added the cache entry is deleted
+ *  - different variable values begin a separate MPE
+ */
+
+#include "IccProfile.h"
+#include "IccTag.h"
+#include "IccTagMPE.h"
+#include "IccMpeCalc.h"
+#include "IccCmm.h"
+#include "LibTest.h"
+#include <math.h>
+
+#define icSigTestVar ((icSigCmmEnvVar)0x74737431)  /* 'tst1' */
+
+//Pass through element that makes the MPE late binding
+class CTestLateElem : public CIccMultiProcessElement
+{
+public:
+  CTestLateElem() { m_nReserved = 0; m_nInputChannels = m_nOutputChannels = 3; }
+
+  virtual CIccMultiProcessElement *NewCopy() const { return new CTestLateElem(*this); }
+  virtual icElemTypeSignature GetType() const { return (icElemTypeSignature)0x74737465; }
+  virtual const icChar *GetClassName() const { return "CTestLateElem"; }
+
+  virtual void Describe(std::string &/*sDescription*/, int /*nVerboseness*/) {}
+
+  virtual bool Read(icUInt32Number /*size*/, CIccIO * /*pIO*/) { return false; }
+  virtual bool Write(CIccIO *pIO)
+  {
+    icElemTypeSignature sig = GetType();
+    return pIO->Write32(&sig) && pIO->Write32(&m_nReserved) &&
+           pIO->Write16(&m_nInputChannels) && pIO->Write16(&m_nOutputChannels);
+  }
+
+  virtual bool Begin(icElemInterp /*nInterp*/, CIccTagMultiProcessElement * /*pMPE*/) { return true; }
+  virtual void Apply(CIccApplyMpe * /*pApply*/, icFloatNumber *pDestPixel, const icFloatNumber *pSrcPixel) const
+  {
+    pDestPixel[0] = pSrcPixel[0];
+    pDestPixel[1] = pSrcPixel[1];
+    pDestPixel[2] = pSrcPixel[2];
+  }
+
+  virtual icValidateStatus Validate(std::string /*sigPath*/, std::string &/*sReport*/,
+                                    const CIccTagMultiProcessElement* /*pMPE*/=NULL,
+                                    const CIccProfile* /*pProfile*/=NULL) const { return icValidateOK; }
+
+  virtual bool IsLateBinding() const { return true; }
+};
+
+//Lists the same variable value for every lookup (so all share a cache key)
+//but returns its own value when the variable is read
+class CTestLookup : public IIccCmmEnvVarLookup
+{
+public:
+  CTestLookup(icFloatNumber fListed, icFloatNumber fRead) : m_fListed(fListed), m_fRead(fRead) {}
+
+  virtual bool GetEnvVar(icSigCmmEnvVar sig, icFloatNumber &val)
+  {
+    val = m_fRead;
+    return sig==icSigTestVar;
+  }
+  virtual bool IndexedEnvVar(icUInt32Number nIndex, icSigCmmEnvVar &sig, icFloatNumber &val)
+  {
+    if (nIndex)
+      return false;
+    sig = icSigTestVar;
+    val = m_fListed;
+    return true;
+  }
+
+protected:
+  icFloatNumber m_fListed, m_fRead;
+};
+
+class CTestLookupHint : public CIccCreateCmmEnvVarXformHint
+{
+public:
+  CTestLookupHint(icFloatNumber fListed, icFloatNumber fRead) : m_fListed(fListed), m_fRead(fRead) {}
+
+  virtual IIccCmmEnvVarLookup *GetNewCmmEnvVarLookup() const { return new CTestLookup(m_fListed, m_fRead); }
+
+protected:
+  icFloatNumber m_fListed, m_fRead;
+};
+
+//RGB display profile whose D2B0 adds the 'tst1' variable to blue
+static CIccProfile *NewProfile()
+{
+  CIccProfile *pProfile = new CIccProfile;
+  pProfile->InitHeader();
+  pProfile->m_Header.version = icVersionNumberV4_3;
+  pProfile->m_Header.deviceClass = icSigDisplayClass;
+  pProfile->m_Header.colorSpace = icSigRgbData;
+  pProfile->m_Header.pcs = icSigXYZData;
+
+  CIccMpeCalculator *pCalc = new CIccMpeCalculator(3, 3);
+  std::string sReport;
+  if (pCalc->SetCalcFunc("{ in(0,3) env(tst1) pop add out(0,3) }", sReport)!=icFuncParseNoError) {
+    delete pCalc;
+    delete pProfile;
+    return NULL;
+  }
+
+  CIccTagMultiProcessElement *pTag = new CIccTagMultiProcessElement(3, 3);
+  pTag->Attach(new CTestLateElem());
+  pTag->Attach(pCalc);
+  pProfile->AttachTag(icSigDToB0Tag, pTag);
+
+  return pProfile;
+}
+
+static CIccCmm *NewCmm(icFloatNumber fListed, icFloatNumber fRead)
+{
+  CIccProfile *pProfile = NewProfile();
+  if (!pProfile)
+    return NULL;
+
+  CIccCmm *pCmm = new CIccCmm(icSigRgbData, icSigXYZData);
+  CIccCreateXformHintManager hint;
+  hint.AddHint(new CTestLookupHint(fListed, fRead));
+
+  if (pCmm->AddXform(pProfile, icPerceptual, icInterpLinear, NULL, icXformLutColor, true, &hint)!=icCmmStatOk) {
+    delete pProfile;
+    delete pCmm;
+    return NULL;
+  }
+  if (pCmm->Begin()!=icCmmStatOk) {
+    delete pCmm;
+    return NULL;
+  }
+
+  return pCmm;
+}
+
+static icFloatNumber ApplyBlue(CIccCmm *pCmm)
+{
+  icFloatNumber src[3] = {0, 0, 0}, dst[3] = {0, 0, 0};
+
+  if (pCmm->Apply(dst, src)!=icCmmStatOk)
+    return -1;
+
+  return dst[2];
+}
+
+int main()
+{
+  CIccLateBindingCache &cache = GetLateBindingCache();
+  cache.Clear();
+
+  CIccCmm *pCmmA = NewCmm(0.1f, 0.1f);
+  CIccCmm *pCmmB = NewCmm(0.1f, 0.2f);
+  LIBTEST_CHECK(pCmmA && pCmmB, "begin CMMs");
+  if (!pCmmA || !pCmmB)
+    return LIBTEST_RESULT();
+
+  LIBTEST_CHECK(cache.GetCount()==1, "same variable values share one cached MPE");
+
+  icFloatNumber fA = ApplyBlue(pCmmA);
+  icFloatNumber fB = ApplyBlue(pCmmB);
+  LIBTEST_CHECK(fA>0 && fB>0, "apply CMMs");
+  LIBTEST_CHECK(fB>fA, "each CMM reads its own lookup");
+
+  delete pCmmA;
+  LIBTEST_CHECK(ApplyBlue(pCmmB)==fB, "lookup of deleted CMM not used");
+
+  CIccCmm *pCmmC = NewCmm(0.3f, 0.3f);
+  LIBTEST_CHECK(pCmmC!=NULL, "begin CMM with other values");
+  if (pCmmC) {
+    LIBTEST_CHECK(cache.GetCount()==2, "other variable values cached separately");
+    LIBTEST_CHECK(ApplyBlue(pCmmC)>fB, "other values applied");
+    delete pCmmC;
+  }
+
+  delete pCmmB;
+  cache.Clear();
+
+  return LIBTEST_RESULT();
+}
@@ -0,0 +1,105 @@
+/*
+ * test-observer-cache.cpp - shared observer and illuminant data
+ *
+ *  - resampled observers are cached once per observer and range and are
+ *    the same whether calculated or found in the cache
+ *  - entries of a different size are not returned
+ *  - the least recently used entries are dropped beyond the maximum
+ *  - a spectral to colorimetric PCS connection applies the same with a
+ *    cleared and a warm cache
+ */
+
+#include "IccProfile.h"
+#include "IccPcc.h"
+#include "IccCmm.h"
+#include "IccUtil.h"
+#include "LibTest.h"
+#include <string.h>
+#include <vector>
+
+static const char *szSrcProfile = "SpecRef/RefIncW.icc";
+static const char *szDstProfile = "Display/Rec2020rgbColorimetric.icc";
+
+#define NUM_SAMPLES 27
+
+static icSpectralRange MakeRange(icFloatNumber start, icFloatNumber end, icUInt16Number steps)
+{
+  icSpectralRange range;
+  range.start = icFtoF16(start);
+  range.end = icFtoF16(end);
+  range.steps = steps;
+  return range;
+}
+
+//Applies reflectance spectra through szSrcProfile and szDstProfile
+static bool ApplyProfiles(std::vector<icFloatNumber> &rgb)
+{
+  CIccProfile *pSrc = OpenIccProfile(szSrcProfile);
+  if (!pSrc)
+    return false;
+
+  CIccCmm cmm(pSrc->m_Header.colorSpace, icSigRgbData, true);
+
+  if (cmm.AddXform(pSrc, icPerceptual)!=icCmmStatOk) {
+    delete pSrc;
+    return false;
+  }
+  if (cmm.AddXform(szDstProfile, icPerceptual)!=icCmmStatOk || cmm.Begin()!=icCmmStatOk)
+    return false;
+
+  icUInt32Number nSrc = cmm.GetSourceSamples();
+  std::vector<icFloatNumber> spec(nSrc);
+
+  rgb.resize(NUM_SAMPLES*3);
+  for (int i=0; i<NUM_SAMPLES; i++) {
+    for (icUInt32Number j=0; j<nSrc; j++)
+      spec[j] = (icFloatNumber)((i*7 + j*3)%NUM_SAMPLES)/NUM_SAMPLES;
+    if (cmm.Apply(&rgb[i*3], &spec[0])!=icCmmStatOk)
+      return false;
+  }
+
+  return true;
+}
+
+int main()
+{
+  CIccSpectralObserverCache cache(2);
+  icSpectralRange obsRange = MakeRange(380, 780, 81);
+  icSpectralRange range = MakeRange(400, 700, 31);
+  std::vector<icFloatNumber> obs(3*81), cold(3*31), warm(3*31, 0);
+  int i;
+
+  for (i=0; i<3*81; i++)
+    obs[i] = (icFloatNumber)((i*37)%101)/100;
+
+  LIBTEST_CHECK(cache.GetObserver(&cold[0], &obs[0], obsRange, range), "observer resampled");
+  LIBTEST_CHECK(cache.GetCount()==1, "resampled observer cached");
+  LIBTEST_CHECK(cache.GetObserver(&warm[0], &obs[0], obsRange, range) && cold==warm && cache.GetCount()==1,
+                "cached observer matches calculated");
+
+  std::string key("O");
+  CIccSpectralObserverCache::AppendKey(key, obsRange, &obs[0], 3);
+  CIccSpectralObserverCache::AppendKey(key, range);
+  LIBTEST_CHECK(!cache.Find(key, &warm[0], 3*30), "entry of different size not returned");
+
+  icFloatNumber a = 1, b = 2;
+  cache.Add("a", &a, 1);
+  cache.Add("b", &b, 1);
+  LIBTEST_CHECK(cache.GetCount()==2 && !cache.Find(key, &warm[0], 3*31) && cache.Find("a", &a, 1),
+                "least recently used entry dropped");
+
+  CIccSpectralObserverCache *pGlobal = CIccSpectralObserverCache::GetGlobal();
+  std::vector<icFloatNumber> rgbCold, rgbWarm;
+
+  pGlobal->Clear();
+  LIBTEST_CHECK(ApplyProfiles(rgbCold), "apply spectral profiles");
+  size_t nEntries = pGlobal->GetCount();
+  LIBTEST_CHECK(nEntries>0, "spectral connection uses observer cache");
+
+  LIBTEST_CHECK(ApplyProfiles(rgbWarm) && rgbCold==rgbWarm, "same results from warm cache");
+  LIBTEST_CHECK(pGlobal->GetCount()==nEntries, "warm cache entries reused");
+
+  pGlobal->Clear();
+
+  return LIBTEST_RESULT();
+}
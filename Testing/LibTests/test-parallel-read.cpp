@@ -0,0 +1,124 @@
+/*
+ * test-parallel-read.cpp - parallel tag decoding in CIccProfile::Read
+ *
+ *  - profiles read with several threads from file and memory IO write the
+ *    same bytes as profiles read serially
+ *  - tags sharing an offset are still shared after a parallel read
+ */
+
+#include "IccProfile.h"
+#include "IccTag.h"
+#include "IccIO.h"
+#include "LibTest.h"
+#include <string.h>
+#include <set>
+
+#define NUM_THREADS 4
+
+static bool WriteProfile(CIccProfile *pProfile, CIccMemIO &io)
+{
+  if (!io.Alloc(1024, true))
+    return false;
+  io.SetGrowable();
+
+  return pProfile->Write(&io, icAlwaysWriteID);
+}
+
+static size_t CountTags(CIccProfile *pProfile)
+{
+  std::set<CIccTag*> tags;
+  TagEntryList::iterator e;
+
+  for (e=pProfile->m_Tags.begin(); e!=pProfile->m_Tags.end(); e++)
+    tags.insert(e->pTag);
+
+  return tags.size();
+}
+
+//Reads szPath with nThreads from a file or from memory
+static CIccProfile *ReadProfile(const char *szPath, icUInt32Number nThreads, bool bMemory)
+{
+  CIccFileIO file;
+  if (!file.Open(szPath, "r"))
+    return NULL;
+
+  CIccProfile *pProfile = new CIccProfile;
+  pProfile->SetReadThreads(nThreads);
+
+  bool bOk;
+  if (bMemory) {
+    CIccMemIO mem;
+    icUInt32Number nSize = file.GetLength();
+    bOk = mem.Alloc(nSize) && file.Read8(mem.GetData(), nSize)==nSize && pProfile->Read(&mem);
+  }
+  else
+    bOk = pProfile->Read(&file);
+
+  if (!bOk) {
+    delete pProfile;
+    return NULL;
+  }
+
+  return pProfile;
+}
+
+static bool SameRead(const char *szPath, bool bMemory)
+{
+  CIccProfile *pSerial = ReadProfile(szPath, 1, bMemory);
+  CIccProfile *pParallel = ReadProfile(szPath, NUM_THREADS, bMemory);
+  CIccMemIO serial, parallel;
+
+  bool bSame = pSerial && pParallel && WriteProfile(pSerial, serial) && WriteProfile(pParallel, parallel) &&
+               serial.GetLength()==parallel.GetLength() &&
+               !memcmp(serial.GetData(), parallel.GetData(), serial.GetLength()) &&
+               CountTags(pSerial)==CountTags(pParallel);
+
+  delete pSerial;
+  delete pParallel;
+  return bSame;
+}
+
+#define icSigTestTag ((icTagSignature)0x74737431)  /* 'tst1' */
+
+//Writes szPath with its first tag also used as a private tag and reads it back in parallel
+static bool SharedTagRead(const char *szPath)
+{
+  CIccProfile *pProfile = ReadIccProfile(szPath);
+  CIccMemIO io;
+
+  bool bOk = pProfile && !pProfile->m_Tags.empty();
+  icTagSignature sig = bOk ? pProfile->m_Tags.begin()->TagInfo.sig : icSigUnknownTag;
+
+  bOk = bOk && pProfile->AttachTag(icSigTestTag, pProfile->FindTag(sig)) && WriteProfile(pProfile, io);
+  delete pProfile;
+  if (!bOk)
+    return false;
+
+  CIccProfile parallel;
+  parallel.SetReadThreads(NUM_THREADS);
+  io.Seek(0, icSeekSet);
+  if (!parallel.Read(&io))
+    return false;
+
+  CIccTag *pTag = parallel.FindTag(sig);
+  return pTag && pTag==parallel.FindTag(icSigTestTag);
+}
+
+int main()
+{
+  const char *szProfiles[] = { "SpecRef/argbRef.icc", "SpecRef/RefIncW.icc",
+                               "CalcTest/calcExercizeOps.icc", "FastPath/SpectralClut7.icc" };
+  int i;
+
+  for (i=0; i<(int)(sizeof(szProfiles)/sizeof(szProfiles[0])); i++) {
+    std::string sDesc = std::string(szProfiles[i]) + " read in parallel from file";
+    LIBTEST_CHECK(SameRead(szProfiles[i], false), sDesc.c_str());
+
+    sDesc = std::string(szProfiles[i]) + " read in parallel from memory";
+    LIBTEST_CHECK(SameRead(szProfiles[i], true), sDesc.c_str());
+  }
+
+  LIBTEST_CHECK(SharedTagRead("SpecRef/argbRef.icc"), "tags sharing an offset shared after parallel read");
+
+  return LIBTEST_RESULT();
+}
@@ -0,0 +1,101 @@
+/*
+ * test-profile-id-cache.cpp - cached profile IDs of profile files
+ *
+ *  - cached IDs match CalcProfileID()
+ *  - an unchanged file (same size and modification time) is not read again
+ *  - a modified file gets a new ID
+ *  - the least recently used entries are dropped beyond the maximum
+ */
+
+#include "IccProfile.h"
+#include "LibTest.h"
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+static const char *szProfile = "Display/LCDDisplay.icc";
+static const char *szTemp = "profile-id-cache.tmp";
+
+static bool CopyFile(const char *szSrc, const char *szDst)
+{
+  FILE *src = fopen(szSrc, "rb");
+  FILE *dst = fopen(szDst, "wb");
+  bool bOk = src && dst;
+  char buf[4096];
+  size_t n;
+
+  while (bOk && (n = fread(buf, 1, sizeof(buf), src)) > 0)
+    bOk = fwrite(buf, 1, n, dst)==n;
+
+  if (src)
+    fclose(src);
+  if (dst)
+    fclose(dst);
+  return bOk;
+}
+
+//Changes one byte of tag data, optionally keeping the modification time
+static bool ModifyFile(const char *szFile, long nPos, bool bKeepTime)
+{
+  struct stat st;
+  if (stat(szFile, &st))
+    return false;
+
+  FILE *f = fopen(szFile, "r+b");
+  if (!f)
+    return false;
+
+  int c;
+  fseek(f, nPos, SEEK_SET);
+  c = fgetc(f);
+  fseek(f, nPos, SEEK_SET);
+  fputc(c ^ 0x55, f);
+  fclose(f);
+
+  if (bKeepTime) {
+    struct timespec times[2] = { st.st_atim, st.st_mtim };
+    return !utimensat(AT_FDCWD, szFile, times, 0);
+  }
+
+  //Make sure the time differs even on file systems with coarse timestamps
+  struct timespec times[2] = { st.st_atim, st.st_mtim };
+  times[1].tv_sec += 1;
+  return !utimensat(AT_FDCWD, szFile, times, 0);
+}
+
+static bool SameID(const icProfileID &a, const icProfileID &b)
+{
+  return !memcmp(&a, &b, sizeof(icProfileID));
+}
+
+int main()
+{
+  CIccProfileIdCache cache(2);
+  icProfileID id, calc, first;
+
+  LIBTEST_CHECK(CopyFile(szProfile, szTemp), "copy profile");
+
+  LIBTEST_CHECK(cache.GetProfileID(szTemp, &first) && CalcProfileID(szTemp, &calc) &&
+                SameID(first, calc), "cached ID matches CalcProfileID");
+  LIBTEST_CHECK(cache.GetCount()==1, "file added to cache");
+
+  //Contents changed behind the cache's back are not noticed
+  LIBTEST_CHECK(ModifyFile(szTemp, 1000, true), "modify file keeping its time");
+  LIBTEST_CHECK(cache.GetProfileID(szTemp, &id) && SameID(id, first), "unchanged file not read again");
+
+  LIBTEST_CHECK(ModifyFile(szTemp, 1001, false), "modify file");
+  LIBTEST_CHECK(cache.GetProfileID(szTemp, &id) && CalcProfileID(szTemp, &calc) &&
+                SameID(id, calc) && !SameID(id, first), "modified file gets new ID");
+  LIBTEST_CHECK(cache.GetCount()==1, "modified file replaces its entry");
+
+  LIBTEST_CHECK(cache.GetProfileID("Named/NamedColor.icc", &id) &&
+                cache.GetProfileID("Display/Rec2020rgbSpectral.icc", &id) &&
+                cache.GetCount()==2, "least recently used entry dropped");
+
+  LIBTEST_CHECK(!cache.GetProfileID("missing-profile.icc", &id), "missing file reported");
+
+  remove(szTemp);
+
+  return LIBTEST_RESULT();
+}
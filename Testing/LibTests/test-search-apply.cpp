@@ -0,0 +1,112 @@
+/*
+ * test-search-apply.cpp - CIccCmmSearch apply paths
+ *
+ *  - batch Apply with several threads gives the single thread results,
+ *    including for a second batch on the kept worker threads
+ *  - in-place Apply (DstPixel==SrcPixel) gives the out of place results, and
+ *    the pixel after an in-place call is not mistaken for a repeat
+ *  - initial grid sizes are limited and a search started from the grid
+ *    finds the same results
+ */
+
+#include "IccCmmSearch.h"
+#include "IccUtil.h"
+#include "LibTest.h"
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+#define NUM_PIXELS 200
+#define TOLERANCE 1.0e-5
+#define GRID_TOLERANCE 1.0e-3
+
+static bool BeginSearch(CIccCmmSearch &cmm, icUInt32Number nThreads)
+{
+  cmm.SetApplyThreads(nThreads);
+
+  //Search Rec. 2020 RGB values for Lab colors
+  return cmm.CIccCmm::AddXform("PCC/Lab_float-D50_2deg.icc", icRelativeColorimetric)==icCmmStatOk &&
+         cmm.CIccCmm::AddXform("Display/Rec2020rgbColorimetric.icc", icRelativeColorimetric)==icCmmStatOk &&
+         cmm.Begin()==icCmmStatOk;
+}
+
+static bool Same(const icFloatNumber *a, const icFloatNumber *b, size_t n, double tolerance=TOLERANCE)
+{
+  for (size_t i=0; i<n; i++) {
+    if (fabs(a[i]-b[i]) > tolerance)
+      return false;
+  }
+  return true;
+}
+
+int main()
+{
+  std::vector<icFloatNumber> src(NUM_PIXELS*3), ref(NUM_PIXELS*3), dst(NUM_PIXELS*3);
+  size_t i;
+
+  //Runs of repeated pixels exercise the repeated pixel shortcut
+  for (i=0; i<NUM_PIXELS; i++) {
+    icUInt32Number n = (icUInt32Number)(i/3);
+    src[i*3]   = 0.2f + (icFloatNumber)((n*37)%61)/100.0f;
+    src[i*3+1] = 0.4f + (icFloatNumber)((n*53)%21)/100.0f;
+    src[i*3+2] = 0.4f + (icFloatNumber)((n*71)%21)/100.0f;
+  }
+
+  CIccCmmSearch cmm1;
+  bool bBegin = BeginSearch(cmm1, 1);
+  LIBTEST_CHECK(bBegin, "begin single thread search");
+  if (!bBegin)
+    return LIBTEST_RESULT();
+
+  bool bOk = true;
+  for (i=0; i<NUM_PIXELS; i++) {
+    if (cmm1.Apply(&ref[i*3], &src[i*3])!=icCmmStatOk)
+      bOk = false;
+  }
+  LIBTEST_CHECK(bOk, "single pixel apply");
+
+  CIccCmmSearch cmm4;
+  LIBTEST_CHECK(BeginSearch(cmm4, 4), "begin four thread search");
+
+  for (int nBatch=0; nBatch<2; nBatch++) {
+    memset(&dst[0], 0, dst.size()*sizeof(icFloatNumber));
+    bOk = cmm4.Apply(&dst[0], &src[0], NUM_PIXELS)==icCmmStatOk;
+    LIBTEST_CHECK(bOk && Same(&dst[0], &ref[0], dst.size()),
+                  nBatch ? "second threaded batch matches" : "threaded batch matches");
+  }
+
+  dst = src;
+  bOk = cmm4.Apply(&dst[0], &dst[0], NUM_PIXELS)==icCmmStatOk;
+  LIBTEST_CHECK(bOk && Same(&dst[0], &ref[0], dst.size()), "in-place threaded batch matches");
+
+  //The result of an in-place call becomes the next source pixel
+  CIccCmmSearch cmmInPlace, cmmFresh;
+  LIBTEST_CHECK(BeginSearch(cmmInPlace, 1) && BeginSearch(cmmFresh, 1), "begin in-place searches");
+
+  icFloatNumber pixel[3] = {0.5f, 0.45f, 0.55f};
+  icFloatNumber next[3], expect[3], first[3];
+
+  cmmFresh.Apply(first, pixel);
+  cmmInPlace.Apply(pixel, pixel);
+  LIBTEST_CHECK(Same(pixel, first, 3), "in-place pixel matches");
+
+  cmmFresh.Apply(expect, first);
+  cmmInPlace.Apply(next, pixel);
+  LIBTEST_CHECK(!Same(first, expect, 3) && Same(next, expect, 3),
+                "pixel equal to an in-place result is searched");
+
+  CIccCmmSearch cmmGrid;
+  cmmGrid.SetInitGridPoints(1);
+  LIBTEST_CHECK(cmmGrid.GetInitGridPoints()==0, "single point grid turned off");
+  cmmGrid.SetInitGridPoints(0x10000);
+  LIBTEST_CHECK(cmmGrid.GetInitGridPoints()==ICC_SEARCH_GRID_MAXPOINTS, "grid points limited");
+
+  cmmGrid.SetInitGridPoints(5);
+  LIBTEST_CHECK(BeginSearch(cmmGrid, 1), "begin grid search");
+
+  memset(&dst[0], 0, dst.size()*sizeof(icFloatNumber));
+  bOk = cmmGrid.Apply(&dst[0], &src[0], NUM_PIXELS)==icCmmStatOk;
+  LIBTEST_CHECK(bOk && Same(&dst[0], &ref[0], dst.size(), GRID_TOLERANCE), "grid search matches");
+
+  return LIBTEST_RESULT();
+}
@@ -0,0 +1,77 @@
+/*
+ * test-segmented-curve.cpp - segmented curve evaluation after Begin()
+ *
+ *  - the segment holding a value is found for curves with ordered break
+ *    points, with and without a dense table
+ *  - curves whose break points are out of order use the first segment
+ *    ending at or after the value, as before Begin() indexed them
+ */
+
+#include "IccMpeBasic.h"
+#include "LibTest.h"
+#include <math.h>
+
+//Segment from start to end with the constant value c
+static CIccCurveSegment *NewConstSegment(icFloatNumber start, icFloatNumber end, icFloatNumber c)
+{
+  CIccFormulaCurveSegment *pSeg = new CIccFormulaCurveSegment(start, end);
+  icFloatNumber params[4] = {1.0f, 0.0f, 0.0f, c};
+
+  pSeg->SetFunction(0, 4, params);
+  return pSeg;
+}
+
+static CIccSegmentedCurve *NewCurve(const icFloatNumber *pBreaks, int nBreaks)
+{
+  CIccSegmentedCurve *pCurve = new CIccSegmentedCurve();
+  icFloatNumber start = icMinFloat32Number;
+  int n;
+
+  for (n=0; n<=nBreaks; n++) {
+    icFloatNumber end = n<nBreaks ? pBreaks[n] : icMaxFloat32Number;
+    pCurve->Insert(NewConstSegment(start, end, (icFloatNumber)(n+1)));
+    start = end;
+  }
+
+  return pCurve;
+}
+
+//Value of the first segment ending at or after v
+static icFloatNumber Expected(const icFloatNumber *pBreaks, int nBreaks, icFloatNumber v)
+{
+  int n;
+  for (n=0; n<nBreaks; n++) {
+    if (v <= pBreaks[n])
+      break;
+  }
+  return (icFloatNumber)(n+1);
+}
+
+static bool CheckCurve(const icFloatNumber *pBreaks, int nBreaks, icUInt32Number nTableSize)
+{
+  CIccSegmentedCurve *pCurve = NewCurve(pBreaks, nBreaks);
+  pCurve->SetTableSize(nTableSize);
+
+  bool bOk = pCurve->Begin(icElemInterpLinear, NULL);
+  for (int i=-20; bOk && i<=120; i++) {
+    icFloatNumber v = (icFloatNumber)i / 100.0f + 0.005f;
+    if (fabs(pCurve->Apply(v) - Expected(pBreaks, nBreaks, v)) > 1.0e-6)
+      bOk = false;
+  }
+
+  delete pCurve;
+  return bOk;
+}
+
+int main()
+{
+  icFloatNumber sorted[] = {0.0f, 0.25f, 0.5f, 0.75f, 1.0f};
+  icFloatNumber unsorted[] = {0.6f, 0.3f, 0.8f};
+
+  LIBTEST_CHECK(CheckCurve(sorted, 5, 0), "ordered break points");
+  LIBTEST_CHECK(CheckCurve(sorted, 5, 256), "ordered break points with table");
+  LIBTEST_CHECK(CheckCurve(unsorted, 3, 0), "break points out of order");
+  LIBTEST_CHECK(CheckCurve(unsorted, 3, 256), "break points out of order with table");
+
+  return LIBTEST_RESULT();
+}
@@ -0,0 +1,88 @@
+/*
+ * test-shared-io.cpp - deferred tag loading through a shared IO
+ *
+ *  - a lazily opened profile and a copy sharing its IO (CopyAttach) can
+ *    load tags from several threads at once
+ *  - the loaded tags match a fully read profile
+ */
+
+#include "IccProfile.h"
+#include "IccTag.h"
+#include "IccIO.h"
+#include "LibTest.h"
+#include <string.h>
+#include <thread>
+#include <vector>
+
+static const char *szProfile = "Display/Rec2020rgbSpectral.icc";
+
+#define NUM_THREADS 4
+#define NUM_PASSES 20
+
+static void LoadTags(CIccProfile *pProfile, std::vector<icTagSignature> sigs, int nStart)
+{
+  size_t i, n = sigs.size();
+
+  for (i=0; i<n; i++)
+    pProfile->FindTag(sigs[(i + nStart) % n]);
+}
+
+static bool WriteProfile(CIccProfile *pProfile, CIccMemIO &io)
+{
+  if (!io.Alloc(1024, true))
+    return false;
+  io.SetGrowable();
+
+  return pProfile->Write(&io, icAlwaysWriteID);
+}
+
+static bool SameProfile(CIccProfile *pProfile, CIccMemIO &ref)
+{
+  CIccMemIO io;
+
+  return WriteProfile(pProfile, io) && io.GetLength()==ref.GetLength() &&
+         !memcmp(io.GetData(), ref.GetData(), ref.GetLength());
+}
+
+int main()
+{
+  CIccProfile *pRead = ReadIccProfile(szProfile);
+  CIccMemIO ref;
+  LIBTEST_CHECK(pRead && WriteProfile(pRead, ref), "read reference profile");
+  if (!pRead)
+    return LIBTEST_RESULT();
+
+  std::vector<icTagSignature> sigs;
+  TagEntryList::iterator e;
+  for (e=pRead->m_Tags.begin(); e!=pRead->m_Tags.end(); e++)
+    sigs.push_back(e->TagInfo.sig);
+  delete pRead;
+
+  bool bSame = true;
+  for (int nPass=0; nPass<NUM_PASSES && bSame; nPass++) {
+    CIccProfile *pOpen = OpenIccProfile(szProfile);
+    if (!pOpen) {
+      bSame = false;
+      break;
+    }
+
+    CIccProfile *pCopy = new CIccProfile(*pOpen);
+    pCopy->CopyAttach(pOpen, true);
+
+    std::vector<std::thread> threads;
+    for (int t=0; t<NUM_THREADS; t++)
+      threads.push_back(std::thread(LoadTags, (t & 1) ? pCopy : pOpen, sigs, t*3));
+    for (size_t t=0; t<threads.size(); t++)
+      threads[t].join();
+
+    if (!SameProfile(pOpen, ref) || !SameProfile(pCopy, ref))
+      bSame = false;
+
+    pCopy->CopyAttach(NULL);
+    delete pCopy;
+    delete pOpen;
+  }
+  LIBTEST_CHECK(bSame, "tags loaded through shared IO match");
+
+  return LIBTEST_RESULT();
+}
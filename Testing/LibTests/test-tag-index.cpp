@@ -0,0 +1,104 @@
+/*
+ * test-tag-index.cpp - indexed tag lookup
+ *
+ *  - FindTag() finds every tag of a read profile
+ *  - AttachTag() and DeleteTag() keep lookups correct
+ *  - copies look up their own tags
+ *  - IndexTags() restores lookups after m_Tags is changed directly
+ */
+
+#include "IccProfile.h"
+#include "IccTag.h"
+#include "LibTest.h"
+
+#define NUM_TAGS 40
+
+static icSignature TestSig(int n)
+{
+  //Attach tags out of signature order
+  return (icSignature)(0x74737400 + (n*17)%NUM_TAGS);
+}
+
+int main()
+{
+  CIccProfile *pRead = ReadIccProfile("Display/LCDDisplay.icc");
+  LIBTEST_CHECK(pRead!=NULL, "read profile");
+  if (!pRead)
+    return LIBTEST_RESULT();
+
+  TagEntryList::iterator i;
+  bool bFound = true;
+  for (i=pRead->m_Tags.begin(); i!=pRead->m_Tags.end(); i++) {
+    if (pRead->FindTag(i->TagInfo.sig)!=i->pTag)
+      bFound = false;
+  }
+  LIBTEST_CHECK(bFound, "every tag of read profile found");
+  LIBTEST_CHECK(!pRead->FindTag(icSigGamutTag), "missing tag not found");
+  delete pRead;
+
+  CIccProfile profile;
+  CIccTag *tags[NUM_TAGS];
+  int n;
+
+  for (n=0; n<NUM_TAGS; n++) {
+    tags[n] = new CIccTagSignature();
+    profile.AttachTag(TestSig(n), tags[n]);
+  }
+
+  bFound = true;
+  for (n=0; n<NUM_TAGS; n++) {
+    if (profile.FindTag(TestSig(n))!=tags[n])
+      bFound = false;
+  }
+  LIBTEST_CHECK(bFound, "attached tags found");
+  LIBTEST_CHECK(!profile.AttachTag(TestSig(3), tags[4]), "duplicate signature rejected");
+  LIBTEST_CHECK(profile.AttachTag(TestSig(3), tags[3]), "reattaching same tag accepted");
+
+  for (n=0; n<NUM_TAGS; n+=2)
+    profile.DeleteTag(TestSig(n));
+
+  bFound = true;
+  for (n=0; n<NUM_TAGS; n++) {
+    if (profile.FindTag(TestSig(n))!=((n & 1) ? tags[n] : NULL))
+      bFound = false;
+  }
+  LIBTEST_CHECK(bFound, "lookups after deleting tags");
+
+  for (n=0; n<NUM_TAGS; n+=2) {
+    tags[n] = new CIccTagSignature();
+    profile.AttachTag(TestSig(n), tags[n]);
+  }
+
+  bFound = true;
+  for (n=0; n<NUM_TAGS; n++) {
+    if (profile.FindTag(TestSig(n))!=tags[n])
+      bFound = false;
+  }
+  LIBTEST_CHECK(bFound, "lookups after reattaching tags");
+
+  CIccProfile copy(profile);
+  bool bOwn = true;
+  for (n=0; n<NUM_TAGS; n++) {
+    CIccTag *pTag = copy.FindTag(TestSig(n));
+    if (!pTag || pTag==tags[n])
+      bOwn = false;
+  }
+  LIBTEST_CHECK(bOwn, "copy finds its own tags");
+
+  //Replace an entry directly, keeping the list size
+  icSignature newSig = (icSignature)0x74737800;
+  for (i=profile.m_Tags.begin(); i!=profile.m_Tags.end(); i++) {
+    if (i->TagInfo.sig==(icTagSignature)TestSig(5))
+      break;
+  }
+  IccTagEntry entry = *i;
+  profile.m_Tags.erase(i);
+  entry.TagInfo.sig = (icTagSignature)newSig;
+  profile.m_Tags.push_back(entry);
+  profile.IndexTags();
+
+  LIBTEST_CHECK(profile.FindTag(newSig)==tags[5], "directly added entry found after IndexTags()");
+  LIBTEST_CHECK(!profile.FindTag(TestSig(5)), "directly removed entry not found after IndexTags()");
+
+  return LIBTEST_RESULT();
+}
@@ -190,7 +190,7 @@ void Usage()
 
   printf("Usage 1: iccApplyNamedCmm -cfg config_file_path\n");
   printf("  Where config_file_path is a json formatted ICC profile application configuration file\n\n");
-  printf("Usage 2: iccApplyNamedCmm {-debugcalc} data_file_path final_data_encoding{:FmtPrecision{:FmtDigits}} interpolation {{-ENV:Name value} profile_file_path Rendering_intent {-PCC connection_conditions_path}}\n\n");
+  printf("Usage 2: iccApplyNamedCmm {-debugcalc} data_file_path final_data_encoding{:FmtPrecision{:FmtDigits}} interpolation {{-ENV:Name value} profile_file_path Rendering_intent {-PCC connection_conditions_path} {-APPROXCAM}}\n\n");
   printf("Built with IccProfLib version " ICCPROFLIBVER "\n");
   
   printf("  For final_data_encoding:\n");
@@ -359,6 +359,9 @@ int main(int argc, const char* argv[])
       Hint.AddHint(new CIccLuminanceMatchingHint());
     }
 
+    if (pProfCfg->m_useApproxCam)
+      Hint.AddHint(new CIccCreateCamApproxXformHint());
+
     if (pProfCfg->m_pccFile.size()) {
       pPccProfile = OpenIccProfile(pProfCfg->m_pccFile.c_str());
       if (!pPccProfile) {
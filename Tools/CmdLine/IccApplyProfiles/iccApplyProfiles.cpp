@@ -96,7 +96,7 @@ void Usage()
 {
   printf("iccApplyProfiles built with IccProfLib version " ICCPROFLIBVER "\n\n");
 
-  printf("Usage: iccApplyProfiles src_tiff_file dst_tiff_file dst_sample_encoding dst_compression dst_planar dst_embed_icc interpolation {{-ENV:sig value} profile_file_path rendering_intent {-PCC connection_conditions_path}}\n\n");
+  printf("Usage: iccApplyProfiles src_tiff_file dst_tiff_file dst_sample_encoding dst_compression dst_planar dst_embed_icc interpolation {{-ENV:sig value} profile_file_path rendering_intent {-PCC connection_conditions_path} {-APPROXCAM}}\n\n");
   printf("  For dst_sample_encoding:\n");
   printf("    0 - Same as src\n");
   printf("    1 - icEncode8Bit\n");
@@ -289,6 +289,9 @@ int main(int argc, const char** argv)
       Hint.AddHint(new CIccLuminanceMatchingHint());
     }
 
+    if (pProfCfg->m_useApproxCam)
+      Hint.AddHint(new CIccCreateCamApproxXformHint());
+
     if (pProfCfg->m_pccFile.size()) {
       pPccProfile = OpenIccProfile(pProfCfg->m_pccFile.c_str());
       if (!pPccProfile) {
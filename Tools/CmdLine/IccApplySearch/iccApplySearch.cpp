@@ -337,6 +337,8 @@ int main(int argc, const char* argv[])
 
     //Adjust type and hint information based on rendering intent
     CIccCreateXformHintManager Hint;
+    if (pProfCfg->m_useApproxCam)
+      Hint.AddHint(new CIccCreateCamApproxXformHint());
 
     if (pProfCfg->m_pccFile.size()) {
       pPccProfile = OpenIccProfile(pProfCfg->m_pccFile.c_str());
@@ -561,6 +561,7 @@ void CIccCfgProfile::reset()
   m_useBPC = false;
   m_useHToS = false;
   m_useV5SubProfile = false;
+  m_useApproxCam = false;
   m_interpolation = icInterpTetrahedral;
 }
 
@@ -649,6 +650,7 @@ bool CIccCfgProfile::fromJson(json j, bool bReset)
   jsonToValue(j["useBPC"], m_useBPC);
   jsonToValue(j["useHToS"], m_useHToS);
   jsonToValue(j["useV5SubProfile"], m_useV5SubProfile);
+  jsonToValue(j["useApproxCam"], m_useApproxCam);
 
   if (jsonToValue(j["transform"], str)) {
     int i;
@@ -697,6 +699,8 @@ void CIccCfgProfile::toJson(json& j) const
     j["useHToS"] = m_useHToS;
   if (m_useV5SubProfile)
     j["useV5SubProfile"] = m_useV5SubProfile;
+  if (m_useApproxCam)
+    j["useApproxCam"] = m_useApproxCam;
   int i;
   for (i = 0; icInterpNames[i]; i++)
     if (icInterpValues[i] == m_interpolation)
@@ -788,6 +792,13 @@ int CIccCfgProfileSequence::fromArgs(const char** args, int nArg, bool bReset)
       nArg -= 2;
       nUsed += 2;
     }
+
+    if (nArg >= 1 && !stricmp(args[0], "-APPROXCAM")) {
+      pProf->m_useApproxCam = true;
+      args++;
+      nArg--;
+      nUsed++;
+    }
     m_profiles.push_back(pProf);
   }
 
@@ -963,6 +974,13 @@ int CIccCfgSearchApply::fromArgs(const char** args, int nArg, bool bReset)
       nArg -= 2;
       nUsed += 2;
     }
+
+    if (nArg >= 1 && !stricmp(args[0], "-APPROXCAM")) {
+      pProf->m_useApproxCam = true;
+      args++;
+      nArg--;
+      nUsed++;
+    }
     m_profiles.push_back(pProf);
   }
 
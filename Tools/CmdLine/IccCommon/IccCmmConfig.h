@@ -122,6 +122,7 @@ public:
 	bool m_useBPC;
 	bool m_useHToS;
 	bool m_useV5SubProfile;
+	bool m_useApproxCam;
 	icXformInterp m_interpolation;
 };
 
@@ -200,6 +200,10 @@ print_usage:
     }
 
     pIcc = OpenIccProfile(argv[nArg]);
+
+    //Tags are loaded as they are dumped and all freed together at exit
+    if (pIcc)
+      pIcc->UseArena();
   }
 
   CIccInfo Fmt;
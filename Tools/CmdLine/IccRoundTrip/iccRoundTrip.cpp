@@ -71,6 +71,7 @@
 
 #include <stdio.h>
 #include <math.h>
+#include <thread>
 #include "IccUtil.h"
 #include "IccEval.h"
 #include "IccPrmg.h"
@@ -165,7 +166,10 @@ int main(int argc, char* argv[])
     }
   }
 
+  icUInt32Number nThreads = std::thread::hardware_concurrency();
+
   CIccMinMaxEval eval;
+  eval.SetThreads(nThreads);
 
   icStatusCMM stat = eval.EvaluateProfile(argv[1], 0, nIntent, icInterpLinear, (nUseMPE!=0));
 
@@ -175,6 +179,7 @@ int main(int argc, char* argv[])
   }
 
   CIccPRMG prmg;
+  prmg.SetThreads(nThreads);
 
   stat = prmg.EvaluateProfile(argv[1], nIntent, icInterpLinear, (nUseMPE!=0));
 
@@ -0,0 +1,180 @@
+#!/bin/bash
+# Fast path regression tests
+# Purpose: Compare the indexed and vectorized code paths of IccProfLib against
+#          reference results made with the original linear / scalar code.
+#
+#  - k-d tree nearest color search of namedColor2 tags (FindCachedPCSColor)
+#  - k-d tree nearest color search of v5 named color arrays (FindPcsColor,
+#    FindSpectralColor)
+#  - wide output CLUT blending (3 to 7 inputs, 31 outputs)
+#  - approximate CIECAM02 kernels (-APPROXCAM) against the exact kernels
+#  - in-place MD5 profile ID calculation against md5sum
+#
+# Test profiles, data and references live in Testing/FastPath.  The profiles
+# are built from the XML files in that directory with iccFromXml.
+#
+# Usage: ./test-fast-paths.sh   (TOOLS=path/to/Build/Tools to override)
+
+set -e
+
+TOOLS="${TOOLS:-./Build/Tools}"
+TOOLS="$(cd "$TOOLS" && pwd)"
+APPLY="$TOOLS/IccApplyNamedCmm/iccApplyNamedCmm"
+DUMP="$TOOLS/IccDumpProfile/iccDumpProfile"
+TEST_DIR="Testing/FastPath"
+REF_DIR="Reference"
+PASS=0
+FAIL=0
+TOTAL=0
+
+# Color codes
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+NC='\033[0m' # No Color
+
+echo "=========================================="
+echo "IccProfLib Fast Path Test Suite"
+echo "Built with: $($APPLY 2>&1 | head -1)"
+echo "=========================================="
+echo ""
+
+cd "$TEST_DIR"
+
+# Compare result data lines, ignoring comments.  Numbers must agree within
+# the tolerance and everything else (color names) must match exactly.
+compare_results() {
+    local result="$1"
+    local reference="$2"
+    local tolerance="$3"
+
+    awk -v tol="$tolerance" '
+        function isnum(s) { return s ~ /^[-+]?[0-9]*\.?[0-9]+([eE][-+]?[0-9]+)?$/ }
+        function data(line) { return line !~ /^[[:space:]]*;/ && line ~ /[^[:space:]]/ }
+        NR==FNR { if (data($0)) ref[++nref] = $0; next }
+        data($0) {
+            if (++nres > nref) { bad++; next }
+            n = split($0, a); m = split(ref[nres], b)
+            if (n != m) { bad++; next }
+            for (i = 1; i <= n; i++) {
+                if (isnum(a[i]) && isnum(b[i])) {
+                    d = a[i] - b[i]; if (d < 0) d = -d
+                    if (d > tol) { bad++; break }
+                }
+                else if (a[i] != b[i]) { bad++; break }
+            }
+        }
+        END { if (nres != nref) bad++; exit bad ? 1 : 0 }
+    ' "$reference" "$result"
+}
+
+# Run iccApplyNamedCmm and compare against a reference result
+run_compare() {
+    local desc="$1"
+    local reference="$2"
+    local tolerance="$3"
+    shift 3
+
+    TOTAL=$((TOTAL + 1))
+    echo -n "[TEST $TOTAL] $desc ... "
+
+    if "$APPLY" "$@" > result.tmp 2>&1 && compare_results result.tmp "$REF_DIR/$reference" "$tolerance"; then
+        echo -e "${GREEN}PASS${NC}"
+        PASS=$((PASS + 1))
+    else
+        echo -e "${RED}FAIL${NC} (differs from $reference)"
+        FAIL=$((FAIL + 1))
+    fi
+    rm -f result.tmp
+}
+
+# MD5 of a profile with the flags, rendering intent and profile ID zeroed
+profile_md5() {
+    local f="$1"
+    {
+        head -c 44 "$f"; head -c 4 /dev/zero
+        tail -c +49 "$f" | head -c 16; head -c 4 /dev/zero
+        tail -c +69 "$f" | head -c 16; head -c 16 /dev/zero
+        tail -c +101 "$f"
+    } | md5sum | cut -d' ' -f1
+}
+
+# Check the profile ID that iccDumpProfile validates against md5sum
+check_profile_id() {
+    local f="$1"
+
+    TOTAL=$((TOTAL + 1))
+    echo -n "[TEST $TOTAL] Profile ID of $f ... "
+
+    local output
+    output=$("$DUMP" -v "$f" 2>&1) || true
+    local id
+    id=$(echo "$output" | grep -m1 "^Profile ID:" | awk '{print $3}')
+
+    if [ "$id" = "$(profile_md5 "$f")" ] && ! echo "$output" | grep -q "Bad Profile ID"; then
+        echo -e "${GREEN}PASS${NC}"
+        PASS=$((PASS + 1))
+    else
+        echo -e "${RED}FAIL${NC} (ID $id)"
+        FAIL=$((FAIL + 1))
+    fi
+}
+
+echo "=== NAMED COLOR SEARCH ==="
+run_compare "namedColor2 Lab search (2000 colors)" LabSearch-NamedColor2Lab.txt 0.0001 \
+    LabSearchTest.txt 0 0 NamedColor2Lab.icc 1
+run_compare "Named color array PCS search" LabSearch-NamedColor.txt 0.0001 \
+    LabSearchTest.txt 0 0 ../Named/NamedColor.icc 3
+run_compare "Named color array spectral search" SpecSearch-NamedColor.txt 0.0001 \
+    SpecSearchTest.txt 0 0 ../Named/NamedColor.icc 3
+
+echo ""
+echo "=== WIDE OUTPUT CLUT ==="
+run_compare "3 input spectral CLUT (trilinear)" SpectralClut3-linear.txt 0.00001 \
+    Clut3Test.txt 3:6 0 SpectralClut3.icc 3
+for n in 3 4 5 6 7; do
+    run_compare "$n input spectral CLUT" SpectralClut$n-tetra.txt 0.00001 \
+        Clut${n}Test.txt 3:6 1 SpectralClut$n.icc 3
+done
+
+echo ""
+echo "=== CAM ELEMENTS ==="
+run_compare "Exact XYZToJab/JabToXYZ" CamAbstract.txt 0.000001 \
+    CamXYZTest.txt 3:6 0 CamAbstract.icc 1
+run_compare "Approximate XYZToJab/JabToXYZ" CamAbstract.txt 0.0001 \
+    CamXYZTest.txt 3:6 0 CamAbstract.icc 1 -APPROXCAM
+
+echo ""
+echo "=== PROFILE ID ==="
+for f in *.icc ../Named/NamedColor.icc ../Display/LCDDisplay.icc ../Display/Rec2020rgbSpectral.icc; do
+    check_profile_id "$f"
+done
+
+TOTAL=$((TOTAL + 1))
+echo -n "[TEST $TOTAL] Bad profile ID is reported ... "
+cp SpectralClut7.icc corrupt.tmp
+printf '\x55' | dd of=corrupt.tmp bs=1 seek=1000 conv=notrunc 2>/dev/null
+if "$DUMP" -v corrupt.tmp 2>&1 | grep -q "Bad Profile ID"; then
+    echo -e "${GREEN}PASS${NC}"
+    PASS=$((PASS + 1))
+else
+    echo -e "${RED}FAIL${NC}"
+    FAIL=$((FAIL + 1))
+fi
+rm -f corrupt.tmp
+
+echo ""
+echo "=========================================="
+echo "Test Results"
+echo "=========================================="
+echo "Total:  $TOTAL"
+echo -e "Passed: ${GREEN}$PASS${NC}"
+echo -e "Failed: ${RED}$FAIL${NC}"
+echo ""
+
+if [ $FAIL -eq 0 ]; then
+    echo -e "${GREEN}All tests passed!${NC}"
+    exit 0
+else
+    echo -e "${RED}Some tests failed.${NC}"
+    exit 1
+fi
@@ -0,0 +1,79 @@
+#!/bin/bash
+# IccProfLib behavioral tests
+# Purpose: Build and run the test programs in Testing/LibTests against the
+#          static IccProfLib library.  They cover library behavior that the
+#          command line tools do not expose, such as the caches shared
+#          between CMMs and the threaded evaluation paths.
+#
+# Each Testing/LibTests/test-*.cpp is a standalone program that is run
+# from the Testing directory and exits with the number of failed checks.
+#
+# Usage: ./test-lib.sh [test-name ...]
+#        (ICCLIB=path/to/libIccProfLib2-static.a and CXX to override)
+
+set -e
+
+ICCLIB="${ICCLIB:-./Build/Cmake/build/IccProfLib/libIccProfLib2-static.a}"
+ICCLIB="$(cd "$(dirname "$ICCLIB")" && pwd)/$(basename "$ICCLIB")"
+CXX="${CXX:-g++}"
+CXXFLAGS="${CXXFLAGS:--std=c++17 -O1 -g}"
+SRC_DIR="$(pwd)/Testing/LibTests"
+OUT_DIR="$(mktemp -d)"
+PASS=0
+FAIL=0
+TOTAL=0
+
+# Color codes
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+NC='\033[0m' # No Color
+
+trap 'rm -rf "$OUT_DIR"' EXIT
+
+echo "=========================================="
+echo "IccProfLib Behavioral Test Suite"
+echo "Library: $ICCLIB"
+echo "=========================================="
+echo ""
+
+if [ $# -gt 0 ]; then
+    TESTS="$*"
+else
+    TESTS=$(cd "$SRC_DIR" && ls test-*.cpp | sed 's/\.cpp$//')
+fi
+
+cd Testing
+
+for t in $TESTS; do
+    TOTAL=$((TOTAL + 1))
+    echo "[TEST $TOTAL] $t"
+
+    if ! "$CXX" $CXXFLAGS -I../IccProfLib -I"$SRC_DIR" "$SRC_DIR/$t.cpp" "$ICCLIB" \
+           -pthread -o "$OUT_DIR/$t"; then
+        echo -e "${RED}FAIL${NC} (build)"
+        FAIL=$((FAIL + 1))
+    elif "$OUT_DIR/$t"; then
+        echo -e "${GREEN}PASS${NC}"
+        PASS=$((PASS + 1))
+    else
+        echo -e "${RED}FAIL${NC}"
+        FAIL=$((FAIL + 1))
+    fi
+    echo ""
+done
+
+echo "=========================================="
+echo "Test Results"
+echo "=========================================="
+echo "Total:  $TOTAL"
+echo -e "Passed: ${GREEN}$PASS${NC}"
+echo -e "Failed: ${RED}$FAIL${NC}"
+echo ""
+
+if [ $FAIL -eq 0 ]; then
+    echo -e "${GREEN}All tests passed!${NC}"
+    exit 0
+else
+    echo -e "${RED}Some tests failed.${NC}"
+    exit 1
+fi